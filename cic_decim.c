@@ -0,0 +1,158 @@
+#include "cic_decim.h"
+#include "its_sample_format.h"
+
+/*
+ * CIC-2 by R = 2^log2r, written with block sums. For block m of R input
+ * samples let S be the sum and U the sum of running sums, i.e. the two
+ * integrators cleared at each block start. The decimated output is
+ *
+ *     y[m] = U[m] + R * S[m-1] - U[m-1]
+ *
+ * which is the triangular CIC-2 response of length 2R - 1. Inputs are
+ * offset to 0..3 (x' = (x + 3) / 2) so that two channels share a 32 bit
+ * word without borrows. U stays below 3 * R * (R + 1) / 2, which limits
+ * R to 128 for 16 bit lanes. Per input byte this costs two table loads
+ * and four adds.
+ */
+
+static uint32_t glCicLut[ 256 ][ 2 ];
+static int glCicLutReady = 0;
+
+static void CyFxCicBuildLut( void )
+{
+	uint32_t b;
+	uint32_t ch;
+	uint32_t v[ ITS_SAMPLE_CHANNELS ];
+
+	for ( b = 0; b < 256; b++ ) {
+		for ( ch = 0; ch < ITS_SAMPLE_CHANNELS; ch++ ) {
+			v[ ch ] = (uint32_t)( ( ITS_SAMPLE_VALUE( ITS_SAMPLE_CODE( b, ch ) ) + 3 ) / 2 );
+		}
+		glCicLut[ b ][ 0 ] = v[ 0 ] | ( v[ 1 ] << 16 );
+		glCicLut[ b ][ 1 ] = v[ 2 ] | ( v[ 3 ] << 16 );
+	}
+	glCicLutReady = 1;
+}
+
+uint8_t CyFxCicShift( uint8_t log2r )
+{
+	/* |y| <= 3 * R^2 < 2^(2 * log2r + 2) */
+	uint8_t bits = (uint8_t)( 2 * log2r + 2 );
+	return ( bits > 15 ) ? (uint8_t)( bits - 15 ) : 0;
+}
+
+int CyFxCicInit( CicDecim_t* cic, uint8_t log2r )
+{
+	int ch;
+
+	if ( log2r < CIC_DECIM_LOG2_MIN || log2r > CIC_DECIM_LOG2_MAX ) {
+		return -1;
+	}
+	if ( !glCicLutReady ) {
+		CyFxCicBuildLut();
+	}
+
+	cic->log2r = log2r;
+	cic->shift = CyFxCicShift( log2r );
+	cic->phase = 0;
+	cic->a[ 0 ] = cic->a[ 1 ] = 0;
+	cic->u[ 0 ] = cic->u[ 1 ] = 0;
+	for ( ch = 0; ch < ITS_SAMPLE_CHANNELS; ch++ ) {
+		/* Empty history reads as x = -3, the first output sample is a
+		 * startup transient. */
+		cic->prevS[ ch ] = 0;
+		cic->prevU[ ch ] = 0;
+	}
+	return 0;
+}
+
+/* End of block: form one output sample and move S, U to history. */
+static uint8_t* CyFxCicEmit( CicDecim_t* cic, uint8_t* out )
+{
+	int32_t s[ ITS_SAMPLE_CHANNELS ];
+	int32_t u[ ITS_SAMPLE_CHANNELS ];
+	int32_t r = 1 << cic->log2r;
+	int32_t bias = 3 << ( 2 * cic->log2r );
+	int32_t y;
+	int ch;
+
+	s[ 0 ] = (int32_t)( cic->a[ 0 ] & 0xFFFF );
+	s[ 1 ] = (int32_t)( cic->a[ 0 ] >> 16 );
+	s[ 2 ] = (int32_t)( cic->a[ 1 ] & 0xFFFF );
+	s[ 3 ] = (int32_t)( cic->a[ 1 ] >> 16 );
+	u[ 0 ] = (int32_t)( cic->u[ 0 ] & 0xFFFF );
+	u[ 1 ] = (int32_t)( cic->u[ 0 ] >> 16 );
+	u[ 2 ] = (int32_t)( cic->u[ 1 ] & 0xFFFF );
+	u[ 3 ] = (int32_t)( cic->u[ 1 ] >> 16 );
+
+	for ( ch = 0; ch < ITS_SAMPLE_CHANNELS; ch++ ) {
+		/* Offset values back to signed: x = 2 * x' - 3, gain R^2 */
+		y = 2 * ( u[ ch ] + r * cic->prevS[ ch ] - cic->prevU[ ch ] ) - bias;
+		y >>= cic->shift;
+		*out++ = (uint8_t)( y & 0xFF );
+		*out++ = (uint8_t)( ( y >> 8 ) & 0xFF );
+		cic->prevS[ ch ] = s[ ch ];
+		cic->prevU[ ch ] = u[ ch ];
+	}
+
+	cic->a[ 0 ] = cic->a[ 1 ] = 0;
+	cic->u[ 0 ] = cic->u[ 1 ] = 0;
+	return out;
+}
+
+uint32_t CyFxCicRun( CicDecim_t* cic, const uint8_t* in, uint32_t len, uint8_t* out )
+{
+	uint8_t* start = out;
+	uint32_t r = 1u << cic->log2r;
+	uint32_t a0 = cic->a[ 0 ];
+	uint32_t a1 = cic->a[ 1 ];
+	uint32_t u0 = cic->u[ 0 ];
+	uint32_t u1 = cic->u[ 1 ];
+	uint32_t phase = cic->phase;
+	uint32_t n;
+	const uint32_t* v;
+
+	while ( len > 0 ) {
+		n = r - phase;
+		if ( n > len ) {
+			n = len;
+		}
+		len -= n;
+		phase += n;
+
+		/* Integrators over the rest of the block. The output is written
+		 * at most 8 bytes per R >= 8 input bytes, behind the reads. */
+		for ( ; n >= 4; n -= 4 ) {
+			v = glCicLut[ in[ 0 ] ];
+			a0 += v[ 0 ]; a1 += v[ 1 ]; u0 += a0; u1 += a1;
+			v = glCicLut[ in[ 1 ] ];
+			a0 += v[ 0 ]; a1 += v[ 1 ]; u0 += a0; u1 += a1;
+			v = glCicLut[ in[ 2 ] ];
+			a0 += v[ 0 ]; a1 += v[ 1 ]; u0 += a0; u1 += a1;
+			v = glCicLut[ in[ 3 ] ];
+			a0 += v[ 0 ]; a1 += v[ 1 ]; u0 += a0; u1 += a1;
+			in += 4;
+		}
+		while ( n-- ) {
+			v = glCicLut[ *in++ ];
+			a0 += v[ 0 ]; a1 += v[ 1 ]; u0 += a0; u1 += a1;
+		}
+
+		if ( phase == r ) {
+			cic->a[ 0 ] = a0;
+			cic->a[ 1 ] = a1;
+			cic->u[ 0 ] = u0;
+			cic->u[ 1 ] = u1;
+			out = CyFxCicEmit( cic, out );
+			a0 = a1 = u0 = u1 = 0;
+			phase = 0;
+		}
+	}
+
+	cic->a[ 0 ] = a0;
+	cic->a[ 1 ] = a1;
+	cic->u[ 0 ] = u0;
+	cic->u[ 1 ] = u1;
+	cic->phase = (uint16_t)phase;
+	return (uint32_t)( out - start );
+}
@@ -0,0 +1,44 @@
+#ifndef CIC_DECIM_H_
+#define CIC_DECIM_H_
+
+#ifdef ITS_HOST_BUILD
+#include <stdint.h>
+#else
+#include <cyu3types.h>
+#endif
+
+/*
+ * Second order CIC decimator for the raw 4 channel stream, by 2^log2r.
+ * Plain C without SDK calls, the host benchmark builds the same file.
+ *
+ * Input is raw bytes, see its_sample_format.h. For every 2^log2r input
+ * bytes one output sample is written: 4 x int16, little endian, channel 0
+ * first. Samples wider than 16 bit are shifted right, see CyFxCicShift.
+ */
+
+#define CIC_DECIM_LOG2_MIN  ( 4 )   /* Output bytes half the input bytes, R = 8 would not reduce */
+#define CIC_DECIM_LOG2_MAX  ( 7 )   /* Limit of the 16 bit lane accumulators */
+#define CIC_DECIM_OUT_BYTES ( 8 )   /* Bytes per output sample */
+
+typedef struct CicDecim_t {
+	uint8_t  log2r;
+	uint8_t  shift;          /* Output right shift to fit int16 */
+	uint16_t phase;          /* Input bytes into the current block */
+	/* Two 16 bit lanes per word: [0] ch0 | ch1 << 16, [1] ch2 | ch3 << 16 */
+	uint32_t a[ 2 ];         /* Running sum of the current block */
+	uint32_t u[ 2 ];         /* Running sum of a[] over the current block */
+	int32_t  prevS[ 4 ];     /* Previous block sum, per channel */
+	int32_t  prevU[ 4 ];
+} CicDecim_t;
+
+/* Returns 0, or -1 if log2r is out of range. */
+int CyFxCicInit( CicDecim_t* cic, uint8_t log2r );
+
+/* Right shift applied to the output of a decimator by 2^log2r. */
+uint8_t CyFxCicShift( uint8_t log2r );
+
+/* Decimate len bytes, returns bytes written. out may be equal to in as
+ * long as every call passes a multiple of 2^log2r bytes. */
+uint32_t CyFxCicRun( CicDecim_t* cic, const uint8_t* in, uint32_t len, uint8_t* out );
+
+#endif /* CIC_DECIM_H_ */
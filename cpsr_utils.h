@@ -0,0 +1,43 @@
+#ifndef CPSR_UTILS_H_
+#define CPSR_UTILS_H_
+
+#include <cyu3types.h>
+
+/*
+ * Helpers to mask IRQ/FIQ on the ARM9 core around short critical sections
+ * that are shared between thread, timer and interrupt context.
+ */
+
+static inline uint32_t read_CPSR(void)
+{
+	register uint32_t cpsr;
+    __asm__ volatile(
+        "MRS %0, CPSR\n\t"
+       : "=r"(cpsr)
+    );
+    return cpsr;
+}
+static inline void write_CPSR(register uint32_t cpsr)
+{
+    __asm__ volatile(
+        "MSR CPSR, %0;"
+		:
+        : "r"(cpsr)
+    );
+}
+
+/* Set I and F bits in Program Status Register, i.e. disable IRQ and FIQ interrupts */
+static inline uint32_t disable_interrupts( void )
+{
+	uint32_t cpsr=read_CPSR();
+	write_CPSR( cpsr | 0xC0 );
+	return cpsr;
+}
+
+/* Restore I and F bits in Program Status Register  */
+static inline void restore_interrupts( register uint32_t cpsr )
+{
+	write_CPSR( (cpsr & 0xC0) | (read_CPSR() & ~0xC0) );
+}
+
+#endif /* CPSR_UTILS_H_ */
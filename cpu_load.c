@@ -0,0 +1,205 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include <cyu3gpio.h>
+
+#include "its_fx3_project_config.h"
+#include "cyfxspi_bb.h"
+#include "cpsr_utils.h"
+#include "cpu_load.h"
+
+/*
+ * CPU load accounting for images built with ITS_FX3_CPU_LOAD.
+ *
+ * The FX3 SDK links a prebuilt ThreadX without execution profiling, and
+ * its scheduler idles in a loop of its own rather than in an idle thread,
+ * so there is no switch hook to time. The load is sampled instead: the
+ * complex GPIO of CPU_LOAD_TIMER interrupts at every wrap and the handler
+ * looks at what it interrupted, like pc_sample.c. No thread running is
+ * the scheduler idle loop, a _tx_thread_system_state above 1 another
+ * interrupt handler, otherwise the running thread is counted.
+ *
+ * Handlers that run with interrupts off are never interrupted, the sample
+ * is taken when they return and would be charged to whatever runs next.
+ * The timer keeps counting from the wrap, so the handler reads how long
+ * its interrupt waited. A wait of more than CPU_LOAD_LATE_US over the
+ * fastest seen counts the sample as late, the interrupt time missed that
+ * way. Shorter handlers and interrupts-off sections stay with the context
+ * they interrupted.
+ *
+ * The counts go into the open window, closed every window of samples into
+ * a ring the host reads. The time of the handler itself from its first to
+ * its last timer read is summed per window, so the host can take out the
+ * cost of the measurement.
+ */
+
+#define CY_FX_CPU_LOAD_CLK_DIV  (2)     /* gpioClock.fastClkDiv in CyFxGpioInit */
+
+/* GPIO53..56 are the pins of the SPI block. Overriding one of them for the
+ * timer takes it from the SPI the front end is set up over. */
+#if defined( ITS_FX3_HAVE_SPI ) && ( CPU_LOAD_TIMER >= 53 ) && ( CPU_LOAD_TIMER <= 56 )
+#error "CPU_LOAD_TIMER is a pin of the SPI block enabled by ITS_FX3_HAVE_SPI"
+#endif
+
+#ifdef ITS_FX3_CPU_LOAD
+/* ThreadX ARM9 port */
+extern volatile uint32_t _tx_thread_system_state;
+extern void* volatile _tx_thread_current_ptr;
+
+static CpuLoadWindow_t glCpuWindows[ CPU_LOAD_WINDOWS ];
+static CpuLoadWindow_t glCpuOpen;
+static void* glCpuThreads[ CPU_LOAD_THREADS ];
+static uint8_t  glCpuThreadCount = 0;
+static uint32_t glCpuSeq = 0;
+static uint32_t glCpuWindowSamples = 0;
+static uint32_t glCpuTickHz = 0;
+static uint32_t glCpuMinTicks = 0;
+static uint32_t glCpuLateTicks = 0;
+static uint16_t glCpuPeriodUs = 0;
+static uint16_t glCpuWindowMs = 0;
+#endif
+
+CyU3PReturnStatus_t CyFxCpuLoadStart( uint16_t periodUs, uint16_t windowMs )
+{
+#ifdef ITS_FX3_CPU_LOAD
+	CyU3PGpioComplexConfig_t gpioConfig;
+	CyU3PReturnStatus_t status;
+	uint32_t sysHz = 0;
+	uint32_t ticks;
+	uint32_t cpsr;
+
+	if ( periodUs != 0 && ( periodUs < CPU_LOAD_MIN_US || windowMs < CPU_LOAD_MIN_WINDOW ||
+			windowMs > CPU_LOAD_MAX_WINDOW || windowMs * 1000ul < periodUs ) )
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	status = CyU3PDeviceGetSysClkFreq( &sysHz );
+	if ( status != CY_U3P_SUCCESS )
+		return status;
+	ticks = ( sysHz / CY_FX_CPU_LOAD_CLK_DIV / 1000000 ) * periodUs;
+
+	status = CyU3PDeviceGpioOverride( CPU_LOAD_TIMER, CyFalse );
+	if ( status != CY_U3P_SUCCESS )
+		return status;
+
+	CyU3PMemSet( (uint8_t*)&gpioConfig, 0, sizeof( gpioConfig ) );
+	gpioConfig.pinMode = CY_U3P_GPIO_MODE_STATIC;
+	gpioConfig.intrMode = CY_U3P_GPIO_NO_INTR;
+	gpioConfig.timerMode = CY_U3P_GPIO_TIMER_SHUTDOWN;
+	status = CyU3PGpioSetComplexConfig( CPU_LOAD_TIMER, &gpioConfig );
+	if ( status != CY_U3P_SUCCESS )
+		return status;
+
+	cpsr = disable_interrupts();
+	CyU3PMemSet( (uint8_t*)glCpuWindows, 0, sizeof( glCpuWindows ) );
+	CyU3PMemSet( (uint8_t*)&glCpuOpen, 0, sizeof( glCpuOpen ) );
+	CyU3PMemSet( (uint8_t*)glCpuThreads, 0, sizeof( glCpuThreads ) );
+	glCpuThreadCount = 0;
+	glCpuSeq = 0;
+	glCpuMinTicks = 0xFFFFFFFF;
+	glCpuPeriodUs = periodUs;
+	if ( periodUs ) {
+		glCpuWindowMs = windowMs;
+		glCpuWindowSamples = windowMs * 1000ul / periodUs;
+		glCpuTickHz = sysHz / CY_FX_CPU_LOAD_CLK_DIV;
+		glCpuLateTicks = ( glCpuTickHz / 1000000 ) * CPU_LOAD_LATE_US;
+	}
+	restore_interrupts( cpsr );
+	if ( periodUs == 0 )
+		return CY_U3P_SUCCESS;
+
+	gpioConfig.intrMode = CY_U3P_GPIO_INTR_TIMER_ZERO;
+	gpioConfig.timerMode = CY_U3P_GPIO_TIMER_HIGH_FREQ;
+	gpioConfig.timer = 0;
+	gpioConfig.period = ticks;
+	gpioConfig.threshold = ticks;
+	return CyU3PGpioSetComplexConfig( CPU_LOAD_TIMER, &gpioConfig );
+#else
+	(void)periodUs;
+	(void)windowMs;
+	return CY_U3P_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+void CyFxCpuLoadIsr( void )
+{
+#ifdef ITS_FX3_CPU_LOAD
+	void* thread = _tx_thread_current_ptr;
+	uint32_t wait = 0, end = 0;
+	uint8_t i;
+
+	/* Timer ticks since the wrap that raised this interrupt */
+	CyU3PGpioComplexSampleNow( CPU_LOAD_TIMER, &wait );
+	if ( wait < glCpuMinTicks )
+		glCpuMinTicks = wait;
+
+	if ( _tx_thread_system_state > 1 ) {
+		glCpuOpen.nested++;
+	} else if ( wait > glCpuMinTicks + glCpuLateTicks ) {
+		glCpuOpen.late++;
+	} else if ( thread == 0 ) {
+		glCpuOpen.idle++;
+	} else {
+		for ( i = 0; i < glCpuThreadCount && glCpuThreads[ i ] != thread; i++ )
+			;
+		if ( i == glCpuThreadCount && glCpuThreadCount < CPU_LOAD_THREADS )
+			glCpuThreads[ glCpuThreadCount++ ] = thread;
+		if ( i < glCpuThreadCount )
+			glCpuOpen.thread[ i ]++;
+		else
+			glCpuOpen.other++;
+	}
+	glCpuOpen.samples++;
+
+	CyU3PGpioComplexSampleNow( CPU_LOAD_TIMER, &end );
+	if ( end > wait )
+		glCpuOpen.self_ticks += end - wait;
+
+	if ( glCpuOpen.samples >= glCpuWindowSamples ) {
+		glCpuOpen.seq = ++glCpuSeq;
+		glCpuOpen.end_ms = CyU3PGetTime();
+		glCpuWindows[ glCpuSeq % CPU_LOAD_WINDOWS ] = glCpuOpen;
+		CyU3PMemSet( (uint8_t*)&glCpuOpen, 0, sizeof( glCpuOpen ) );
+	}
+#endif
+}
+
+void CyFxCpuLoadGetStatus( CpuLoadStatus_t* status )
+{
+#ifdef ITS_FX3_CPU_LOAD
+	void* threads[ CPU_LOAD_THREADS ];
+	uint8_t* name;
+	uint32_t priority, threshold, timeSlice;
+	uint32_t seq;
+	uint32_t cpsr;
+	uint8_t i, j;
+#endif
+
+	CyU3PMemSet( (uint8_t*)status, 0, sizeof( *status ) );
+#ifdef ITS_FX3_CPU_LOAD
+	status->supported = 1;
+
+	cpsr = disable_interrupts();
+	status->running = glCpuPeriodUs ? 1 : 0;
+	status->threads = glCpuThreadCount;
+	status->period_us = glCpuPeriodUs;
+	status->window_ms = glCpuWindowMs;
+	status->tick_hz = glCpuTickHz;
+	status->min_ticks = glCpuMinTicks;
+	status->late_ticks = glCpuLateTicks;
+	for ( i = 0; i < CPU_LOAD_WINDOWS && glCpuSeq > i; i++ ) {
+		seq = glCpuSeq - i;
+		status->window[ i ] = glCpuWindows[ seq % CPU_LOAD_WINDOWS ];
+	}
+	CyU3PMemCopy( (uint8_t*)threads, (uint8_t*)glCpuThreads, sizeof( threads ) );
+	restore_interrupts( cpsr );
+
+	/* A thread deleted since its sample fails the lookup, no name */
+	for ( i = 0; i < status->threads; i++ ) {
+		name = 0;
+		if ( CyU3PThreadInfoGet( (CyU3PThread*)threads[ i ], &name, &priority, &threshold, &timeSlice ) != CY_U3P_SUCCESS ||
+				name == 0 )
+			continue;
+		for ( j = 0; j < CPU_LOAD_NAME_LEN - 1 && name[ j ]; j++ )
+			status->name[ i ][ j ] = (char)name[ j ];
+	}
+#endif
+}
@@ -0,0 +1,17 @@
+#ifndef CPU_LOAD_H_
+#define CPU_LOAD_H_
+
+#include <cyu3types.h>
+#include "host_commands.h"
+
+/* CMD_CPU_LOAD: clear and sample every periodUs, a window every windowMs,
+ * periodUs 0 stops. CY_U3P_ERROR_NOT_SUPPORTED without ITS_FX3_CPU_LOAD. */
+CyU3PReturnStatus_t CyFxCpuLoadStart( uint16_t periodUs, uint16_t windowMs );
+
+/* GPIO interrupt handler for CPU_LOAD_TIMER. Interrupt context. */
+void CyFxCpuLoadIsr( void );
+
+/* CMD_READ_CPU_LOAD. Thread context, looks up the thread names. */
+void CyFxCpuLoadGetStatus( CpuLoadStatus_t* status );
+
+#endif /* CPU_LOAD_H_ */
@@ -0,0 +1,170 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include <cyu3gpio.h>
+
+#include "cyfxspi_bb.h"
+#include "cpsr_utils.h"
+#include "cycle_prof.h"
+
+/*
+ * Region timing for images built with ITS_FX3_PROFILE.
+ *
+ * The complex GPIO of PROF_TIMER runs as a free 32 bit counter on the
+ * GPIO fast clock, system clock / 2 as CyFxGpioInit sets it, about one
+ * tick per CPU cycle. A duration is the counter difference, right across
+ * a wrap as long as a region takes less than about 20 s. Each region keeps
+ * count, min, max, sum and a log2 histogram, updated with interrupts off
+ * since the GPIF callback and the GPIO interrupt may preempt a thread in
+ * a region.
+ *
+ * Reading the counter goes through the SDK and costs more than a few
+ * cycles. The cost of an empty region is measured at init and reported
+ * with every region, the host subtracts it.
+ */
+
+#define CY_FX_PROF_CLK_DIV  (2)     /* gpioClock.fastClkDiv in CyFxGpioInit */
+#define CY_FX_PROF_CALIB    (16)
+
+#ifdef ITS_FX3_PROFILE
+typedef struct CyFxProfStats_t {
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t hist[ PROF_BUCKETS ];
+} CyFxProfStats_t;
+
+static CyFxProfStats_t glProf[ PROF_REGIONS ];
+static uint32_t glProfOverhead = 0;
+static CyBool_t glProfRunning = CyFalse;
+
+static void CyFxProfClear( CyFxProfStats_t* stats )
+{
+	CyU3PMemSet( (uint8_t*)stats, 0, sizeof( *stats ) );
+	stats->min = 0xFFFFFFFF;
+}
+#endif
+
+void CyFxProfInit( void )
+{
+#ifdef ITS_FX3_PROFILE
+	CyU3PGpioComplexConfig_t gpioConfig;
+	CyU3PReturnStatus_t apiRetStatus;
+	uint32_t start, ticks;
+	uint8_t i;
+
+	apiRetStatus = CyU3PDeviceGpioOverride( PROF_TIMER, CyFalse );
+	if ( apiRetStatus != CY_U3P_SUCCESS ) {
+		CyU3PDebugPrint( 4, "PROF_TIMER CyU3PDeviceGpioOverride failed, error code = %d\n", apiRetStatus );
+		return;
+	}
+
+	CyU3PMemSet( (uint8_t*)&gpioConfig, 0, sizeof( gpioConfig ) );
+	gpioConfig.outValue = CyFalse;
+	gpioConfig.driveLowEn = CyFalse;
+	gpioConfig.driveHighEn = CyFalse;
+	gpioConfig.inputEn = CyFalse;
+	gpioConfig.pinMode = CY_U3P_GPIO_MODE_STATIC;
+	gpioConfig.intrMode = CY_U3P_GPIO_NO_INTR;
+	gpioConfig.timerMode = CY_U3P_GPIO_TIMER_HIGH_FREQ;
+	gpioConfig.timer = 0;
+	gpioConfig.period = 0xFFFFFFFF;
+	gpioConfig.threshold = 0xFFFFFFFF;
+	apiRetStatus = CyU3PGpioSetComplexConfig( PROF_TIMER, &gpioConfig );
+	if ( apiRetStatus != CY_U3P_SUCCESS ) {
+		CyU3PDebugPrint( 4, "PROF_TIMER CyU3PGpioSetComplexConfig failed, error code = %d\n", apiRetStatus );
+		return;
+	}
+	glProfRunning = CyTrue;
+
+	for ( i = 0; i < PROF_REGIONS; i++ ) {
+		CyFxProfClear( &glProf[ i ] );
+	}
+
+	/* Shortest of a few, an interrupt may hit one of them */
+	glProfOverhead = 0xFFFFFFFF;
+	for ( i = 0; i < CY_FX_PROF_CALIB; i++ ) {
+		start = CyFxProfNow();
+		ticks = CyFxProfNow() - start;
+		if ( ticks < glProfOverhead )
+			glProfOverhead = ticks;
+	}
+#endif
+}
+
+uint32_t CyFxProfNow( void )
+{
+	uint32_t ticks = 0;
+
+#ifdef ITS_FX3_PROFILE
+	if ( glProfRunning )
+		CyU3PGpioComplexSampleNow( PROF_TIMER, &ticks );
+#endif
+	return ticks;
+}
+
+void CyFxProfRecord( uint8_t region, uint32_t start )
+{
+#ifdef ITS_FX3_PROFILE
+	CyFxProfStats_t* stats;
+	uint32_t ticks = CyFxProfNow() - start;
+	uint32_t cpsr;
+	uint8_t bucket;
+
+	if ( region >= PROF_REGIONS )
+		return;
+	bucket = ticks ? (uint8_t)( 31 - __builtin_clz( ticks ) ) : 0;
+	if ( bucket >= PROF_BUCKETS )
+		bucket = PROF_BUCKETS - 1;
+
+	stats = &glProf[ region ];
+	cpsr = disable_interrupts();
+	stats->count++;
+	stats->sum += ticks;
+	if ( ticks < stats->min )
+		stats->min = ticks;
+	if ( ticks > stats->max )
+		stats->max = ticks;
+	stats->hist[ bucket ]++;
+	restore_interrupts( cpsr );
+#else
+	(void)region;
+	(void)start;
+#endif
+}
+
+void CyFxProfGetRegion( uint8_t region, CyBool_t clear, ProfRegion_t* status )
+{
+#ifdef ITS_FX3_PROFILE
+	uint32_t sysHz = 0;
+	uint32_t cpsr;
+	uint8_t i;
+#endif
+
+	CyU3PMemSet( (uint8_t*)status, 0, sizeof( *status ) );
+	status->region = region;
+#ifdef ITS_FX3_PROFILE
+	status->supported = 1;
+	status->regions = PROF_REGIONS;
+	if ( CyU3PDeviceGetSysClkFreq( &sysHz ) == CY_U3P_SUCCESS )
+		status->tick_hz = sysHz / CY_FX_PROF_CLK_DIV;
+	status->overhead = glProfOverhead;
+	if ( region >= PROF_REGIONS )
+		return;
+
+	cpsr = disable_interrupts();
+	status->count = glProf[ region ].count;
+	status->min = glProf[ region ].count ? glProf[ region ].min : 0;
+	status->max = glProf[ region ].max;
+	status->sum = glProf[ region ].sum;
+	for ( i = 0; i < PROF_BUCKETS; i++ ) {
+		status->hist[ i ] = glProf[ region ].hist[ i ];
+	}
+	if ( clear )
+		CyFxProfClear( &glProf[ region ] );
+	restore_interrupts( cpsr );
+#else
+	(void)clear;
+#endif
+}
@@ -0,0 +1,38 @@
+#ifndef CYCLE_PROF_H_
+#define CYCLE_PROF_H_
+
+#include <cyu3types.h>
+#include "its_fx3_project_config.h"
+#include "host_commands.h"
+
+/*
+ * Profiling hooks. A region is timed from CY_FX_PROF_ENTER to
+ * CY_FX_PROF_EXIT in the same block, ENTER going after the declarations:
+ *
+ *     CY_FX_PROF_ENTER( PROF_REGION_SPI );
+ *     ...
+ *     CY_FX_PROF_EXIT( PROF_REGION_SPI );
+ *
+ * Any context, regions may nest. Without ITS_FX3_PROFILE both are empty.
+ */
+#ifdef ITS_FX3_PROFILE
+#define CY_FX_PROF_ENTER( region )  uint32_t cyFxProf_##region = CyFxProfNow()
+#define CY_FX_PROF_EXIT( region )   CyFxProfRecord( ( region ), cyFxProf_##region )
+#else
+#define CY_FX_PROF_ENTER( region )
+#define CY_FX_PROF_EXIT( region )
+#endif
+
+/* Start the timer. Called from CyFxGpioInit. */
+void CyFxProfInit( void );
+
+/* Timer ticks, wrapping. */
+uint32_t CyFxProfNow( void );
+
+/* Add a duration from start to now to region. */
+void CyFxProfRecord( uint8_t region, uint32_t start );
+
+/* CMD_READ_PROFILE */
+void CyFxProfGetRegion( uint8_t region, CyBool_t clear, ProfRegion_t* status );
+
+#endif /* CYCLE_PROF_H_ */
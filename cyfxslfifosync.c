@@ -43,7 +43,7 @@
    For performance optimizations refer the readme.txt
  */
 
-#define PROJECT_VERSION ( 0x17050700 )
+#define PROJECT_VERSION ( 0x26101900 )
 
 #include "its_fx3_project_config.h"
 
@@ -59,15 +59,36 @@
 #include "cyu3spi.h"
 #include "pib_regs.h"
 #include "cyfxspi_bb.h"
-#include "gpif2_config.h"
+#include "cpsr_utils.h"
+#include "gpif_bus.h"
+#include "gpif_load.h"
+#include "pib_clock.h"
 #include "host_commands.h"
+#include "usb_err_stats.h"
+#include "usb_lpm.h"
+#include "stream_trigger.h"
+#include "pps_latch.h"
+#include "pretrig_capture.h"
+#include "decim_stage.h"
+#include "stream_footer.h"
+#include "stream_flush.h"
+#include "latency_mark.h"
+#include "cycle_prof.h"
+#include "pc_sample.h"
+#include "cpu_load.h"
+#include "cic_decim.h"
+#include "sample_stats.h"
+#include "jam_detect.h"
 
 
 uint8_t glEp0Buffer[32];
 uint16_t glRecvdLen;
 CyU3PThread     bulkSrcSinkAppThread;	 /* Application thread structure */
+CyU3PEvent      glAppEvent;              /* Events processed by the application thread */
+CyU3PMutex      glStreamLock;            /* Serializes GPIF/DMA stream start, stop, arm and recovery */
 CyU3PDmaChannel glChHandleBulkSink;      /* DMA MANUAL_IN channel handle.          */
 CyU3PDmaMultiChannel glChHandleBulkSrc;       /* DMA MANUAL_OUT channel handle.         */
+CyU3PDmaMultiChannelConfig_t glStreamDmaCfg;  /* Stream channel configuration for re-creation */
 
 CyBool_t glIsApplnActive = CyFalse;      /* Whether the source sink application is active or not. */
 CyBool_t glStartAd9269Gpif = CyFalse;
@@ -80,14 +101,35 @@ CyU3PDmaChannel glSpiRxHandle;   /* SPI Rx channel handle */
 typedef struct SystemState_t {
 //	CyBool_t loaded;
 //	CyBool_t started;
-//	CyBool_t streaming;
+	CyBool_t streaming;
+	uint8_t channelMode;        /* CY_FX_STREAM_CHANNEL_*, how the stream channel is set up */
+	uint8_t decimLog2;          /* Decimation of CY_FX_STREAM_CHANNEL_DECIM */
 //	CyBool_t need_start;
 	CyBool_t need_reset;
 //	int32_t overflowCount;
+	uint32_t overflowTime;      /* CyU3PGetTime() of the last GPIF overflow interrupt */
+	uint32_t recoveries;        /* In-place GPIF overflow recoveries done */
+	uint32_t starts;            /* Streams started by the host or the trigger */
+	uint32_t lastRecoveryMs;
+	uint32_t maxRecoveryMs;
+	uint32_t lastConsCount;     /* Last consumer byte count read from the DMA channel */
+	uint32_t lastProdCount;     /* Last sum of the P-port producer socket byte counts */
+	uint64_t consumedBytes;     /* Bytes sent to EP 0x81 since the stream was started */
+	uint64_t producedBytes;     /* Stream offset of the next buffer GPIF fills */
+	uint64_t lastGapOffset;     /* Stream offset of the last discontinuity */
+	uint32_t snapshotState;     /* SNAPSHOT_* */
+	uint32_t snapshotStartTime; /* CyU3PGetTime() when the snapshot was started */
+	uint32_t snapshotMs;        /* Start to last byte taken by the host */
+	uint64_t snapshotLength;
 } SystemState_t;
 
 SystemState_t state;
 
+/* Stream discontinuities for CMD_READ_GAPS, written with the stream lock
+ * held, read by the setup callback. */
+static GapEvent_t glGapRing[GAP_LOG_LEN];
+static uint32_t glGapTotal = 0;
+
 /* Application Error Handler */
 void
 CyFxAppErrorHandler (
@@ -170,6 +212,19 @@ CyFxBulkSrcSinkApplnDebugInit (void)
 CyU3PDmaChannel glChHandleUtoCPU;   /* DMA Channel handle for U2CPU transfer. */
 CyU3PDmaChannelConfig_t dmaCfg1;
 
+/* Only a finite snapshot transfer completes, see CyFxSnapshotStart. */
+static void
+CyFxStreamDmaCb (
+		CyU3PDmaMultiChannel *chHandle,
+		CyU3PDmaCbType_t type,
+		CyU3PDmaCBInput_t *input)
+{
+	if (type == CY_U3P_DMA_CB_XFER_CPLT)
+	{
+		CyU3PEventSet (&glAppEvent, CY_FX_APP_EVT_SNAPSHOT_DONE, CYU3P_EVENT_OR);
+	}
+}
+
 /* This function starts the application. This is called
  * when a SET_CONF event is received from the USB host. The endpoints
  * are configured and the DMA pipe is setup in this function. */
@@ -178,6 +233,7 @@ CyFxBulkSrcSinkApplnStart (
 		void)
 {
 	uint16_t size = 0;
+	uint8_t i;
 	CyU3PEpConfig_t epCfg;
 
 
@@ -249,15 +305,15 @@ CyFxBulkSrcSinkApplnStart (
 			(size * CY_FX_EP_BURST_LENGTH ) : (size);
 	dmaCfg.size  = (size * CY_FX_EP_BURST_LENGTH );
 	dmaCfg.count = CY_FX_BULKSRCSINK_DMA_BUF_COUNT;
-	dmaCfg.validSckCount = 2;
+	dmaCfg.validSckCount = CY_FX_GPIF_THREADS;
 #if 0
 	dmaCfg.prodSckId[0] = CY_FX_EP_PRODUCER_SOCKET;
 	dmaCfg.consSckId[0] = CY_FX_CONSUMER_PPORT_SOCKET;
 	dmaCfg.consSckId[1] = CY_FX_CONSUMER_PPORT_SOCKET;
 #endif
 	dmaCfg.dmaMode = CY_U3P_DMA_MODE_BYTE;
-	dmaCfg.notification = 0;
-	dmaCfg.cb = NULL;
+	dmaCfg.notification = CY_U3P_DMA_CB_XFER_CPLT;
+	dmaCfg.cb = CyFxStreamDmaCb;
 	dmaCfg.prodHeader = 0;
 	dmaCfg.prodFooter = 0;
 	dmaCfg.consHeader = 0;
@@ -280,15 +336,20 @@ CyFxBulkSrcSinkApplnStart (
 	}
 #else
 	/* Create a DMA MANUAL_OUT channel for the consumer socket. */
-	dmaCfg.prodSckId[0] = CY_U3P_PIB_SOCKET_0;
-	dmaCfg.prodSckId[1] = CY_U3P_PIB_SOCKET_1;
+	/* GPIF thread n writes socket n, the channel takes them in turn. */
+	for (i = 0; i < CY_FX_GPIF_THREADS; i++)
+		dmaCfg.prodSckId[i] = (CyU3PDmaSocketId_t)(CY_U3P_PIB_SOCKET_0 + i);
 	dmaCfg.consSckId[0] = CY_FX_EP_CONSUMER_SOCKET;
+	glStreamDmaCfg = dmaCfg;
+	dmaCfg.size = CyFxFlushBufferSize(dmaCfg.size);
 	apiRetStatus = CyU3PDmaMultiChannelCreate (&glChHandleBulkSrc, CY_U3P_DMA_TYPE_AUTO_MANY_TO_ONE, &dmaCfg);
 	if (apiRetStatus != CY_U3P_SUCCESS)
 	{
 		CyU3PDebugPrint (4, "CyU3PDmaChannelCreate failed, Error code = %d\n", apiRetStatus);
 		CyFxAppErrorHandler(apiRetStatus);
 	}
+	state.channelMode = CY_FX_STREAM_CHANNEL_AUTO;
+	CyFxFlushSetChannel(dmaCfg.size);
 
 	/* Set DMA Channel transfer size */
 
@@ -299,8 +360,19 @@ CyFxBulkSrcSinkApplnStart (
 		CyFxAppErrorHandler(apiRetStatus);
 	}
 
+	/* The buffer size follows the USB speed, GPIF has to switch threads
+	 * at the buffer ends for full bursts. */
+	apiRetStatus = CyFxGpifBufferSize (dmaCfg.size - dmaCfg.prodHeader - dmaCfg.prodFooter);
+	if (apiRetStatus != CY_U3P_SUCCESS)
+	{
+		CyU3PDebugPrint (4, "GPIF data counter setup failed, Error code = %d\n", apiRetStatus);
+		CyFxAppErrorHandler(apiRetStatus);
+	}
+
 	/* Flush the endpoint memory */
 		CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+		state.lastConsCount = 0;
+		state.lastProdCount = 0;
 
 #endif
 #endif
@@ -415,6 +487,9 @@ CyFxBulkSrcSinkApplnStop (
 	/* Update the flag so that the application thread is notified of this. */
 	glIsApplnActive = CyFalse;
 
+	/* Nobody reads the stream any more. */
+	CyFxStreamStop();
+
 	/* Disable endpoints. */
 	CyU3PMemSet ((uint8_t *)&epCfg, 0, sizeof (epCfg));
 	epCfg.enable = CyFalse;
@@ -433,7 +508,11 @@ CyFxBulkSrcSinkApplnStop (
 	}
 
 #else
-	CyU3PDmaMultiChannelDestroy (&glChHandleBulkSrc);
+	CyFxDecimStop();
+	CyFxFooterStop();
+	if (state.channelMode != CY_FX_STREAM_CHANNEL_NONE)
+		CyU3PDmaMultiChannelDestroy (&glChHandleBulkSrc);
+	CyFxFlushSetChannel(0);
 	CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
 	/* Consumer endpoint configuration. */
 	apiRetStatus = CyU3PSetEpConfig(CY_FX_EP_CONSUMER, &epCfg);
@@ -445,154 +524,24 @@ CyFxBulkSrcSinkApplnStop (
 #endif
 }
 
-static uint32_t read_CPSR(void)
-{
-	register uint32_t cpsr;
-    __asm__ volatile(
-        "MRS %0, CPSR\n\t"
-       : "=r"(cpsr)
-    );
-    return cpsr;
-}
-static void write_CPSR(register uint32_t cpsr)
-{
-    __asm__ volatile(
-        "MSR CPSR, %0;"
-		:
-        : "r"(cpsr)
-    );
-}
-
-/* Set I and F bits in Program Status Register, i.e. disable IRQ and FIQ interrupts */
-static uint32_t disable_interrupts( void )
-{
-	uint32_t cpsr=read_CPSR();
-	write_CPSR( cpsr | 0xC0 );
-	return cpsr;
-}
+static unsigned int errff = 0;
+static unsigned int ctrlCounter = 0;
 
-/* Restore I and F bits in Program Status Register  */
-static void restore_interrupts( register uint32_t cpsr )
+/* Complete a vendor OUT request whose data stage, if any, is not used. */
+static void CyFxAckVendorOut(uint16_t wLength)
 {
-	write_CPSR( (cpsr & 0xC0) | (read_CPSR() & ~0xC0) );
-}
-
-/*
- * NB! FX3 firmware (at least versions 1.2.2 and 1.2.3 and 1.3.1) clears hardware
- * Error Counter Register periodically in timer interrupt, specifically in
- * CyU3PUibLnkErrClrTimerCb function.
- * Also CyU3PUsbGetErrorCounts implementation itself clears the same hardware
- * register, causing this way concurrency between hardware and software updating
- * the same register. As a result, if both HW and SW update the register
- * concurrently, one of the operations has no effect on content of register.
- *
- * Function below is free of CyU3PUsbGetErrorCounts flaw. Unfortunately its
- * not possible to avoid hardware register clearing in timer interrupt, but
- * assuming that MyU3PUsbGetErrorCounts function is called frequently enough,
- * hopefully still a better accuracy can be achieved.
- *
- * Note 1. MyU3PUsbGetErrorCounts function is not multi-thread safe (as also
- *       CyU3PUsbGetErrorCounts is not).
- */
-static CyU3PReturnStatus_t MyU3PUsbGetErrorCounts(uint16_t *phy_err_cnt, uint16_t *lnk_err_cnt)
-{
-	// This function does not update PHY/LINK errors register.
-	// Instead, it preserves the previous register value and
-	// calculates the changes based on previous and current counter
-	// values.
-	static uint32_t current_value=0; //NB! static variable preserves its value between function calls
-	register uint32_t previous_value;
-	register uint16_t delta;
-
-	if (!phy_err_cnt || !lnk_err_cnt)
-	{
-		return CY_U3P_ERROR_BAD_ARGUMENT;
+	if (wLength == 0) {
+		CyU3PUsbAckSetup();
+		return;
 	}
-
-	// Take the previous register value
-	previous_value=current_value;
-	// Read current PHY/LINK errors register value (address 0xe0033000+20)
-    // bits 16...31 - PHY  errors
-    // bits  0...15 - LINK errors
-	{
-		// CPU and USB state machine are in separate clock domains
-		// and therefore CPU can see any arbitrary value when
-		// USB state machine updates the register at the same moment.
-		// Let's assume that if three read operations return
-        // equal values then it must be correct value - it's
-        // very very unlikely that it's not.
-		register uint32_t r[3];
-		r[0]=*(volatile uint32_t *)(0xe0033000+20);
-		r[1]=*(volatile uint32_t *)(0xe0033000+20);
-		r[2]=*(volatile uint32_t *)(0xe0033000+20);
-		if (r[0]==r[1] && r[0]==r[2])
-		{
-			current_value=r[0];
-		}
-		else
-		{
-			// Three values were not equal.
-			// Let's try to read again but at maximal speed without any possible pauses
-			// between read operations. The assumption is that USB automata does not
-			// increment error counters very frequently and therefore we should see at
-			// least two identical values.
-			register uint32_t m=disable_interrupts();
-			r[0]=*(volatile uint32_t *)(0xe0033000+20);
-			r[1]=*(volatile uint32_t *)(0xe0033000+20);
-			r[2]=*(volatile uint32_t *)(0xe0033000+20);
-			restore_interrupts(m);
-			// Update current value depending on what the two values were identical.
-			// If there are no identical values then let's assume that
-			// "current value" is equal to "previous value" this time - hopefully next
-			// time we will have better luck.
-			if (r[0]==r[1]) current_value=r[0];
-			else if (r[1]==r[2]) current_value=r[1];
-		}
-	}
-	if (CY_U3P_SUPER_SPEED!=CyU3PUsbGetSpeed())
-	{
-		return CY_U3P_ERROR_INVALID_SEQUENCE;
-	}
-
-	// NB! According Cypress technical support information, hardware error counters saturate
-    // at value 0xFFFF (they never turn around to 0). Therefore, FX3 API needs to clear
-	// counters itself periodically (it does this typically in timer interrupt).
-
-	// NB! FX3 API version 1.3.1 clears LNK error counter but does not clear
-	//     PHY error counter in timer interrupt. Therefore we need to clear counters
-	//     ourselves if they have saturated. But as this is dangerous operation (USB
-	//     state machine may also read any arbitrary value while CPU updates register,
-	//     plus, we will lose errors that have appeared between our read and this write)
-	//     then do this only when this is needed indeed.
-	if (((current_value & 0xFFFF0000) == 0xFFFF0000) || ((current_value & 0x0000FFFF) == 0x0000FFFF))
-	{
-		*(volatile uint32_t *)(0xe0033000+20)=0;
-	}
-
-	// Calculate PHY errors increment
-	delta=(uint16_t)(current_value>>16);
-	if ((uint16_t)(previous_value>>16) <= delta)
-	{
-		delta -= (uint16_t)(previous_value>>16);
-	}
-	*phy_err_cnt=delta;
-
-	// Calculate LINK errors increment
-	delta=(uint16_t)(current_value);
-	if ((uint16_t)previous_value <= delta)
-	{
-		delta -= (uint16_t)previous_value;
+	if (wLength > sizeof(glEp0Buffer)) {
+		wLength = sizeof(glEp0Buffer);
 	}
-	*lnk_err_cnt=delta;
-
-	return CY_U3P_SUCCESS;
+	CyU3PUsbGetEP0Data( wLength, glEp0Buffer, NULL );
 }
-
-static unsigned int errff = 0;
-static unsigned int ctrlCounter = 0;
-/* Callback to handle the USB setup requests. */
-CyBool_t
-CyFxBulkSrcSinkApplnUSBSetupCB (
+/* Handle the USB setup requests. */
+static CyBool_t
+CyFxBulkSrcSinkApplnUSBSetup (
 		uint32_t setupdat0, /* SETUP Data 0 */
 		uint32_t setupdat1  /* SETUP Data 1 */
 )
@@ -639,28 +588,345 @@ CyFxBulkSrcSinkApplnUSBSetupCB (
 
 		CyU3PMemSet ((uint8_t *)&glEp0Buffer[0], 0, sizeof (glEp0Buffer));
 		unsigned int* Ep0Buffer = (unsigned int*)&glEp0Buffer[0];
-		static unsigned int glPhyErrs = 0;
-		static unsigned int glLnkErrs = 0;
+		static uint64_t glPhyErrsSeen = 0;
+		static uint64_t glLnkErrsSeen = 0;
+		UsbErrorStats_t errStats;
 		Ep0Buffer[0] = ctrlCounter;
 		ctrlCounter++;
 		Ep0Buffer[1] = errff;
-		uint16_t phyerrs;
-		uint16_t lnkerrs;
-		//CyU3PUsbGetErrorCounts(&phyerrs, &lnkerrs);
-		MyU3PUsbGetErrorCounts(&phyerrs, &lnkerrs);
-		Ep0Buffer[2] = phyerrs;
-		Ep0Buffer[3] = lnkerrs;
+		// Error counters are sampled in background, report the increment since previous request
+		CyFxUsbErrStatsGet(&errStats);
+		Ep0Buffer[2] = (unsigned int)(errStats.phy_total - glPhyErrsSeen);
+		Ep0Buffer[3] = (unsigned int)(errStats.lnk_total - glLnkErrsSeen);
 		Ep0Buffer[4] = *(volatile uint32_t *)(0xe0033000+20);
-		glPhyErrs += phyerrs;
-		Ep0Buffer[5] = glPhyErrs;
-		glLnkErrs += lnkerrs;
-		Ep0Buffer[6] = glLnkErrs;
+		glPhyErrsSeen = errStats.phy_total;
+		Ep0Buffer[5] = (unsigned int)errStats.phy_total;
+		glLnkErrsSeen = errStats.lnk_total;
+		Ep0Buffer[6] = (unsigned int)errStats.lnk_total;
 		Ep0Buffer[7] = 0xDEADBEEF;
 		CyU3PUsbSendEP0Data (wLength, glEp0Buffer);
 		return CyTrue;
 
+	} else if (bRequest == CMD_READ_USB_ERRORS) {
+
+		static UsbErrorStats_t errStats;
+		CyFxUsbErrStatsGet(&errStats);
+		if (wLength > sizeof(errStats)) {
+			wLength = sizeof(errStats);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&errStats);
+		return CyTrue;
+
+	} else if (bRequest == CMD_SET_LPM_POLICY) {
+
+		if ( CyFxLpmSetPolicy( (uint8_t)wValue ) != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_LPM_STATS) {
+
+		static LpmStats_t lpmStats;
+		CyFxLpmGetStats(&lpmStats);
+		if (wLength > sizeof(lpmStats)) {
+			wLength = sizeof(lpmStats);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&lpmStats);
+		return CyTrue;
+
+	} else if (bRequest == CMD_STREAM_START) {
+
+		if ( CyFxStreamStart() != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_STREAM_STOP) {
+
+		CyFxStreamStop();
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_STREAM_ARM) {
+
+		if ( CyFxStreamArm( (uint8_t)wValue ) != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_TRIGGER) {
+
+		static TriggerStatus_t triggerStatus;
+		CyFxTriggerGetStatus( &triggerStatus );
+		if (wLength > sizeof(triggerStatus)) {
+			wLength = sizeof(triggerStatus);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&triggerStatus);
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_PPS) {
+
+		static PpsLog_t ppsLog;
+		CyFxPpsGetLog( &ppsLog );
+		if (wLength > sizeof(ppsLog)) {
+			wLength = sizeof(ppsLog);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&ppsLog);
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_GAPS) {
+
+		static GapLog_t gapLog;
+		CyFxStreamGetGaps( &gapLog );
+		if (wLength > sizeof(gapLog)) {
+			wLength = sizeof(gapLog);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&gapLog);
+		return CyTrue;
+
+	} else if (bRequest == CMD_SNAPSHOT) {
+
+		if ( CyFxSnapshotStart( ((uint32_t)wIndex << 16) | wValue ) != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_SNAPSHOT) {
+
+		static SnapshotStatus_t snapshotStatus;
+		CyU3PMemSet ((uint8_t*)&snapshotStatus, 0, sizeof(snapshotStatus));
+		snapshotStatus.state       = state.snapshotState;
+		snapshotStatus.duration_ms = state.snapshotMs;
+		snapshotStatus.length      = state.snapshotLength;
+		snapshotStatus.sent        = state.consumedBytes;
+		if (wLength > sizeof(snapshotStatus)) {
+			wLength = sizeof(snapshotStatus);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&snapshotStatus);
+		return CyTrue;
+
+	} else if (bRequest == CMD_PRETRIG_ARM) {
+
+		if ( CyFxPretrigStart( wValue, (uint8_t)wIndex ) != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_PRETRIG_FIRE) {
+
+		CyFxPretrigFire();
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_PRETRIG) {
+
+		static PretrigStatus_t pretrigStatus;
+		CyFxPretrigGetStatus( &pretrigStatus );
+		if (wLength > sizeof(pretrigStatus)) {
+			wLength = sizeof(pretrigStatus);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&pretrigStatus);
+		return CyTrue;
+
+	} else if (bRequest == CMD_DECIMATE) {
+
+		if ( CyFxDecimStreamStart( (uint8_t)wValue ) != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_DECIM) {
+
+		static DecimStatus_t decimStatus;
+		CyFxDecimGetStatus( &decimStatus );
+		if (wLength > sizeof(decimStatus)) {
+			wLength = sizeof(decimStatus);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&decimStatus);
+		return CyTrue;
+
+	} else if (bRequest == CMD_FOOTER_STREAM) {
+
+		if ( CyFxFooterStreamStart() != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_FOOTER) {
+
+		static FooterStatus_t footerStatus;
+		CyFxFooterGetStatus( &footerStatus );
+		if (wLength > sizeof(footerStatus)) {
+			wLength = sizeof(footerStatus);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&footerStatus);
+		return CyTrue;
+
+	} else if (bRequest == CMD_FLUSH_DEADLINE) {
+
+		if ( CyFxStreamFlushDeadline( wValue, wIndex ) != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_FLUSH) {
+
+		static FlushStatus_t flushStatus;
+		CyFxFlushGetStatus( &flushStatus );
+		if (wLength > sizeof(flushStatus)) {
+			wLength = sizeof(flushStatus);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&flushStatus);
+		return CyTrue;
+
+	} else if (bRequest == CMD_LATENCY_MARK) {
+
+		static LatencyMark_t latencyMark;
+		if ( CyFxLatencyMark( wValue ? CyTrue : CyFalse, &latencyMark ) != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		if (wLength > sizeof(latencyMark)) {
+			wLength = sizeof(latencyMark);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&latencyMark);
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_PROFILE) {
+
+		static ProfRegion_t profRegion;
+		CyFxProfGetRegion( (uint8_t)wValue, ( wValue & PROF_READ_CLEAR ) ? CyTrue : CyFalse, &profRegion );
+		if (wLength > sizeof(profRegion)) {
+			wLength = sizeof(profRegion);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&profRegion);
+		return CyTrue;
+
+	} else if (bRequest == CMD_PC_SAMPLE) {
+
+		if ( CyFxPcSampleStart( wValue, (uint8_t)wIndex ) != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_PC_SAMPLE) {
+
+		static PcSampleChunk_t pcSampleChunk;
+		CyFxPcSampleGetChunk( wValue, &pcSampleChunk );
+		if (wLength > sizeof(pcSampleChunk)) {
+			wLength = sizeof(pcSampleChunk);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&pcSampleChunk);
+		return CyTrue;
+
+	} else if (bRequest == CMD_CPU_LOAD) {
+
+		if ( CyFxCpuLoadStart( wValue, wIndex ) != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_CPU_LOAD) {
+
+		static CpuLoadStatus_t cpuLoadStatus;
+		CyFxCpuLoadGetStatus( &cpuLoadStatus );
+		if (wLength > sizeof(cpuLoadStatus)) {
+			wLength = sizeof(cpuLoadStatus);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&cpuLoadStatus);
+		return CyTrue;
+
+	} else if (bRequest == CMD_SAMPLE_STATS) {
+
+		CyFxStatsStart( wValue );
+		CyFxAckVendorOut( wLength );
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_STATS) {
+
+		static SampleStats_t sampleStats;
+		CyFxStatsGetStatus( &sampleStats );
+		if (wLength > sizeof(sampleStats)) {
+			wLength = sizeof(sampleStats);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&sampleStats);
+		return CyTrue;
+
+	} else if (bRequest == CMD_JAM_CONFIG) {
+
+		JamConfig_t jamConfig;
+		if ( wLength != sizeof(jamConfig) ) {
+			return CyFalse;
+		}
+		CyU3PUsbGetEP0Data( wLength, glEp0Buffer, NULL );
+		CyU3PMemCopy( (uint8_t*)&jamConfig, glEp0Buffer, sizeof(jamConfig) );
+		if ( !CyFxJamConfigure( &jamConfig ) ) {
+			return CyFalse;
+		}
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_JAM) {
+
+		static JamStatus_t jamStatus;
+		CyFxJamGetStatus( &jamStatus, ( wValue == 1 ) );
+		if (wLength > sizeof(jamStatus)) {
+			wLength = sizeof(jamStatus);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&jamStatus);
+		return CyTrue;
+
+	} else if (bRequest == CMD_PIB_CLOCK) {
+
+		PibClockConfig_t pibConfig;
+		if ( wLength != sizeof(pibConfig) ) {
+			return CyFalse;
+		}
+		CyU3PUsbGetEP0Data( wLength, glEp0Buffer, NULL );
+		CyU3PMemCopy( (uint8_t*)&pibConfig, glEp0Buffer, sizeof(pibConfig) );
+		if ( CyFxPibClockSelect( &pibConfig ) != CY_U3P_SUCCESS ) {
+			return CyFalse;
+		}
+		return CyTrue;
+
+	} else if (bRequest == CMD_READ_PIB_CLOCK) {
+
+		static PibClockStatus_t pibStatus;
+		CyFxPibClockGetStatus( &pibStatus );
+		if (wLength > sizeof(pibStatus)) {
+			wLength = sizeof(pibStatus);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&pibStatus);
+		return CyTrue;
+
+	} else if (bRequest == CMD_GET_STREAM_STATUS) {
+
+		static StreamStatus_t streamStatus;
+		CyU3PMemSet ((uint8_t *)&streamStatus, 0, sizeof (streamStatus));
+		streamStatus.streaming        = state.streaming;
+		streamStatus.overflows        = errff;
+		streamStatus.recoveries       = state.recoveries;
+		streamStatus.last_recovery_ms = state.lastRecoveryMs;
+		streamStatus.max_recovery_ms  = state.maxRecoveryMs;
+		streamStatus.starts           = state.starts;
+		streamStatus.last_gap_offset  = state.lastGapOffset;
+		if (wLength > sizeof(streamStatus)) {
+			wLength = sizeof(streamStatus);
+		}
+		CyU3PUsbSendEP0Data (wLength, (uint8_t*)&streamStatus);
+		return CyTrue;
+
 	} else if (bRequest == CMD_REG_READ) {
 		CyU3PDmaBuffer_t buf_p;
+		CY_FX_PROF_ENTER( PROF_REGION_SPI );
 
 		//CyU3PUsbGetEP0Data (wLength, glEp0Buffer, NULL);
 		glEp0Buffer[0] = wValue; glEp0Buffer[1] = wIndex;
@@ -671,6 +937,7 @@ CyFxBulkSrcSinkApplnUSBSetupCB (
 
 		//CyU3PSpiTransmitWords(glEp0Buffer, 2);
 		CyU3PSpiSetSsnLine (CyTrue);
+		CY_FX_PROF_EXIT( PROF_REGION_SPI );
 
 		CyU3PUsbSendEP0Data (wLength, glEp0Buffer);
 
@@ -682,6 +949,21 @@ CyFxBulkSrcSinkApplnUSBSetupCB (
 	 * application. Hence return CyFalse. */
 	return CyFalse;
 }
+
+/* Callback to handle the USB setup requests. */
+CyBool_t
+CyFxBulkSrcSinkApplnUSBSetupCB (
+		uint32_t setupdat0, /* SETUP Data 0 */
+		uint32_t setupdat1  /* SETUP Data 1 */
+)
+{
+	CyBool_t handled;
+	CY_FX_PROF_ENTER( PROF_REGION_SETUP_CB );
+
+	handled = CyFxBulkSrcSinkApplnUSBSetup (setupdat0, setupdat1);
+	CY_FX_PROF_EXIT( PROF_REGION_SETUP_CB );
+	return handled;
+}
 /* This is a callback function to handle gpif events */
 void
 CyFxBulkSrcSinkApplnGPIFEventCB (
@@ -689,6 +971,7 @@ CyFxBulkSrcSinkApplnGPIFEventCB (
 		uint8_t            currentState         /* Current state of the State Machine. */
 )
 {
+	CY_FX_PROF_ENTER( PROF_REGION_GPIF_CB );
 
 	CyU3PDebugPrint (4, "\n\r !!!!GPIF INTERRUPT\n");
 
@@ -698,6 +981,8 @@ CyFxBulkSrcSinkApplnGPIFEventCB (
 	{
 		CyU3PDebugPrint (4, "\n\r GPIF overflow INT received\n");
 		errff += 1;
+		state.overflowTime = CyU3PGetTime();
+		CyU3PEventSet (&glAppEvent, CY_FX_APP_EVT_GPIF_OVERFLOW, CYU3P_EVENT_OR);
 	}
 	break;
 
@@ -708,6 +993,7 @@ CyFxBulkSrcSinkApplnGPIFEventCB (
 
 
 	}
+	CY_FX_PROF_EXIT( PROF_REGION_GPIF_CB );
 }
 
 /* This is the callback function to handle the USB events. */
@@ -718,6 +1004,7 @@ CyFxBulkSrcSinkApplnUSBEventCB (
 )
 {
 	CyU3PDebugPrint (4, "\n\r USB EVENT\n");
+	CyFxLpmUsbEvent(evtype);
 	switch (evtype)
 	{
 	case CY_U3P_USB_EVENT_SETCONF:
@@ -745,21 +1032,780 @@ CyFxBulkSrcSinkApplnUSBEventCB (
 	}
 }
 
-void CyFxStartAd9269Gpif(void)
+CyU3PReturnStatus_t CyFxStartAd9269Gpif(void)
 {
 	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
 	    /* Start the state machine. */
-	    	apiRetStatus = CyU3PGpifSMStart (RESET, ALPHA_RESET);
+	    	apiRetStatus = CyFxGpifStart ();
 			//apiRetStatus = CyU3PGpifSMStart (START, ALPHA_START);
 	    	if (apiRetStatus != CY_U3P_SUCCESS)
 	    	{
 	    		CyU3PDebugPrint (4, "CyU3PGpifSMStart failed, Error Code = %d\n",apiRetStatus);
 
 	    	}
+	    	else
+	    	{
+	    		state.streaming = CyTrue;
+	    		CyFxLpmSetStreaming(CyTrue);
+	    	}
 
     		CyU3PDebugPrint (4, "CyU3PGpifSMStart Done = %d\n",apiRetStatus);
 
+	return apiRetStatus;
+}
+
+/* Trigger interrupt flavour of CyFxStartAd9269Gpif: no prints, no state. */
+CyU3PReturnStatus_t CyFxGpifSMStartFromIsr(void)
+{
+	return CyFxGpifStart ();
+}
+
+void CyFxStopAd9269Gpif(void)
+{
+	/* A pending trigger must not start the state machine behind our back. */
+	CyFxTriggerDisarm();
+	/* Stop the state machine, configuration stays loaded. */
+	CyU3PGpifDisable (CyFalse);
+	if (state.streaming)
+	{
+		state.streaming = CyFalse;
+		CyFxLpmSetStreaming(CyFalse);
+	}
+}
+
+/* Drop everything queued in the stream pipe and re-arm the DMA channel for
+ * xferSize bytes, CY_FX_BULKSRCSINK_DMA_TX_SIZE for endless streaming. */
+static void CyFxStreamRearmDma(uint32_t xferSize)
+{
+	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+	if (state.channelMode == CY_FX_STREAM_CHANNEL_NONE)
+		return;
+
+	/* The decimator and footer threads must not hold a buffer across the
+	 * reset. */
+	CyFxDecimStop();
+	CyFxFooterStop();
+	CyU3PDmaMultiChannelReset (&glChHandleBulkSrc);
+	CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+	state.lastConsCount = 0;
+	state.lastProdCount = 0;
+
+	apiRetStatus = CyU3PDmaMultiChannelSetXfer (&glChHandleBulkSrc, xferSize, 0);
+	if (apiRetStatus != CY_U3P_SUCCESS)
+	{
+		CyU3PDebugPrint (4, "CyU3PDmaMultiChannelSetXfer failed, Error code = %d\n", apiRetStatus);
+	}
+
+	if (state.channelMode == CY_FX_STREAM_CHANNEL_DECIM)
+		CyFxDecimStart(&glChHandleBulkSrc, state.decimLog2);
+	if (state.channelMode == CY_FX_STREAM_CHANNEL_FOOTER)
+		CyFxFooterStart(&glChHandleBulkSrc, CyFalse);
+}
+
+/* Give up the stream channel and the P-port sockets it owns. Stream lock
+ * held. */
+static void CyFxStreamChannelDestroy(void)
+{
+	CyFxDecimStop();
+	CyFxFooterStop();
+	CyFxFlushSetChannel(0);
+	if (state.channelMode != CY_FX_STREAM_CHANNEL_NONE)
+		CyU3PDmaMultiChannelDestroy (&glChHandleBulkSrc);
+	CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+	state.channelMode = CY_FX_STREAM_CHANNEL_NONE;
+}
+
+/* Re-create the stream channel for plain streaming (AUTO), pre-trigger
+ * capture (MANUAL, CPU holds the buffers, as many buffers as fit), the
+ * decimator (MANUAL, CPU processes every buffer) or check sum footers
+ * (MANUAL, CPU writes the footer of every buffer). A failed MANUAL
+ * channel falls back to AUTO. When that fails too there is no channel,
+ * the error is returned for the request to stall and the next start
+ * tries again. */
+static CyU3PReturnStatus_t CyFxStreamChannelSelect(uint8_t mode)
+{
+	CyU3PDmaMultiChannelConfig_t dmaCfg = glStreamDmaCfg;
+	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+	CyU3PReturnStatus_t status;
+
+	if (state.channelMode == mode)
+		return CY_U3P_SUCCESS;
+
+	CyFxStreamChannelDestroy();
+
+	if (mode != CY_FX_STREAM_CHANNEL_AUTO)
+	{
+		if (mode == CY_FX_STREAM_CHANNEL_PRETRIG)
+		{
+			dmaCfg.count = CY_FX_PRETRIG_DMA_BUF_COUNT;
+			dmaCfg.notification = CY_U3P_DMA_CB_PROD_EVENT | CY_U3P_DMA_CB_CONS_EVENT;
+			dmaCfg.cb = CyFxPretrigDmaCb;
+		}
+		else
+		{
+			if (mode == CY_FX_STREAM_CHANNEL_FOOTER)
+				dmaCfg.prodFooter = STREAM_FOOTER_SIZE;
+			dmaCfg.notification = 0;
+			dmaCfg.cb = NULL;
+		}
+		apiRetStatus = CyU3PDmaMultiChannelCreate (&glChHandleBulkSrc, CY_U3P_DMA_TYPE_MANUAL_MANY_TO_ONE, &dmaCfg);
+		if (apiRetStatus == CY_U3P_SUCCESS)
+		{
+			state.channelMode = mode;
+			return CyFxGpifBufferSize (dmaCfg.size - dmaCfg.prodHeader - dmaCfg.prodFooter);
+		}
+		CyU3PDebugPrint (4, "Manual stream channel create failed, Error code = %d\n", apiRetStatus);
+		dmaCfg = glStreamDmaCfg;
+	}
+
+	/* Streaming channel, also the way back from a failed switch. Its
+	 * buffers fill within the flush deadline. */
+	dmaCfg.size = CyFxFlushBufferSize(dmaCfg.size);
+	status = CyU3PDmaMultiChannelCreate (&glChHandleBulkSrc, CY_U3P_DMA_TYPE_AUTO_MANY_TO_ONE, &dmaCfg);
+	if (status != CY_U3P_SUCCESS)
+	{
+		CyU3PDebugPrint (4, "Stream channel create failed, Error code = %d\n", status);
+		return status;
+	}
+	state.channelMode = CY_FX_STREAM_CHANNEL_AUTO;
+	CyFxGpifBufferSize (dmaCfg.size - dmaCfg.prodHeader - dmaCfg.prodFooter);
+	CyFxFlushSetChannel(dmaCfg.size);
+	return apiRetStatus;
+}
+
+/* Sum of the byte counts of the P-port producer sockets. The counts move
+ * when GPIF commits a full buffer. Register reads only, any context. */
+static uint32_t CyFxStreamProdSocketCount(void)
+{
+	CyU3PDmaSocketConfig_t sck;
+	uint32_t count = 0;
+	uint8_t i;
+
+	for (i = 0; i < CY_FX_GPIF_THREADS; i++)
+	{
+		if (CyU3PDmaSocketGetConfig ((uint16_t)(CY_U3P_PIB_SOCKET_0 + i), &sck) == CY_U3P_SUCCESS)
+			count += sck.xferCount;
+	}
+	return count;
+}
+
+/* Stream byte offset GPIF is writing at, with buffer granularity, and the
+ * number of the stream it belongs to. Callable from interrupt context. */
+CyBool_t CyFxStreamPosition(uint64_t *offset, uint32_t *streamId)
+{
+	*offset = state.producedBytes + (uint32_t)(CyFxStreamProdSocketCount() - state.lastProdCount);
+	*streamId = state.starts;
+	return state.streaming;
+}
+
+/* Accumulate bytes committed to the consumer endpoint into a 64 bit counter.
+ * The DMA count is 32 bit, so this has to run at least every few seconds. */
+static void CyFxStreamUpdateCounters(void)
+{
+	CyU3PDmaState_t dmaState;
+	uint32_t prodCount = 0;
+	uint32_t consCount = 0;
+	uint32_t cpsr;
+
+	if (!glIsApplnActive || state.channelMode == CY_FX_STREAM_CHANNEL_NONE)
+		return;
 
+	if (CyU3PDmaMultiChannelGetStatus (&glChHandleBulkSrc, &dmaState, &prodCount, &consCount, 0) == CY_U3P_SUCCESS)
+	{
+		state.consumedBytes += (uint32_t)(consCount - state.lastConsCount);
+		state.lastConsCount = consCount;
+	}
+
+	/* The PPS interrupt reads the same pair. */
+	cpsr = disable_interrupts();
+	prodCount = CyFxStreamProdSocketCount();
+	state.producedBytes += (uint32_t)(prodCount - state.lastProdCount);
+	state.lastProdCount = prodCount;
+	restore_interrupts(cpsr);
+}
+
+/* Stream offsets restart from zero with every started stream. */
+static void CyFxStreamResetOffsets(void)
+{
+	uint32_t cpsr;
+
+	cpsr = disable_interrupts();
+	state.consumedBytes = 0;
+	state.producedBytes = 0;
+	state.lastGapOffset = 0;
+	restore_interrupts(cpsr);
+}
+
+/* End a snapshot that is no longer wanted. */
+static void CyFxSnapshotCancel(void)
+{
+	if (state.snapshotState == SNAPSHOT_RUNNING)
+		state.snapshotState = SNAPSHOT_ABORTED;
+}
+
+/* Stop GPIF once the snapshot length is in the DMA buffers, the consumer
+ * drains the rest. An overflow before that leaves a gap: fail the snapshot
+ * and drop its data. Stream lock held. */
+static void CyFxSnapshotCheck(CyBool_t overflow)
+{
+	if (!state.streaming)
+		return;
+
+	CyFxStreamUpdateCounters();
+	if (state.producedBytes >= state.snapshotLength)
+	{
+		CyFxStopAd9269Gpif();
+	}
+	else if (overflow)
+	{
+		CyFxStopAd9269Gpif();
+		CyU3PDmaMultiChannelReset (&glChHandleBulkSrc);
+		CyU3PUsbFlushEp(CY_FX_EP_CONSUMER);
+		state.lastGapOffset = state.consumedBytes;
+		state.snapshotState = SNAPSHOT_FAILED;
+	}
+}
+
+/* Log the gap at state.lastGapOffset. Stream lock held. */
+static void CyFxStreamLogGap(uint32_t lostMs)
+{
+	GapEvent_t *ev;
+	uint32_t cpsr;
+
+	cpsr = disable_interrupts();
+	ev = &glGapRing[glGapTotal % GAP_LOG_LEN];
+	ev->offset = state.lastGapOffset;
+	ev->seq = glGapTotal + 1;
+	ev->lost_ms = lostMs;
+	ev->stream = state.starts;
+	ev->reserved = 0;
+	glGapTotal++;
+	restore_interrupts(cpsr);
+}
+
+/* Gap log, oldest first. Any context. */
+void CyFxStreamGetGaps(GapLog_t *log)
+{
+	uint32_t cpsr;
+	uint32_t total;
+	uint32_t count;
+	uint32_t i;
+
+	cpsr = disable_interrupts();
+	total = glGapTotal;
+	count = (total < GAP_LOG_LEN) ? total : GAP_LOG_LEN;
+	for (i = 0; i < count; i++)
+		log->events[i] = glGapRing[(total - count + i) % GAP_LOG_LEN];
+	restore_interrupts(cpsr);
+
+	log->total = total;
+	log->count = count;
+	for (; i < GAP_LOG_LEN; i++)
+		CyU3PMemSet ((uint8_t *)&log->events[i], 0, sizeof (GapEvent_t));
+}
+
+/* Restart GPIF after an overflow without resetting the device. The USB link
+ * stays up, the data lost in between is reported as a discontinuity. */
+static void CyFxRecoverGpifOverflow(void)
+{
+	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+	uint32_t duration;
+	uint32_t cpsr;
+
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (!state.streaming)
+	{
+		CyU3PMutexPut (&glStreamLock);
+		return;
+	}
+
+	/* A snapshot is never restarted, it either has all its data or fails. */
+	if (state.snapshotState == SNAPSHOT_RUNNING)
+	{
+		CyFxSnapshotCheck(CyTrue);
+		CyU3PMutexPut (&glStreamLock);
+		return;
+	}
+
+	/* Pre-trigger capture restarts only while it waits for the trigger. */
+	if (state.channelMode == CY_FX_STREAM_CHANNEL_PRETRIG && !CyFxPretrigOverflow())
+	{
+		CyFxStopAd9269Gpif();
+		CyU3PMutexPut (&glStreamLock);
+		return;
+	}
+
+	/* Stop the state machine, configuration stays loaded. */
+	CyU3PGpifDisable (CyFalse);
+
+	if (glIsApplnActive)
+	{
+		CyFxStreamUpdateCounters();
+		state.lastGapOffset = state.consumedBytes;
+		/* Buffers in flight are dropped with the reset below. */
+		cpsr = disable_interrupts();
+		state.producedBytes = state.consumedBytes;
+		restore_interrupts(cpsr);
+		CyFxStreamRearmDma(CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+	}
+
+	apiRetStatus = CyFxGpifStart ();
+	if (apiRetStatus != CY_U3P_SUCCESS)
+	{
+		CyU3PDebugPrint (4, "CyU3PGpifSMStart failed, Error Code = %d\n",apiRetStatus);
+		CyFxStopAd9269Gpif();
+		CyU3PMutexPut (&glStreamLock);
+		return;
+	}
+
+	duration = CyU3PGetTime() - state.overflowTime;
+	state.recoveries++;
+	state.lastRecoveryMs = duration;
+	if (duration > state.maxRecoveryMs)
+		state.maxRecoveryMs = duration;
+	CyFxStreamLogGap(duration);
+	CyU3PMutexPut (&glStreamLock);
+}
+
+/* Start streaming on host request: flush stale data, arm DMA and start
+ * the state machine, so the first bytes the host reads are fresh samples. */
+CyU3PReturnStatus_t CyFxStreamStart(void)
+{
+	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (!glIsApplnActive)
+	{
+		CyU3PMutexPut (&glStreamLock);
+		return CY_U3P_ERROR_NOT_CONFIGURED;
+	}
+
+	CyFxStopAd9269Gpif();
+	CyFxSnapshotCancel();
+	CyFxPretrigCancel();
+	apiRetStatus = CyFxStreamChannelSelect(CY_FX_STREAM_CHANNEL_AUTO);
+	if (apiRetStatus != CY_U3P_SUCCESS)
+	{
+		CyU3PMutexPut (&glStreamLock);
+		return apiRetStatus;
+	}
+	CyFxStreamRearmDma(CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+	CyFxStreamResetOffsets();
+
+	apiRetStatus = CyFxStartAd9269Gpif();
+	if (apiRetStatus == CY_U3P_SUCCESS)
+		state.starts++;
+	CyU3PMutexPut (&glStreamLock);
+
+	return apiRetStatus;
+}
+
+/* Prepare a stream that the external trigger starts, see stream_trigger.c. */
+CyU3PReturnStatus_t CyFxStreamArm(uint8_t edge)
+{
+	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+	if (edge > TRIGGER_EDGE_FALLING)
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (!glIsApplnActive)
+	{
+		CyU3PMutexPut (&glStreamLock);
+		return CY_U3P_ERROR_NOT_CONFIGURED;
+	}
+
+	CyFxStopAd9269Gpif();
+	CyFxSnapshotCancel();
+	CyFxPretrigCancel();
+	apiRetStatus = CyFxStreamChannelSelect(CY_FX_STREAM_CHANNEL_AUTO);
+	if (apiRetStatus != CY_U3P_SUCCESS)
+	{
+		CyU3PMutexPut (&glStreamLock);
+		return apiRetStatus;
+	}
+	CyFxStreamRearmDma(CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+	CyFxStreamResetOffsets();
+
+	if (edge != TRIGGER_EDGE_NONE)
+		apiRetStatus = CyFxTriggerArm(edge, TRIGGER_ACTION_START);
+	CyU3PMutexPut (&glStreamLock);
+
+	return apiRetStatus;
+}
+
+/* The trigger interrupt has started GPIF, account for it. */
+static void CyFxStreamTriggered(void)
+{
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (CyFxTriggerComplete())
+	{
+		state.streaming = CyTrue;
+		CyFxLpmSetStreaming(CyTrue);
+		state.starts++;
+	}
+	CyU3PMutexPut (&glStreamLock);
+}
+
+/* Stop streaming on host request and drop data not yet read by the host. */
+void CyFxStreamStop(void)
+{
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	CyFxStopAd9269Gpif();
+	CyFxSnapshotCancel();
+	CyFxPretrigCancel();
+	if (glIsApplnActive)
+	{
+		CyFxStreamUpdateCounters();
+		CyFxStreamRearmDma(CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+	}
+	CyU3PMutexPut (&glStreamLock);
+}
+
+/* Capture exactly length bytes and stop. The host reads them from EP 0x81
+ * and polls CMD_READ_SNAPSHOT for the outcome. */
+CyU3PReturnStatus_t CyFxSnapshotStart(uint32_t length)
+{
+	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+	if (length == 0)
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (!glIsApplnActive)
+	{
+		CyU3PMutexPut (&glStreamLock);
+		return CY_U3P_ERROR_NOT_CONFIGURED;
+	}
+
+	CyFxStopAd9269Gpif();
+	CyFxPretrigCancel();
+	apiRetStatus = CyFxStreamChannelSelect(CY_FX_STREAM_CHANNEL_AUTO);
+	if (apiRetStatus != CY_U3P_SUCCESS)
+	{
+		CyU3PMutexPut (&glStreamLock);
+		return apiRetStatus;
+	}
+	CyFxStreamRearmDma(length);
+	CyFxStreamResetOffsets();
+	state.snapshotLength = length;
+	state.snapshotMs = 0;
+	state.snapshotStartTime = CyU3PGetTime();
+	state.snapshotState = SNAPSHOT_RUNNING;
+
+	apiRetStatus = CyFxStartAd9269Gpif();
+	if (apiRetStatus == CY_U3P_SUCCESS)
+		state.starts++;
+	else
+		state.snapshotState = SNAPSHOT_FAILED;
+	CyU3PMutexPut (&glStreamLock);
+
+	return apiRetStatus;
+}
+
+/* The consumer socket has sent the last snapshot byte. */
+static void CyFxSnapshotDone(void)
+{
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (state.snapshotState == SNAPSHOT_RUNNING)
+	{
+		CyFxStopAd9269Gpif();
+		CyFxStreamUpdateCounters();
+		state.snapshotMs = CyU3PGetTime() - state.snapshotStartTime;
+		state.snapshotState = SNAPSHOT_DONE;
+	}
+	CyU3PMutexPut (&glStreamLock);
+}
+
+/* Background part of a running snapshot. */
+static void CyFxSnapshotPoll(void)
+{
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (state.snapshotState == SNAPSHOT_RUNNING)
+		CyFxSnapshotCheck(CyFalse);
+	CyU3PMutexPut (&glStreamLock);
+}
+
+/* Statistics and interference detector only look at plain streaming,
+ * see sample_stats.c and jam_detect.c. */
+static void CyFxMonitorUpdate(void)
+{
+	if (!CyFxStatsActive() && !CyFxJamActive())
+		return;
+
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (state.streaming && state.channelMode == CY_FX_STREAM_CHANNEL_AUTO)
+	{
+		CyFxStatsPoll(CY_FX_EP_CONSUMER_SOCKET);
+		CyFxJamPoll(CY_FX_EP_CONSUMER_SOCKET);
+	}
+	CyU3PMutexPut (&glStreamLock);
+}
+
+/* Run GPIF into a ring of DMA buffers until the trigger, see
+ * pretrig_capture.c. Nothing is sent to USB before that. */
+CyU3PReturnStatus_t CyFxPretrigStart(uint16_t tailBufs, uint8_t edge)
+{
+	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+	if (edge > TRIGGER_EDGE_FALLING)
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (!glIsApplnActive)
+	{
+		CyU3PMutexPut (&glStreamLock);
+		return CY_U3P_ERROR_NOT_CONFIGURED;
+	}
+
+	CyFxStopAd9269Gpif();
+	CyFxSnapshotCancel();
+	CyFxPretrigCancel();
+	apiRetStatus = CyFxStreamChannelSelect(CY_FX_STREAM_CHANNEL_PRETRIG);
+	if (apiRetStatus == CY_U3P_SUCCESS)
+	{
+		CyFxStreamRearmDma(CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+		CyFxStreamResetOffsets();
+		apiRetStatus = CyFxPretrigPrepare(&glChHandleBulkSrc, tailBufs,
+				glStreamDmaCfg.size, CY_FX_PRETRIG_DMA_BUF_COUNT * CY_FX_GPIF_THREADS);
+	}
+	if (apiRetStatus == CY_U3P_SUCCESS && edge != TRIGGER_EDGE_NONE)
+		apiRetStatus = CyFxTriggerArm(edge, TRIGGER_ACTION_FIRE);
+	if (apiRetStatus == CY_U3P_SUCCESS)
+		apiRetStatus = CyFxStartAd9269Gpif();
+
+	if (apiRetStatus == CY_U3P_SUCCESS)
+	{
+		state.starts++;
+	}
+	else
+	{
+		CyFxTriggerDisarm();
+		CyFxPretrigCancel();
+	}
+	CyU3PMutexPut (&glStreamLock);
+
+	return apiRetStatus;
+}
+
+/* Stream through the CIC decimator, see decim_stage.c. */
+CyU3PReturnStatus_t CyFxDecimStreamStart(uint8_t log2r)
+{
+	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+	if (log2r < CIC_DECIM_LOG2_MIN || log2r > CIC_DECIM_LOG2_MAX)
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (!glIsApplnActive)
+	{
+		CyU3PMutexPut (&glStreamLock);
+		return CY_U3P_ERROR_NOT_CONFIGURED;
+	}
+
+	CyFxStopAd9269Gpif();
+	CyFxSnapshotCancel();
+	CyFxPretrigCancel();
+	apiRetStatus = CyFxStreamChannelSelect(CY_FX_STREAM_CHANNEL_DECIM);
+	if (apiRetStatus == CY_U3P_SUCCESS)
+	{
+		state.decimLog2 = log2r;
+		CyFxStreamRearmDma(CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+		CyFxStreamResetOffsets();
+		apiRetStatus = CyFxStartAd9269Gpif();
+		if (apiRetStatus == CY_U3P_SUCCESS)
+			state.starts++;
+	}
+	CyU3PMutexPut (&glStreamLock);
+
+	return apiRetStatus;
+}
+
+/* Start streaming with check sum footers, see stream_footer.c. */
+CyU3PReturnStatus_t CyFxFooterStreamStart(void)
+{
+	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (!glIsApplnActive)
+	{
+		CyU3PMutexPut (&glStreamLock);
+		return CY_U3P_ERROR_NOT_CONFIGURED;
+	}
+
+	CyFxStopAd9269Gpif();
+	CyFxSnapshotCancel();
+	CyFxPretrigCancel();
+	apiRetStatus = CyFxStreamChannelSelect(CY_FX_STREAM_CHANNEL_FOOTER);
+	if (apiRetStatus == CY_U3P_SUCCESS)
+	{
+		CyFxStreamRearmDma(CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+		CyFxStreamResetOffsets();
+		CyFxFooterStart(&glChHandleBulkSrc, CyTrue);
+		apiRetStatus = CyFxStartAd9269Gpif();
+		if (apiRetStatus == CY_U3P_SUCCESS)
+			state.starts++;
+	}
+	CyU3PMutexPut (&glStreamLock);
+
+	return apiRetStatus;
+}
+
+/* Stop GPIF for a change of its configuration or clock. Returns whether a
+ * plain or decimated stream was running and is to be resumed. Snapshots
+ * and pre-trigger captures are cancelled. Stream lock held. */
+static CyBool_t CyFxStreamPause(void)
+{
+	CyBool_t resume;
+
+	resume = state.streaming && state.snapshotState != SNAPSHOT_RUNNING &&
+			state.channelMode != CY_FX_STREAM_CHANNEL_PRETRIG;
+	CyFxStopAd9269Gpif();
+	CyFxSnapshotCancel();
+	CyFxPretrigCancel();
+	return resume;
+}
+
+/* Restart a stream paused since pauseStart, the data lost in between is
+ * reported like an overflow recovery. Stream lock held. */
+static void CyFxStreamResume(CyBool_t resume, uint32_t pauseStart)
+{
+	uint32_t cpsr;
+
+	if (!resume || !glIsApplnActive || state.channelMode == CY_FX_STREAM_CHANNEL_NONE)
+		return;
+
+	CyFxStreamUpdateCounters();
+	state.lastGapOffset = state.consumedBytes;
+	cpsr = disable_interrupts();
+	state.producedBytes = state.consumedBytes;
+	restore_interrupts(cpsr);
+	CyFxStreamRearmDma(CY_FX_BULKSRCSINK_DMA_TX_SIZE);
+	if (CyFxStartAd9269Gpif() == CY_U3P_SUCCESS)
+	{
+		state.recoveries++;
+		CyFxStreamLogGap(CyU3PGetTime() - pauseStart);
+	}
+}
+
+/* CMD_FLUSH_DEADLINE, see stream_flush.c. A plain stream channel of
+ * another buffer size is created again, a running stream goes on after a
+ * gap as with CMD_PIB_CLOCK. */
+CyU3PReturnStatus_t CyFxStreamFlushDeadline(uint16_t ms, uint16_t rateKbps)
+{
+	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+	CyBool_t resume;
+	uint32_t start;
+
+	apiRetStatus = CyFxFlushDeadline(ms, rateKbps);
+	if (apiRetStatus != CY_U3P_SUCCESS)
+		return apiRetStatus;
+
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (glIsApplnActive && state.channelMode == CY_FX_STREAM_CHANNEL_AUTO &&
+			CyFxFlushBufferSize(glStreamDmaCfg.size) != CyFxFlushGetChannel())
+	{
+		start = CyU3PGetTime();
+		resume = CyFxStreamPause();
+		CyFxStreamChannelDestroy();
+		apiRetStatus = CyFxStreamChannelSelect(CY_FX_STREAM_CHANNEL_AUTO);
+		CyFxStreamResume(resume && apiRetStatus == CY_U3P_SUCCESS, start);
+	}
+	CyU3PMutexPut (&glStreamLock);
+
+	return apiRetStatus;
+}
+
+static PibClockConfig_t glPibRequest;        /* CMD_PIB_CLOCK for the application thread */
+static uint32_t glPibRequestResult = PIB_CLK_OK;
+
+/* Re-initialize the P-port with the clock of glPibRequest, see
+ * pib_clock.c. The stream channel owns the P-port sockets, it is given up
+ * before and created again after, and the GPIF configuration is loaded on
+ * the fresh P-port. If that fails the previous clock is restored.
+ * Application thread, on CY_FX_APP_EVT_PIB_CLOCK. */
+static void CyFxPibClockRun(void)
+{
+	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
+	CyBool_t resume;
+	uint8_t mode;
+	uint32_t result;
+	uint32_t start;
+
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	start = CyU3PGetTime();
+	resume = CyFxStreamPause();
+	mode = state.channelMode;
+	if (mode == CY_FX_STREAM_CHANNEL_NONE || mode == CY_FX_STREAM_CHANNEL_PRETRIG)
+		mode = CY_FX_STREAM_CHANNEL_AUTO;
+	if (glIsApplnActive)
+		CyFxStreamChannelDestroy();
+
+	result = CyFxPibClockApply(&glPibRequest);
+	apiRetStatus = CyFxGpifLoad();
+	if (apiRetStatus != CY_U3P_SUCCESS && result == PIB_CLK_OK)
+	{
+		CyU3PDebugPrint (4, "CyU3PGpifLoad failed, Error Code = %d\n", apiRetStatus);
+		result = PIB_CLK_INIT_FAILED;
+		CyFxPibClockRevert();
+		apiRetStatus = CyFxGpifLoad();
+	}
+	if (apiRetStatus != CY_U3P_SUCCESS)
+	{
+		CyU3PDebugPrint (4, "CyU3PGpifLoad failed, Error Code = %d\n", apiRetStatus);
+		result = PIB_CLK_INIT_FAILED;
+		resume = CyFalse;
+	}
+	CyU3PGpifRegisterCallback(CyFxBulkSrcSinkApplnGPIFEventCB);
+
+	if (glIsApplnActive && CyFxStreamChannelSelect(mode) != CY_U3P_SUCCESS)
+		resume = CyFalse;
+	CyFxStreamResume(resume, start);
+	CyFxPibClockResult(result, CyU3PGetTime() - start);
+	glPibRequestResult = result;
+	CyU3PMutexPut (&glStreamLock);
+
+	CyU3PEventSet (&glAppEvent, CY_FX_APP_EVT_PIB_DONE, CYU3P_EVENT_OR);
+}
+
+/* CMD_PIB_CLOCK from the EP0 setup callback. The setting is checked here,
+ * the P-port is re-initialized by the application thread. The request
+ * waits for it, so a failed change stalls. */
+CyU3PReturnStatus_t CyFxPibClockSelect(const PibClockConfig_t *config)
+{
+	uint32_t result;
+	uint32_t pibHz;
+	uint32_t evStat = 0;
+
+	result = CyFxPibClockCheck(config, &pibHz);
+	if (result != PIB_CLK_OK)
+	{
+		CyFxPibClockResult(result, 0);
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+
+	/* A late answer to a request that timed out must not count. */
+	CyU3PEventSet (&glAppEvent, ~CY_FX_APP_EVT_PIB_DONE, CYU3P_EVENT_AND);
+	glPibRequest = *config;
+	CyU3PEventSet (&glAppEvent, CY_FX_APP_EVT_PIB_CLOCK, CYU3P_EVENT_OR);
+	if (CyU3PEventGet (&glAppEvent, CY_FX_APP_EVT_PIB_DONE, CYU3P_EVENT_OR_CLEAR, &evStat,
+			CY_FX_PIB_CLOCK_WAIT_MS) != CY_U3P_SUCCESS)
+		return CY_U3P_ERROR_TIMEOUT;
+
+	return (glPibRequestResult == PIB_CLK_OK) ? CY_U3P_SUCCESS : CY_U3P_ERROR_FAILURE;
+}
+
+/* Window and tail are in the ring: stop GPIF and send them. */
+static void CyFxPretrigFrozen(void)
+{
+	CyU3PMutexGet (&glStreamLock, CYU3P_WAIT_FOREVER);
+	if (state.channelMode == CY_FX_STREAM_CHANNEL_PRETRIG)
+	{
+		CyFxStopAd9269Gpif();
+		CyFxPretrigUpload();
+	}
+	CyU3PMutexPut (&glStreamLock);
 }
 
 void CyFxConfigureAd9269(uint8_t clockDiv)
@@ -776,15 +1822,8 @@ CyFxBulkSrcSinkApplnInit (void)
 {
 	CyU3PReturnStatus_t apiRetStatus = CY_U3P_SUCCESS;
 	/**************************************GPIF****************************************************/
-	CyU3PPibClock_t pibClock;
-
 	/* Initialize the p-port block. */
-	pibClock.clkDiv = 2;
-	pibClock.clkSrc = CY_U3P_SYS_CLK;
-	pibClock.isHalfDiv = CyFalse;
-	/* Disable DLL for sync GPIF */
-	pibClock.isDllEnable = CyFalse;
-	apiRetStatus = CyU3PPibInit(CyTrue, &pibClock);
+	apiRetStatus = CyFxPibClockInit();
 	if (apiRetStatus != CY_U3P_SUCCESS)
 	{
 		CyU3PDebugPrint (4, "P-port Initialization failed, Error Code = %d\n",apiRetStatus);
@@ -792,7 +1831,7 @@ CyFxBulkSrcSinkApplnInit (void)
 	}
 
 	/* Load the GPIF configuration for Slave FIFO sync mode. */
-	apiRetStatus = CyU3PGpifLoad (&CyFxGpifConfig);
+	apiRetStatus = CyFxGpifLoad ();
 	if (apiRetStatus != CY_U3P_SUCCESS)
 	{
 		CyU3PDebugPrint (4, "CyU3PGpifLoad failed, Error Code = %d\n",apiRetStatus);
@@ -811,6 +1850,12 @@ CyFxBulkSrcSinkApplnInit (void)
 		CyFxAppErrorHandler(apiRetStatus);
 	}
 
+	/* Start sampling PHY/LINK error counters in background. */
+	CyFxUsbErrStatsInit();
+
+	/* Take control over U1/U2 entry requests from the host. */
+	CyFxLpmInit();
+
 	/* The fast enumeration is the easiest way to setup a USB connection,
 	 * where all enumeration phase is handled by the library. Only the
 	 * class / vendor requests need to be handled by the application. */
@@ -917,7 +1962,18 @@ void
 BulkSrcSinkAppThread_Entry (
 		uint32_t input)
 {
+	CyU3PMemSet ((uint8_t *)&state, 0, sizeof (state));
 	state.need_reset = CyFalse;
+	state.streaming = CyFalse;
+
+	if (CyU3PEventCreate (&glAppEvent) != CY_U3P_SUCCESS)
+	{
+		CyFxAppErrorHandler (CY_U3P_ERROR_FAILURE);
+	}
+	if (CyU3PMutexCreate (&glStreamLock, CYU3P_INHERIT) != CY_U3P_SUCCESS)
+	{
+		CyFxAppErrorHandler (CY_U3P_ERROR_FAILURE);
+	}
 	/* Initialize the debug module */
 	//CyFxBulkSrcSinkApplnDebugInit();
 
@@ -928,26 +1984,63 @@ BulkSrcSinkAppThread_Entry (
 
 	//CyFxConfigureAd9269(3);
 
-	CyFxStartAd9269Gpif();
+	/* GPIF is started by CMD_STREAM_START once the host is ready to read. */
 	CyU3PDebugPrint (6, "\n\rSTART DBM");
 	for (;;)
 	{
-		CyU3PThreadSleep(100);
+		uint32_t evStat = 0;
+
+		/* Wake up on application events or every 100 ms, more often
+		 * while the stream monitors run. */
+		CyU3PEventGet (&glAppEvent, CY_FX_APP_EVT_ALL, CYU3P_EVENT_OR_CLEAR, &evStat,
+				CyFxStatsActive() ? CY_FX_STATS_PERIOD_MS :
+				CyFxJamActive() ? CY_FX_JAM_PERIOD_MS : 100);
+
+		/* Trigger first: an overflow right after a triggered start must
+		 * find the stream marked as running. */
+		if (evStat & CY_FX_APP_EVT_TRIGGER) {
+			CyFxStreamTriggered();
+		}
+		if (evStat & CY_FX_APP_EVT_SNAPSHOT_DONE) {
+			CyFxSnapshotDone();
+		}
+		if (evStat & CY_FX_APP_EVT_PRETRIG_FROZEN) {
+			CyFxPretrigFrozen();
+		}
+		if (evStat & CY_FX_APP_EVT_GPIF_OVERFLOW) {
+			CyFxRecoverGpifOverflow();
+		}
+		if (evStat & CY_FX_APP_EVT_LPM) {
+			CyFxLpmApply();
+		}
+		if (evStat & CY_FX_APP_EVT_PIB_CLOCK) {
+			CyFxPibClockRun();
+		}
+
+		CyFxStreamUpdateCounters();
+		CyFxSnapshotPoll();
+		CyFxMonitorUpdate();
+
 		if ( state.need_reset == CyTrue ) {
 			CyU3PThreadSleep(2500);
 			CyU3PDeviceReset(CyFalse);
 		}
 
 
-		/*if (glIsApplnActive)
+#ifdef ITS_FX3_STREAM_AUTOSTART
+		if (glIsApplnActive)
 		{
-
 			if(!glStartAd9269Gpif)
 			{
 				glStartAd9269Gpif = CyTrue;
-				CyFxStartAd9269Gpif();
-			}*/
-
+				CyFxStreamStart();
+			}
+		}
+		else
+		{
+			glStartAd9269Gpif = CyFalse;
+		}
+#endif
 
 			/* Print the number of buffers received / transmitted so far from the USB host. */
 		//	CyU3PDebugPrint (4, "\n\rData tracker: buffers received: %d, buffers sent: %d\n", glDMARxCount, glDMATxCount);
@@ -963,6 +2056,11 @@ CyFxApplicationDefine (
 	void *ptr = NULL;
 	uint32_t retThrdCreate = CY_U3P_SUCCESS;
 
+	CyFxDecimInit();
+	CyFxFooterInit();
+	CyFxStatsInit();
+	CyFxJamInit();
+
 	/* Allocate the memory for the threads */
 	ptr = CyU3PMemAlloc (CY_FX_BULKSRCSINK_THREAD_STACK);
 
@@ -24,14 +24,48 @@
 
 #include "cyu3types.h"
 #include "cyu3usbconst.h"
+#include "cyu3os.h"
+#include "host_commands.h"
+#include "gpif_bus.h"
 #include "cyu3externcstart.h"
 
-#define CY_FX_BULKSRCSINK_DMA_BUF_COUNT      (6)                       /* Bulk channel buffer count */
+/* The multichannel count is per producer socket. The buffer heap of
+ * cyfxtx.c is 224 KB on silicon. EP 0x01 takes 16 x 1 KB of it and the
+ * SDK a little more, which leaves 12 stream buffers of 16 KB over all
+ * sockets (192 KB). The stream channel is destroyed before a channel of
+ * another mode is created, so every mode gets the same 12. */
+#define CY_FX_STREAM_DMA_BUF_TOTAL           (12)                      /* Stream channel buffers, all sockets */
+#define CY_FX_BULKSRCSINK_DMA_BUF_COUNT      (CY_FX_STREAM_DMA_BUF_TOTAL / CY_FX_GPIF_THREADS) /* Bulk channel buffers per producer socket */
+#define CY_FX_PRETRIG_DMA_BUF_COUNT          (CY_FX_STREAM_DMA_BUF_TOTAL / CY_FX_GPIF_THREADS) /* Pre-trigger buffers per producer socket */
+
+#if CY_FX_STREAM_DMA_BUF_TOTAL % CY_FX_GPIF_THREADS != 0
+#error "CY_FX_STREAM_DMA_BUF_TOTAL must be a multiple of CY_FX_GPIF_THREADS"
+#endif
+
+/* Stream channel set-ups */
+#define CY_FX_STREAM_CHANNEL_AUTO            (0)                       /* AUTO_MANY_TO_ONE, no CPU involvement */
+#define CY_FX_STREAM_CHANNEL_PRETRIG         (1)                       /* MANUAL, pre-trigger ring */
+#define CY_FX_STREAM_CHANNEL_DECIM           (2)                       /* MANUAL, CIC decimator */
+#define CY_FX_STREAM_CHANNEL_FOOTER          (3)                       /* MANUAL, check sum footers */
+#define CY_FX_STREAM_CHANNEL_NONE            (0xFF)                    /* No channel, the last re-create failed */
 #define CY_FX_BULKSRCSINK_DMA_TX_SIZE        (0)                       /* DMA transfer size is set to infinite */
 #define CY_FX_BULKSRCSINK_THREAD_STACK       (0x1000)                  /* Bulk loop application thread stack size */
 #define CY_FX_BULKSRCSINK_THREAD_PRIORITY    (8)                       /* Bulk loop application thread priority */
 #define CY_FX_BULKSRCSINK_PATTERN            (0xAA)                    /* 8-bit pattern to be loaded to the source buffers. */
 
+/* Application thread event flags */
+#define CY_FX_APP_EVT_GPIF_OVERFLOW          (1 << 0)                  /* GPIF state machine signalled overflow */
+#define CY_FX_APP_EVT_TRIGGER                (1 << 1)                  /* External trigger started the GPIF */
+#define CY_FX_APP_EVT_SNAPSHOT_DONE          (1 << 2)                  /* Finite snapshot transfer completed */
+#define CY_FX_APP_EVT_PRETRIG_FROZEN         (1 << 3)                  /* Pre-trigger window and tail captured */
+#define CY_FX_APP_EVT_LPM                    (1 << 4)                  /* LPM policy or streaming changed */
+#define CY_FX_APP_EVT_PIB_CLOCK              (1 << 6)                  /* CMD_PIB_CLOCK waits for the P-port re-init */
+#define CY_FX_APP_EVT_ALL                    (CY_FX_APP_EVT_GPIF_OVERFLOW | CY_FX_APP_EVT_TRIGGER | \
+                                              CY_FX_APP_EVT_SNAPSHOT_DONE | CY_FX_APP_EVT_PRETRIG_FROZEN | \
+                                              CY_FX_APP_EVT_LPM | CY_FX_APP_EVT_PIB_CLOCK)
+#define CY_FX_APP_EVT_PIB_DONE               (1 << 16)                 /* P-port re-init done, not in ALL: the EP0 callback waits on it */
+#define CY_FX_PIB_CLOCK_WAIT_MS              (500)                     /* Longest CMD_PIB_CLOCK waits, below the host control timeout */
+
 /* Endpoint and socket definitions for the bulk source sink application */
 
 /* To change the producer and consumer EP enter the appropriate EP numbers for the #defines.
@@ -71,6 +105,24 @@ extern const uint8_t CyFxUSBStringLangIDDscr[];
 extern const uint8_t CyFxUSBManufactureDscr[];
 extern const uint8_t CyFxUSBProductDscr[];
 
+/* Stream control, see CMD_STREAM_START / CMD_STREAM_STOP */
+extern CyU3PReturnStatus_t CyFxStartAd9269Gpif (void);
+extern void CyFxStopAd9269Gpif (void);
+extern CyU3PReturnStatus_t CyFxStreamStart (void);
+extern void CyFxStreamStop (void);
+extern CyU3PReturnStatus_t CyFxStreamArm (uint8_t edge);
+extern CyU3PReturnStatus_t CyFxSnapshotStart (uint32_t length);
+extern CyU3PReturnStatus_t CyFxPretrigStart (uint16_t tailBufs, uint8_t edge);
+extern CyU3PReturnStatus_t CyFxDecimStreamStart (uint8_t log2r);
+extern CyU3PReturnStatus_t CyFxFooterStreamStart (void);
+extern CyU3PReturnStatus_t CyFxPibClockSelect (const PibClockConfig_t *config);
+extern CyU3PReturnStatus_t CyFxGpifSMStartFromIsr (void);
+extern CyBool_t CyFxStreamPosition (uint64_t *offset, uint32_t *streamId);
+extern void CyFxStreamGetGaps (GapLog_t *log);
+extern CyU3PReturnStatus_t CyFxStreamFlushDeadline (uint16_t ms, uint16_t rateKbps);
+
+extern CyU3PEvent glAppEvent;
+
 #include <cyu3externcend.h>
 
 #endif /* _INCLUDED_CYFXBULKSRCSINK_H_ */
@@ -90,8 +90,8 @@ const uint8_t CyFxUSBBOSDscr[] =
     0x00,                           /* Supported device level features  */
     0x0E,0x00,                      /* Speeds supported by the device : SS, HS and FS */
     0x03,                           /* Functionality support */
-    0x00,                           /* U1 Device Exit latency */
-    0x00,0x00                       /* U2 Device Exit latency */
+    0x0A,                           /* U1 Device Exit latency : 10 us */
+    0xFF,0x07                       /* U2 Device Exit latency : 2047 us */
 };
 
 /* Standard device qualifier descriptor */
@@ -25,6 +25,12 @@
 #include "cyu3uart.h"
 #include <cyu3gpio.h>
 #include "cyfxspi_bb.h"
+#include "stream_trigger.h"
+#include "pps_latch.h"
+#include "latency_mark.h"
+#include "cycle_prof.h"
+#include "pc_sample.h"
+#include "cpu_load.h"
 
 CyU3PReturnStatus_t CyU3PSpiReadAd9269(uint16_t addr, uint8_t *value_p /* 8 bit read data */) {
 
@@ -118,6 +124,22 @@ CyU3PReturnStatus_t CyU3PSpiSendData(uint8_t value /* 8 bit write data */) {
 
 	return apiRetStatus;
 }
+/* GPIO interrupt callback, runs in interrupt context. */
+static void CyFxGpioIntrCb(uint8_t gpioId) {
+	CY_FX_PROF_ENTER( PROF_REGION_GPIO_ISR );
+
+	if (gpioId == PPS_IN) {
+		CyFxPpsIsr();
+	} else if (gpioId == TRIGGER_IN) {
+		CyFxTriggerIsr();
+	} else if (gpioId == PC_SAMPLE_TIMER) {
+		CyFxPcSampleIsr();
+	} else if (gpioId == CPU_LOAD_TIMER) {
+		CyFxCpuLoadIsr();
+	}
+	CY_FX_PROF_EXIT( PROF_REGION_GPIO_ISR );
+}
+
 void CyFxGpioInit(void) {
 	CyU3PGpioClock_t gpioClock;
 	CyU3PGpioSimpleConfig_t gpioConfig;
@@ -130,7 +152,7 @@ void CyFxGpioInit(void) {
 	gpioClock.clkSrc = CY_U3P_SYS_CLK;
 	gpioClock.halfDiv = 0;
 
-	apiRetStatus = CyU3PGpioInit(&gpioClock, NULL);
+	apiRetStatus = CyU3PGpioInit(&gpioClock, CyFxGpioIntrCb);
 	if (apiRetStatus != 0) {
 		/* Error Handling */
 		CyU3PDebugPrint(4, "CyU3PGpioInit failed, error code = %d\n",
@@ -223,6 +245,20 @@ void CyFxGpioInit(void) {
 				"SPI_SS0 CyU3PDeviceGpioOverride failed, error code = %d\n",
 				apiRetStatus);
 	}
+	apiRetStatus = CyU3PDeviceGpioOverride(TRIGGER_IN, CyFalse);
+	if (apiRetStatus != 0) {
+		/* Error Handling */
+		CyU3PDebugPrint(4,
+				"TRIGGER_IN CyU3PDeviceGpioOverride failed, error code = %d\n",
+				apiRetStatus);
+	}
+	apiRetStatus = CyU3PDeviceGpioOverride(PPS_IN, CyTrue);
+	if (apiRetStatus != 0) {
+		/* Error Handling */
+		CyU3PDebugPrint(4,
+				"PPS_IN CyU3PDeviceGpioOverride failed, error code = %d\n",
+				apiRetStatus);
+	}
 
 	/* Configure  output line : CLK, MOSI, SS */
 	gpioConfig.outValue = CyTrue;
@@ -364,6 +400,11 @@ void CyFxGpioInit(void) {
 				apiRetStatus);
 	}
 
+
+	CyFxTriggerInit();
+	CyFxPpsInit();
+	CyFxLatencyMarkInit();
+	CyFxProfInit();
 }
 
 /* [ ] */
@@ -39,6 +39,13 @@
 #define ANTLNAEN		(50)		/* GPIO50 */
 #define ANTFEEDEN		(18)		/* GPIO18, CTL[1] */
 
+#define TRIGGER_IN		(45)		/* External start trigger input, complex GPIO45 */
+#define PPS_IN			(43)		/* 1PPS input from the GNSS receiver, GPIO43 */
+#define LATENCY_MARK		(44)		/* Latency marker output, GPIO44, looped to a data line */
+#define PROF_TIMER		(51)		/* Profiling timer, complex GPIO51, pin not driven */
+#define PC_SAMPLE_TIMER		(52)		/* PC sampling interrupt, complex GPIO52, pin not driven */
+#define CPU_LOAD_TIMER		(57)		/* CPU load sampling interrupt, complex GPIO57 (I2S_MCLK, I2S off), pin not driven */
+
 
 /*
  Summary
@@ -0,0 +1,136 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+
+#include "cpsr_utils.h"
+#include "cycle_prof.h"
+#include "decim_stage.h"
+#include "cic_decim.h"
+
+/*
+ * Decimating stream stage.
+ *
+ * In decimation mode the stream channel is MANUAL_MANY_TO_ONE. This thread
+ * takes every buffer GPIF fills, runs the CIC decimator over it in place
+ * and commits the shorter result to EP 0x81. Buffers are 16 KB and the
+ * decimation at most 128, so blocks never straddle buffers and every
+ * committed length is a multiple of the USB packet size.
+ *
+ * glDecimLock is held while a buffer is in the hands of the thread, so
+ * CyFxDecimStop returns only after the current buffer is done.
+ *
+ * The stage keeps up while one buffer is decimated faster than GPIF fills
+ * the next: 16384 / R us at an input of R MB/s, at 100 MB/s 164 us or
+ * about two CPU cycles per input byte. GPIF has the other buffers of the
+ * channel to fill meanwhile, so a slow buffer now and then is absorbed, a
+ * slow mean is not. An image built with ITS_FX3_PROFILE times every
+ * buffer in PROF_REGION_CIC, about one tick per CPU cycle, and
+ * host/itsprof prints the input rate the mean and the slowest buffer
+ * sustain.
+ *
+ * The byte counters are 64 bit, updated and read with interrupts off so
+ * CMD_READ_DECIM never sees half an update.
+ */
+
+#define CY_FX_DECIM_EVT_RUN   (1 << 0)
+#define CY_FX_DECIM_WAIT_MS   (10)
+
+static CyU3PThread glDecimThread;
+static CyU3PMutex  glDecimLock;
+static CyU3PEvent  glDecimEvent;
+static CyU3PDmaMultiChannel* glDecimChannel = NULL;
+static CicDecim_t glDecimCic;
+
+static uint32_t glDecimBuffers = 0;
+static uint32_t glDecimErrors = 0;
+static uint64_t glDecimBytesIn = 0;
+static uint64_t glDecimBytesOut = 0;
+
+static void CyFxDecimThreadEntry( uint32_t input )
+{
+	CyU3PDmaBuffer_t buf;
+	uint32_t flags;
+	uint32_t cpsr;
+	uint32_t n;
+
+	for ( ;; ) {
+		CyU3PMutexGet( &glDecimLock, CYU3P_WAIT_FOREVER );
+		if ( glDecimChannel == NULL ) {
+			CyU3PMutexPut( &glDecimLock );
+			CyU3PEventGet( &glDecimEvent, CY_FX_DECIM_EVT_RUN, CYU3P_EVENT_OR_CLEAR, &flags, CYU3P_WAIT_FOREVER );
+			continue;
+		}
+
+		if ( CyU3PDmaMultiChannelGetBuffer( glDecimChannel, &buf, CY_FX_DECIM_WAIT_MS ) == CY_U3P_SUCCESS ) {
+			CY_FX_PROF_ENTER( PROF_REGION_CIC );
+			n = CyFxCicRun( &glDecimCic, buf.buffer, buf.count, buf.buffer );
+			CY_FX_PROF_EXIT( PROF_REGION_CIC );
+			if ( n > 0 ) {
+				if ( CyU3PDmaMultiChannelCommitBuffer( glDecimChannel, (uint16_t)n, 0 ) != CY_U3P_SUCCESS ) {
+					glDecimErrors++;
+				}
+			} else {
+				CyU3PDmaMultiChannelDiscardBuffer( glDecimChannel );
+			}
+			cpsr = disable_interrupts();
+			glDecimBuffers++;
+			glDecimBytesIn += buf.count;
+			glDecimBytesOut += n;
+			restore_interrupts( cpsr );
+		}
+		CyU3PMutexPut( &glDecimLock );
+	}
+}
+
+void CyFxDecimInit( void )
+{
+	void* ptr;
+
+	CyU3PMutexCreate( &glDecimLock, CYU3P_INHERIT );
+	CyU3PEventCreate( &glDecimEvent );
+
+	ptr = CyU3PMemAlloc( CY_FX_DECIM_THREAD_STACK );
+	if ( CyU3PThreadCreate( &glDecimThread, "22:Decimator", CyFxDecimThreadEntry, 0, ptr,
+			CY_FX_DECIM_THREAD_STACK, CY_FX_DECIM_THREAD_PRIORITY, CY_FX_DECIM_THREAD_PRIORITY,
+			CYU3P_NO_TIME_SLICE, CYU3P_AUTO_START ) != 0 ) {
+		/* Application cannot continue */
+		while ( 1 );
+	}
+}
+
+CyU3PReturnStatus_t CyFxDecimStart( CyU3PDmaMultiChannel* chHandle, uint8_t log2r )
+{
+	CyU3PMutexGet( &glDecimLock, CYU3P_WAIT_FOREVER );
+	if ( CyFxCicInit( &glDecimCic, log2r ) != 0 ) {
+		CyU3PMutexPut( &glDecimLock );
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+	glDecimChannel = chHandle;
+	CyU3PMutexPut( &glDecimLock );
+
+	CyU3PEventSet( &glDecimEvent, CY_FX_DECIM_EVT_RUN, CYU3P_EVENT_OR );
+	return CY_U3P_SUCCESS;
+}
+
+void CyFxDecimStop( void )
+{
+	CyU3PMutexGet( &glDecimLock, CYU3P_WAIT_FOREVER );
+	glDecimChannel = NULL;
+	CyU3PMutexPut( &glDecimLock );
+}
+
+void CyFxDecimGetStatus( DecimStatus_t* status )
+{
+	uint32_t cpsr;
+
+	CyU3PMemSet( (uint8_t*)status, 0, sizeof( DecimStatus_t ) );
+	status->log2r     = glDecimCic.log2r;
+	status->active    = ( glDecimChannel != NULL );
+	status->errors    = glDecimErrors;
+	cpsr = disable_interrupts();
+	status->buffers   = glDecimBuffers;
+	status->bytes_in  = glDecimBytesIn;
+	status->bytes_out = glDecimBytesOut;
+	restore_interrupts( cpsr );
+}
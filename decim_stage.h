@@ -0,0 +1,22 @@
+#ifndef DECIM_STAGE_H_
+#define DECIM_STAGE_H_
+
+#include <cyu3types.h>
+#include <cyu3dma.h>
+#include "host_commands.h"
+
+#define CY_FX_DECIM_THREAD_STACK     (0x800)   /* Decimator thread stack size */
+#define CY_FX_DECIM_THREAD_PRIORITY  (7)       /* Above the application thread */
+
+/* Create the decimator thread. Call once from CyFxApplicationDefine. */
+void CyFxDecimInit( void );
+
+/* Process buffers of a MANUAL_MANY_TO_ONE channel that is armed and idle. */
+CyU3PReturnStatus_t CyFxDecimStart( CyU3PDmaMultiChannel* chHandle, uint8_t log2r );
+
+/* Returns when the decimator thread no longer touches the channel. */
+void CyFxDecimStop( void );
+
+void CyFxDecimGetStatus( DecimStatus_t* status );
+
+#endif /* DECIM_STAGE_H_ */
@@ -0,0 +1,26 @@
+#include "footer_sum.h"
+
+/*
+ * One load and two adds per word. Unrolled by four, which leaves the ARM
+ * enough registers to keep both sums and the pointer out of memory.
+ */
+
+void CyFxFooterSum( FooterSum_t* sum, const uint8_t* data, uint32_t len )
+{
+	const uint32_t* w = (const uint32_t*)data;
+	uint32_t n = len / 4;
+	uint32_t a = sum->a;
+	uint32_t b = sum->b;
+
+	for ( ; n >= 4; n -= 4, w += 4 ) {
+		a += w[ 0 ]; b += a;
+		a += w[ 1 ]; b += a;
+		a += w[ 2 ]; b += a;
+		a += w[ 3 ]; b += a;
+	}
+	for ( ; n > 0; n--, w++ ) {
+		a += w[ 0 ]; b += a;
+	}
+	sum->a = a;
+	sum->b = b;
+}
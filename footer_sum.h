@@ -0,0 +1,27 @@
+#ifndef FOOTER_SUM_H_
+#define FOOTER_SUM_H_
+
+#ifdef ITS_HOST_BUILD
+#include <stdint.h>
+#else
+#include <cyu3types.h>
+#endif
+
+/*
+ * Check sums of the stream footers, see StreamFooter_t in host_commands.h.
+ * Plain C without SDK calls, the host library builds the same file.
+ *
+ * Fletcher sums modulo 2^32 over little endian 32 bit words w[i]:
+ * a = sum of w[i], b = sum of the running a. b catches swapped and
+ * misplaced words that leave a unchanged.
+ */
+
+typedef struct FooterSum_t {
+	uint32_t a;
+	uint32_t b;
+} FooterSum_t;
+
+/* Add len bytes at data, 4 byte aligned, len a multiple of 4. */
+void CyFxFooterSum( FooterSum_t* sum, const uint8_t* data, uint32_t len );
+
+#endif /* FOOTER_SUM_H_ */
@@ -0,0 +1,24 @@
+#ifndef GPIF_BUS_H_
+#define GPIF_BUS_H_
+
+/*
+ * GPIF bus of the stream.
+ *
+ * The front end drives an 8 bit bus, latched on the rising edge of its
+ * clock. The GPIF II Designer project gpif_ii_src/ generates
+ * gpif2_config.h, which gpif_load.c links in. Other bus widths need a
+ * generated header of their own.
+ *
+ * The state machine ping-pongs between GPIF threads 0 and 1, one DMA
+ * buffer each. Thread n writes P-port socket n, the stream channel has
+ * one producer socket per thread.
+ */
+
+/* Width of the GPIF bus in bits and bytes */
+#define CY_FX_GPIF_WIDTH        ( 8 )
+#define CY_FX_GPIF_WORD_BYTES   ( CY_FX_GPIF_WIDTH / 8 )
+
+/* GPIF threads and P-port producer sockets of the stream */
+#define CY_FX_GPIF_THREADS      ( 2 )
+
+#endif /* GPIF_BUS_H_ */
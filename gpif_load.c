@@ -0,0 +1,58 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3gpif.h"
+
+#include "gpif_bus.h"
+#include "gpif_load.h"
+#include "gpif2_config.h"
+
+/*
+ * CY_FX_GPIF_DATA_COUNT_LIMIT is the index of the data counter limit in
+ * the register table of gpif2_config.h. The project sets it for a 16 KB
+ * buffer, CyFxGpifBufferSize() patches the table for the buffers actually
+ * allocated. A thread writes one word in its load state and limit + 1
+ * counted ones before GPIF switches threads, so the limit is the buffer
+ * in words - 2.
+ */
+
+#define CY_FX_GPIF_DATA_COUNT_LIMIT  (39)
+
+static CyBool_t glGpifLoaded = CyFalse;
+static uint32_t glGpifBufferSize = 0;
+
+CyU3PReturnStatus_t CyFxGpifLoad( void )
+{
+	CyU3PReturnStatus_t status;
+
+	status = CyU3PGpifLoad( &CyFxGpifConfig );
+	glGpifLoaded = ( status == CY_U3P_SUCCESS );
+	return status;
+}
+
+CyU3PReturnStatus_t CyFxGpifStart( void )
+{
+	if ( !glGpifLoaded )
+		return CY_U3P_ERROR_NOT_CONFIGURED;
+	return CyU3PGpifSMStart( RESET, ALPHA_RESET );
+}
+
+CyU3PReturnStatus_t CyFxGpifBufferSize( uint32_t bytes )
+{
+	uint32_t words;
+
+	if ( bytes == glGpifBufferSize )
+		return CY_U3P_SUCCESS;
+	words = bytes / CY_FX_GPIF_WORD_BYTES;
+	if ( words < 4 || words - 2 > 0xFFFF || words * CY_FX_GPIF_WORD_BYTES != bytes )
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	glGpifBufferSize = bytes;
+	CyFxGpifRegValue[ CY_FX_GPIF_DATA_COUNT_LIMIT ] = words - 2;
+
+	/* The loaded registers only change with a load. */
+	if ( !glGpifLoaded )
+		return CY_U3P_SUCCESS;
+	CyU3PGpifDisable( CyTrue );
+	return CyFxGpifLoad();
+}
@@ -0,0 +1,18 @@
+#ifndef GPIF_LOAD_H_
+#define GPIF_LOAD_H_
+
+#include <cyu3types.h>
+
+/* Load the GPIF configuration of gpif2_config.h, at boot and again after
+ * the P-port was re-initialized. */
+CyU3PReturnStatus_t CyFxGpifLoad( void );
+
+/* Start the state machine of the loaded configuration. Any context. */
+CyU3PReturnStatus_t CyFxGpifStart( void );
+
+/* Set the data counter limit for DMA buffers of bytes payload, so GPIF
+ * switches threads exactly at buffer ends. A loaded configuration is
+ * loaded again, GPIF stopped. */
+CyU3PReturnStatus_t CyFxGpifBufferSize( uint32_t bytes );
+
+#endif /* GPIF_LOAD_H_ */
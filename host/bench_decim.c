@@ -0,0 +1,195 @@
+/*
+ * Benchmark and self check of the on-device CIC decimator (cic_decim.c).
+ *
+ * The firmware source is built natively and compared against a direct
+ * form CIC-2 (two integrators, two combs) on random input, then timed on
+ * 16 KB buffers, the DMA buffer size of the stream channel.
+ *
+ * The host timing bounds the cost of the algorithm only. Whether the FX3
+ * keeps up, on its ARM926EJ-S with the data cache off, is measured on the
+ * device: an image built with ITS_FX3_PROFILE times every buffer of a
+ * CMD_DECIMATE stream, host/itsprof -u prints the input rate that
+ * sustains, see decim_stage.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "cic_decim.h"
+#include "its_sample_format.h"
+
+#define BUF_SIZE             ( 16384 )
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t xorshift32( void )
+{
+	uint32_t x = rng_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rng_state = x;
+	return x;
+}
+
+static void fill_random( uint8_t* buf, size_t len )
+{
+	size_t i;
+	for ( i = 0; i < len; i++ ) {
+		buf[ i ] = (uint8_t)xorshift32();
+	}
+}
+
+static double now_sec( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Direct form CIC-2 by R, M = 1, same output scaling as the firmware. */
+static size_t reference_cic( const uint8_t* in, size_t len, int log2r, int16_t* out )
+{
+	int64_t i1[ ITS_SAMPLE_CHANNELS ] = { 0 };
+	int64_t i2[ ITS_SAMPLE_CHANNELS ] = { 0 };
+	int64_t d1[ ITS_SAMPLE_CHANNELS ] = { 0 };
+	int64_t d2[ ITS_SAMPLE_CHANNELS ] = { 0 };
+	size_t r = (size_t)1 << log2r;
+	int shift = CyFxCicShift( (uint8_t)log2r );
+	size_t n, count = 0;
+	int ch;
+
+	for ( n = 0; n < len; n++ ) {
+		for ( ch = 0; ch < ITS_SAMPLE_CHANNELS; ch++ ) {
+			i1[ ch ] += ITS_SAMPLE_VALUE( ITS_SAMPLE_CODE( in[ n ], ch ) );
+			i2[ ch ] += i1[ ch ];
+		}
+		if ( ( n + 1 ) % r == 0 ) {
+			for ( ch = 0; ch < ITS_SAMPLE_CHANNELS; ch++ ) {
+				int64_t c1 = i2[ ch ] - d1[ ch ];
+				int64_t c2;
+				d1[ ch ] = i2[ ch ];
+				c2 = c1 - d2[ ch ];
+				d2[ ch ] = c1;
+				out[ count * ITS_SAMPLE_CHANNELS + ch ] = (int16_t)( c2 >> shift );
+			}
+			count++;
+		}
+	}
+	return count;
+}
+
+static int check( int log2r )
+{
+	const size_t len = 4 * BUF_SIZE;
+	uint8_t* in = malloc( len );
+	uint8_t* out = malloc( len );
+	int16_t* ref = malloc( len * sizeof( int16_t ) );
+	CicDecim_t cic;
+	size_t nref, nout, i, off;
+	int errors = 0;
+
+	fill_random( in, len );
+	nref = reference_cic( in, len, log2r, ref );
+
+	/* Run in place per buffer, as the firmware does. */
+	memcpy( out, in, len );
+	CyFxCicInit( &cic, (uint8_t)log2r );
+	nout = 0;
+	for ( off = 0; off < len; off += BUF_SIZE ) {
+		uint32_t n = CyFxCicRun( &cic, out + off, BUF_SIZE, out + off );
+		memmove( out + nout, out + off, n );
+		nout += n;
+	}
+
+	if ( nout != nref * CIC_DECIM_OUT_BYTES ) {
+		printf( "log2r %d: %zu output bytes, expected %zu\n", log2r, nout, nref * CIC_DECIM_OUT_BYTES );
+		errors++;
+	}
+	/* Sample 0 differs by design, the firmware history starts at x = -3. */
+	for ( i = ITS_SAMPLE_CHANNELS; i < nref * ITS_SAMPLE_CHANNELS && errors < 8; i++ ) {
+		int16_t got = (int16_t)( out[ 2 * i ] | ( out[ 2 * i + 1 ] << 8 ) );
+		if ( got != ref[ i ] ) {
+			printf( "log2r %d: sample %zu ch %zu: %d, expected %d\n", log2r,
+					i / ITS_SAMPLE_CHANNELS, i % ITS_SAMPLE_CHANNELS, got, ref[ i ] );
+			errors++;
+		}
+	}
+
+	free( in );
+	free( out );
+	free( ref );
+	return errors;
+}
+
+static void usage( const char* prog )
+{
+	printf( "Usage: %s [-m MB] [-r input MB/s]\n", prog );
+	printf( "  -m  amount of data per decimation factor, default 256 MB\n" );
+	printf( "  -r  input byte rate for the output rate column, default 16 MB/s\n" );
+}
+
+int main( int argc, char** argv )
+{
+	double megabytes = 256.0;
+	double rate = 16.0;
+	uint8_t* buf;
+	uint8_t* work;
+	int log2r;
+	int opt;
+	int failed = 0;
+
+	while ( ( opt = getopt( argc, argv, "m:r:h" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'm': megabytes = atof( optarg ); break;
+		case 'r': rate = atof( optarg ); break;
+		default: usage( argv[ 0 ] ); return opt == 'h' ? 0 : 2;
+		}
+	}
+
+	for ( log2r = CIC_DECIM_LOG2_MIN; log2r <= CIC_DECIM_LOG2_MAX; log2r++ ) {
+		failed += check( log2r );
+	}
+	printf( "reference check: %s\n", failed ? "FAILED" : "ok" );
+	if ( failed ) {
+		return 1;
+	}
+
+	buf = malloc( BUF_SIZE );
+	work = malloc( BUF_SIZE );
+	fill_random( buf, BUF_SIZE );
+
+	printf( "%6s %8s %12s %10s %10s\n", "R", "out/in", "host MB/s", "ns/byte", "out MB/s" );
+
+	for ( log2r = CIC_DECIM_LOG2_MIN; log2r <= CIC_DECIM_LOG2_MAX; log2r++ ) {
+		CicDecim_t cic;
+		size_t buffers = (size_t)( megabytes * 1024 * 1024 / BUF_SIZE );
+		size_t i;
+		double t0, t1, mbps;
+		uint32_t sink = 0;
+
+		CyFxCicInit( &cic, (uint8_t)log2r );
+		t0 = now_sec();
+		for ( i = 0; i < buffers; i++ ) {
+			memcpy( work, buf, BUF_SIZE );
+			sink += CyFxCicRun( &cic, work, BUF_SIZE, work );
+		}
+		t1 = now_sec();
+
+		mbps = buffers * (double)BUF_SIZE / ( t1 - t0 ) / ( 1024 * 1024 );
+		printf( "%6d %8.3f %12.1f %10.3f %10.2f\n", 1 << log2r,
+				(double)CIC_DECIM_OUT_BYTES / ( 1 << log2r ), mbps,
+				1e3 / ( mbps * 1.048576 ), rate * CIC_DECIM_OUT_BYTES / ( 1 << log2r ) );
+		if ( sink == 0 ) {
+			printf( "no output\n" );
+		}
+	}
+
+	free( buf );
+	free( work );
+	return 0;
+}
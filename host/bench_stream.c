@@ -0,0 +1,189 @@
+/*
+ * Stream throughput: the naive loop against the async ring of itsfx3.c.
+ *
+ * naive  one synchronous bulk read at a time into a staging buffer and a
+ *        memcpy into the application buffer, as most ad hoc tools do.
+ * async  its_stream_start with a ring of transfers, the callback works on
+ *        the transfer buffer directly.
+ *
+ * Both run against the loopback device by default, which models the USB
+ * 3.0 link rate and the request turnaround (see itsfx3_loopback.c), and
+ * check that the stream offsets arrive in order. With -u they run against
+ * a real device, without the data check.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "itsfx3.h"
+
+typedef struct bench_state {
+	int      check;         /* Data is the loopback pattern */
+	uint64_t errors;
+	double   deadline;
+} bench_state;
+
+static double now_sec( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The loopback stream holds the byte offset of every 8 byte word. */
+static void check_buffer( bench_state* st, const uint8_t* data, size_t len, uint64_t offset )
+{
+	uint64_t w;
+
+	if ( !st->check || len < 8 )
+		return;
+	memcpy( &w, data, 8 );
+	if ( w != offset )
+		st->errors++;
+	memcpy( &w, data + ( ( len - 8 ) & ~(size_t)7 ), 8 );
+	if ( w != offset + ( ( len - 8 ) & ~(size_t)7 ) )
+		st->errors++;
+}
+
+static int stream_cb( const its_buffer* buf, void* user )
+{
+	bench_state* st = user;
+
+	check_buffer( st, buf->data, buf->length, buf->offset );
+	return ( now_sec() >= st->deadline ) ? 1 : 0;
+}
+
+static double run_naive( its_dev* dev, bench_state* st, size_t chunk, double seconds )
+{
+	uint8_t* staging = malloc( chunk );
+	uint8_t* app = malloc( chunk );
+	uint64_t total = 0;
+	size_t got;
+	double t0, t;
+	int rc;
+
+	if ( !staging || !app ) {
+		free( staging );
+		free( app );
+		return -1;
+	}
+
+	its_cmd_stream_start( dev );
+	t0 = now_sec();
+	do {
+		rc = its_read_sync( dev, staging, chunk, &got, 1000 );
+		if ( rc != ITS_OK ) {
+			fprintf( stderr, "naive read: %s\n", its_strerror( rc ) );
+			break;
+		}
+		memcpy( app, staging, got );
+		check_buffer( st, app, got, total );
+		total += got;
+		t = now_sec();
+	} while ( t - t0 < seconds );
+	its_cmd_stream_stop( dev );
+
+	free( staging );
+	free( app );
+	return total / ( now_sec() - t0 ) / 1e6;
+}
+
+static double run_async( its_dev* dev, bench_state* st, unsigned transfers, size_t size, double seconds )
+{
+	its_stream_config config;
+	its_stream_stats stats;
+	double t0, t1;
+	int rc;
+
+	its_stream_defaults( &config );
+	config.transfers = transfers;
+	config.transfer_size = size;
+
+	t0 = now_sec();
+	st->deadline = t0 + seconds;
+	rc = its_stream_start( dev, &config, stream_cb, st );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "stream start: %s\n", its_strerror( rc ) );
+		return -1;
+	}
+	its_cmd_stream_start( dev );
+	while ( ( rc = its_stream_run( dev, 100 ) ) > 0 )
+		;
+	t1 = now_sec();
+	its_stream_get_stats( dev, &stats );
+	its_stream_stop( dev );
+	its_cmd_stream_stop( dev );
+	if ( rc < 0 )
+		fprintf( stderr, "stream: %s\n", its_strerror( rc ) );
+
+	return stats.bytes / ( t1 - t0 ) / 1e6;
+}
+
+static void usage( const char* name )
+{
+	fprintf( stderr,
+			"usage: %s [-s seconds] [-l link MB/s] [-L latency us] [-t transfers] [-S transfer KB] [-u]\n"
+			"  -l 0 models an unlimited link, -u uses a real device instead of the loopback\n", name );
+}
+
+int main( int argc, char** argv )
+{
+	static const size_t naive_chunks[] = { 16 * 1024, 64 * 1024, 1024 * 1024 };
+	its_loopback_config lb;
+	its_dev* dev = NULL;
+	bench_state st;
+	double seconds = 2.0;
+	unsigned transfers = 32;
+	size_t size = 1024 * 1024;
+	int use_usb = 0;
+	double mbps;
+	size_t i;
+	int opt, rc;
+
+	its_loopback_defaults( &lb );
+	while ( ( opt = getopt( argc, argv, "s:l:L:t:S:uh" ) ) != -1 ) {
+		switch ( opt ) {
+		case 's': seconds = atof( optarg ); break;
+		case 'l': lb.link_mbps = atof( optarg ); break;
+		case 'L': lb.latency_us = (unsigned)atoi( optarg ); break;
+		case 't': transfers = (unsigned)atoi( optarg ); break;
+		case 'S': size = (size_t)atoi( optarg ) * 1024; break;
+		case 'u': use_usb = 1; break;
+		default: usage( argv[ 0 ] ); return 1;
+		}
+	}
+
+	if ( use_usb )
+		rc = its_open_usb( &dev, ITS_USB_VID, ITS_USB_PID );
+	else
+		rc = its_open_loopback( &dev, &lb );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "open: %s\n", its_strerror( rc ) );
+		return 1;
+	}
+
+	memset( &st, 0, sizeof( st ) );
+	st.check = !use_usb;
+	if ( use_usb )
+		printf( "device %04x:%04x, %.1f s per run\n", ITS_USB_VID, ITS_USB_PID, seconds );
+	else
+		printf( "loopback, link %.0f MB/s, latency %u us, %.1f s per run\n", lb.link_mbps, lb.latency_us, seconds );
+	printf( "%-8s %-22s %10s\n", "mode", "request", "MB/s" );
+
+	for ( i = 0; i < sizeof( naive_chunks ) / sizeof( naive_chunks[ 0 ] ); i++ ) {
+		mbps = run_naive( dev, &st, naive_chunks[ i ], seconds );
+		printf( "%-8s %6zu KB sync + copy  %10.1f\n", "naive", naive_chunks[ i ] / 1024, mbps );
+	}
+	mbps = run_async( dev, &st, transfers, size, seconds );
+	printf( "%-8s %3u x %6zu KB        %10.1f\n", "async", transfers, size / 1024, mbps );
+
+	if ( st.check )
+		printf( "data check: %s (%llu errors)\n", st.errors ? "FAILED" : "ok", (unsigned long long)st.errors );
+
+	its_close( dev );
+	return st.errors ? 1 : 0;
+}
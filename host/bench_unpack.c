@@ -0,0 +1,155 @@
+/*
+ * Benchmark and self check of the sample unpack kernels (itsfx3_unpack.c).
+ *
+ * Every kernel the CPU supports is compared against ITS_SAMPLE_VALUE on
+ * random input, at lengths that exercise the scalar tails, then timed on
+ * one core. Rates are input bytes per second, one byte holds one sample
+ * of each channel.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "itsfx3_unpack.h"
+
+static uint32_t rng_state = 0x12345678u;
+
+static uint32_t xorshift32( void )
+{
+	uint32_t x = rng_state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rng_state = x;
+	return x;
+}
+
+static double now_sec( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int check_kernel( its_unpack_kernel kernel, const uint8_t* in, size_t max )
+{
+	static const size_t lengths[] = { 0, 1, 15, 16, 17, 31, 32, 33, 100, 4096, 4099 };
+	int8_t* i8[ ITS_SAMPLE_CHANNELS ];
+	float* f32[ ITS_SAMPLE_CHANNELS ];
+	size_t k, n, len;
+	int c, bad = 0;
+
+	for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ ) {
+		i8[ c ] = malloc( max + 1 );
+		f32[ c ] = malloc( ( max + 1 ) * sizeof( float ) );
+	}
+
+	its_unpack_select( kernel );
+	for ( k = 0; k < sizeof( lengths ) / sizeof( lengths[ 0 ] ) && !bad; k++ ) {
+		len = lengths[ k ];
+		if ( len > max )
+			break;
+		/* Odd source offset, the kernels use unaligned loads */
+		its_unpack_i8( in + 1, len, i8 );
+		its_unpack_f32( in + 1, len, f32 );
+		for ( n = 0; n < len && !bad; n++ ) {
+			for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ ) {
+				int v = ITS_SAMPLE_VALUE( ITS_SAMPLE_CODE( in[ 1 + n ], c ) );
+				if ( i8[ c ][ n ] != v || f32[ c ][ n ] != (float)v ) {
+					fprintf( stderr, "%s: mismatch at len %zu, sample %zu, channel %d\n",
+							its_unpack_name( kernel ), len, n, c );
+					bad = 1;
+					break;
+				}
+			}
+		}
+	}
+
+	for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ ) {
+		free( i8[ c ] );
+		free( f32[ c ] );
+	}
+	return bad;
+}
+
+static double time_kernel( its_unpack_kernel kernel, int f32, const uint8_t* in, size_t len, size_t total )
+{
+	int8_t* i8o[ ITS_SAMPLE_CHANNELS ];
+	float* f32o[ ITS_SAMPLE_CHANNELS ];
+	size_t done = 0;
+	double t0, t;
+	int c;
+
+	for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ ) {
+		i8o[ c ] = malloc( len );
+		f32o[ c ] = malloc( len * sizeof( float ) );
+	}
+
+	its_unpack_select( kernel );
+	t0 = now_sec();
+	while ( done < total ) {
+		if ( f32 )
+			its_unpack_f32( in, len, f32o );
+		else
+			its_unpack_i8( in, len, i8o );
+		done += len;
+	}
+	t = now_sec() - t0;
+
+	for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ ) {
+		free( i8o[ c ] );
+		free( f32o[ c ] );
+	}
+	return total / t / 1e9;
+}
+
+int main( int argc, char** argv )
+{
+	static const its_unpack_kernel kernels[] = { ITS_UNPACK_SCALAR, ITS_UNPACK_SSE2, ITS_UNPACK_AVX2 };
+	size_t block = 64 * 1024;
+	size_t total = (size_t)1 << 30;
+	uint8_t* in;
+	size_t i, k;
+	int opt, bad = 0;
+
+	while ( ( opt = getopt( argc, argv, "b:m:h" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'b': block = (size_t)atoi( optarg ) * 1024; break;
+		case 'm': total = (size_t)atoi( optarg ) << 20; break;
+		default:
+			fprintf( stderr, "usage: %s [-b block KB] [-m MB per run]\n", argv[ 0 ] );
+			return 1;
+		}
+	}
+	if ( block < 8192 )
+		block = 8192;
+
+	in = malloc( block + 1 );
+	for ( i = 0; i < block + 1; i++ )
+		in[ i ] = (uint8_t)xorshift32();
+
+	for ( k = 0; k < sizeof( kernels ) / sizeof( kernels[ 0 ] ); k++ ) {
+		if ( its_unpack_supported( kernels[ k ] ) )
+			bad |= check_kernel( kernels[ k ], in, block );
+	}
+	printf( "reference check: %s\n", bad ? "FAILED" : "ok" );
+
+	printf( "%zu KB blocks, one core, GB/s of input\n", block / 1024 );
+	printf( "%-8s %10s %10s\n", "kernel", "int8", "float" );
+	for ( k = 0; k < sizeof( kernels ) / sizeof( kernels[ 0 ] ); k++ ) {
+		if ( !its_unpack_supported( kernels[ k ] ) ) {
+			printf( "%-8s %10s %10s\n", its_unpack_name( kernels[ k ] ), "-", "-" );
+			continue;
+		}
+		printf( "%-8s %10.2f %10.2f\n", its_unpack_name( kernels[ k ] ),
+				time_kernel( kernels[ k ], 0, in, block, total ),
+				time_kernel( kernels[ k ], 1, in, block, total / 4 ) );
+	}
+
+	free( in );
+	return bad;
+}
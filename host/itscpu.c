@@ -0,0 +1,218 @@
+/*
+ * itscpu: CPU headroom of an image built with ITS_FX3_CPU_LOAD.
+ *
+ *   itscpu [-u] [-p period us] [-w window ms] [-s seconds] [-S]
+ *
+ * Starts the load sampler with CMD_CPU_LOAD, polls CMD_READ_CPU_LOAD every
+ * half window and prints every window closed: busy is everything but the
+ * scheduler idle loop, irq the samples found in an interrupt handler or
+ * held off by one, then the share of each thread seen. The sampler's own
+ * handler time is printed apart, it is not in busy. -S streams at full
+ * rate meanwhile, which is the load the headroom is wanted for. The
+ * summary gives the mean and peak busy over all windows and the mean share
+ * of every thread. Without -u the loopback device answers, which has no
+ * firmware to sample.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "itsfx3.h"
+
+typedef struct cpu_totals {
+	unsigned windows;
+	unsigned missed;
+	uint64_t samples;
+	uint64_t idle;
+	uint64_t irq;
+	uint64_t other;
+	uint64_t thread[ CPU_LOAD_THREADS ];
+	double   peak_busy;
+	double   sampler;
+} cpu_totals;
+
+static double now_sec( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double pct( uint64_t part, uint64_t whole )
+{
+	return whole ? 100.0 * part / whole : 0;
+}
+
+static void print_window( const CpuLoadStatus_t* st, const CpuLoadWindow_t* w, cpu_totals* tot )
+{
+	double window_ticks = (double)w->samples * st->period_us * 1e-6 * st->tick_hz;
+	double busy = 100.0 - pct( w->idle, w->samples );
+	unsigned i;
+
+	printf( "%6lu %9lu %6.1f%% %6.1f%% %6.2f%% ", (unsigned long)w->seq, (unsigned long)w->end_ms,
+			busy, pct( w->nested + w->late, w->samples ),
+			window_ticks > 0 ? 100.0 * w->self_ticks / window_ticks : 0 );
+	for ( i = 0; i < st->threads && i < CPU_LOAD_THREADS; i++ ) {
+		if ( w->thread[ i ] )
+			printf( " %s:%.1f%%", st->name[ i ][ 0 ] ? st->name[ i ] : "?", pct( w->thread[ i ], w->samples ) );
+	}
+	if ( w->other )
+		printf( " other:%.1f%%", pct( w->other, w->samples ) );
+	printf( "\n" );
+
+	tot->windows++;
+	tot->samples += w->samples;
+	tot->idle += w->idle;
+	tot->irq += w->nested + w->late;
+	tot->other += w->other;
+	for ( i = 0; i < CPU_LOAD_THREADS; i++ )
+		tot->thread[ i ] += w->thread[ i ];
+	if ( busy > tot->peak_busy )
+		tot->peak_busy = busy;
+	if ( window_ticks > 0 )
+		tot->sampler += 100.0 * w->self_ticks / window_ticks;
+}
+
+/* Print the windows closed since seq *last, oldest first */
+static int poll_windows( its_dev* dev, CpuLoadStatus_t* st, uint32_t* last, cpu_totals* tot )
+{
+	int rc = its_read_cpu_load( dev, st );
+	int i;
+
+	if ( rc != ITS_OK )
+		return rc;
+	if ( st->window[ 0 ].seq > *last + CPU_LOAD_WINDOWS )
+		tot->missed += st->window[ 0 ].seq - *last - CPU_LOAD_WINDOWS;
+	for ( i = CPU_LOAD_WINDOWS - 1; i >= 0; i-- ) {
+		if ( st->window[ i ].seq > *last ) {
+			print_window( st, &st->window[ i ], tot );
+			*last = st->window[ i ].seq;
+		}
+	}
+	return ITS_OK;
+}
+
+static int discard_cb( const its_buffer* buf, void* user )
+{
+	(void)buf;
+	(void)user;
+	return 0;
+}
+
+int main( int argc, char** argv )
+{
+	its_stream_config config;
+	CpuLoadStatus_t st;
+	cpu_totals tot;
+	its_dev* dev = NULL;
+	unsigned period_us = 100;
+	unsigned window_ms = 1000;
+	double seconds = 10;
+	double end, next;
+	uint32_t last = 0;
+	int use_usb = 0;
+	int stream = 0;
+	int opt, rc, run;
+	unsigned i;
+
+	while ( ( opt = getopt( argc, argv, "up:w:s:Sh" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'u': use_usb = 1; break;
+		case 'p': period_us = (unsigned)atoi( optarg ); break;
+		case 'w': window_ms = (unsigned)atoi( optarg ); break;
+		case 's': seconds = atof( optarg ); break;
+		case 'S': stream = 1; break;
+		default:
+			fprintf( stderr, "usage: %s [-u] [-p period us] [-w window ms] [-s seconds] [-S]\n", argv[ 0 ] );
+			return 2;
+		}
+	}
+	if ( period_us < CPU_LOAD_MIN_US || period_us > 0xFFFF || window_ms < CPU_LOAD_MIN_WINDOW ||
+			window_ms > CPU_LOAD_MAX_WINDOW || window_ms * 1000.0 < period_us || seconds <= 0 ) {
+		fprintf( stderr, "period %d .. 65535 us, window %d .. %d ms and at least one period\n",
+				CPU_LOAD_MIN_US, CPU_LOAD_MIN_WINDOW, CPU_LOAD_MAX_WINDOW );
+		return 2;
+	}
+
+	if ( use_usb )
+		rc = its_open_usb( &dev, ITS_USB_VID, ITS_USB_PID );
+	else
+		rc = its_open_loopback( &dev, NULL );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "open: %s\n", its_strerror( rc ) );
+		return 1;
+	}
+
+	rc = its_cpu_load( dev, (uint16_t)period_us, (uint16_t)window_ms );
+	if ( rc == ITS_ERR_STALL || rc == ITS_ERR_NOT_SUPPORTED ) {
+		printf( "%s: image built without ITS_FX3_CPU_LOAD\n", use_usb ? "device" : "loopback" );
+		its_close( dev );
+		return 0;
+	}
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "cpu load: %s\n", its_strerror( rc ) );
+		its_close( dev );
+		return 1;
+	}
+	if ( stream ) {
+		its_stream_defaults( &config );
+		rc = its_stream_start( dev, &config, discard_cb, NULL );
+		if ( rc == ITS_OK )
+			rc = its_cmd_stream_start( dev );
+	}
+
+	memset( &tot, 0, sizeof( tot ) );
+	printf( "%6s %9s %7s %7s %7s  threads\n", "window", "end ms", "busy", "irq", "sampler" );
+	end = now_sec() + seconds;
+	next = now_sec() + window_ms * 0.5e-3;
+	while ( rc == ITS_OK && now_sec() < end ) {
+		if ( stream ) {
+			run = its_stream_run( dev, 100 );
+			if ( run < 0 )
+				rc = run;
+			else if ( run == 0 )
+				break;
+		} else {
+			usleep( (useconds_t)( window_ms * 500 ) );
+		}
+		if ( rc == ITS_OK && now_sec() >= next ) {
+			rc = poll_windows( dev, &st, &last, &tot );
+			next = now_sec() + window_ms * 0.5e-3;
+		}
+	}
+	if ( stream ) {
+		its_stream_stop( dev );
+		its_cmd_stream_stop( dev );
+	}
+	if ( rc == ITS_OK )
+		rc = poll_windows( dev, &st, &last, &tot );
+	its_cpu_load( dev, 0, 0 );
+	its_close( dev );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "cpu load: %s\n", its_strerror( rc ) );
+		return 1;
+	}
+
+	if ( tot.windows == 0 ) {
+		printf( "no window closed\n" );
+		return 0;
+	}
+	printf( "\n%u windows of %u ms, %u missed, sample every %u us, late above %.2f us\n",
+			tot.windows, window_ms, tot.missed, period_us,
+			st.tick_hz ? ( (double)st.min_ticks + st.late_ticks ) * 1e6 / st.tick_hz : 0 );
+	printf( "busy %.1f%% mean, %.1f%% peak, headroom %.1f%%; irq %.1f%%, sampler %.2f%%\n",
+			100.0 - pct( tot.idle, tot.samples ), tot.peak_busy, 100.0 - tot.peak_busy,
+			pct( tot.irq, tot.samples ), tot.sampler / tot.windows );
+	for ( i = 0; i < st.threads && i < CPU_LOAD_THREADS; i++ ) {
+		printf( "  %-16s %6.1f%%\n", st.name[ i ][ 0 ] ? st.name[ i ] : "?",
+				pct( tot.thread[ i ], tot.samples ) );
+	}
+	if ( tot.other )
+		printf( "  %-16s %6.1f%%\n", "other threads", pct( tot.other, tot.samples ) );
+	return 0;
+}
@@ -0,0 +1,447 @@
+/*
+ * ItsFx3 host library core: stream ring and vendor commands.
+ * The device backends are itsfx3_loopback.c and itsfx3_usb.c.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "itsfx3_priv.h"
+
+#define REQ_IN   ( 1 )
+#define REQ_OUT  ( 0 )
+
+const char* its_strerror( int err )
+{
+	switch ( err ) {
+	case ITS_OK:                return "ok";
+	case ITS_ERR_ARG:           return "invalid argument";
+	case ITS_ERR_NO_DEVICE:     return "no device";
+	case ITS_ERR_IO:            return "i/o error";
+	case ITS_ERR_TIMEOUT:       return "timeout";
+	case ITS_ERR_NO_MEM:        return "out of memory";
+	case ITS_ERR_BUSY:          return "stream running";
+	case ITS_ERR_STALL:         return "rejected by the device";
+	case ITS_ERR_NOT_SUPPORTED: return "not supported";
+	case ITS_ERR_FORMAT:        return "bad recording";
+	}
+	return "unknown error";
+}
+
+#ifndef ITS_WITH_LIBUSB
+int its_open_usb( its_dev** dev, uint16_t vid, uint16_t pid )
+{
+	(void)dev;
+	(void)vid;
+	(void)pid;
+	return ITS_ERR_NOT_SUPPORTED;
+}
+#endif
+
+void its_close( its_dev* dev )
+{
+	if ( !dev )
+		return;
+	its_stream_stop( dev );
+	dev->backend->close( dev );
+	free( dev );
+}
+
+/* ---- Streaming ---- */
+
+void its_stream_defaults( its_stream_config* config )
+{
+	config->transfers = 32;
+	config->transfer_size = 1024 * 1024;
+	config->timeout_ms = 1000;
+}
+
+static void its_stream_free( its_dev* dev )
+{
+	unsigned i;
+
+	for ( i = 0; i < dev->xfer_count; i++ )
+		dev->backend->xfer_free( dev, &dev->xfers[ i ] );
+	free( dev->xfers );
+	dev->xfers = NULL;
+	dev->xfer_count = 0;
+}
+
+static void its_stream_fail( its_dev* dev, int err )
+{
+	if ( dev->stats.error == 0 )
+		dev->stats.error = err;
+	dev->running = 0;
+}
+
+void its_xfer_done( its_xfer* xfer )
+{
+	its_dev* dev = xfer->dev;
+	its_buffer buf;
+	int rc;
+
+	xfer->in_flight = 0;
+	dev->in_flight--;
+
+	switch ( xfer->status ) {
+	case ITS_XFER_OK:
+		if ( !dev->running )
+			return;
+		if ( xfer->actual > 0 ) {
+			buf.data = xfer->buf;
+			buf.length = xfer->actual;
+			buf.offset = dev->stats.bytes;
+			buf.seq = dev->stats.buffers;
+			dev->stats.bytes += xfer->actual;
+			dev->stats.buffers++;
+			if ( xfer->actual < xfer->size )
+				dev->stats.short_buffers++;
+			if ( dev->cb( &buf, dev->user ) != 0 ) {
+				dev->running = 0;
+				return;
+			}
+		}
+		break;
+	case ITS_XFER_TIMEOUT:
+		dev->stats.timeouts++;
+		break;
+	case ITS_XFER_CANCELLED:
+		return;
+	default:
+		its_stream_fail( dev, ITS_ERR_IO );
+		return;
+	}
+
+	if ( !dev->running )
+		return;
+	rc = dev->backend->submit( dev, xfer, dev->timeout_ms );
+	if ( rc != ITS_OK ) {
+		its_stream_fail( dev, rc );
+		return;
+	}
+	xfer->in_flight = 1;
+	dev->in_flight++;
+}
+
+int its_stream_start( its_dev* dev, const its_stream_config* config, its_stream_cb cb, void* user )
+{
+	its_stream_config def;
+	unsigned i;
+	int rc;
+
+	if ( !dev || !cb )
+		return ITS_ERR_ARG;
+	if ( dev->xfers )
+		return ITS_ERR_BUSY;
+	if ( !config ) {
+		its_stream_defaults( &def );
+		config = &def;
+	}
+	if ( config->transfers == 0 || config->transfer_size == 0 || config->transfer_size % 1024 != 0 )
+		return ITS_ERR_ARG;
+
+	dev->xfers = calloc( config->transfers, sizeof( its_xfer ) );
+	if ( !dev->xfers )
+		return ITS_ERR_NO_MEM;
+	for ( i = 0; i < config->transfers; i++ ) {
+		dev->xfers[ i ].dev = dev;
+		dev->xfers[ i ].size = config->transfer_size;
+		rc = dev->backend->xfer_init( dev, &dev->xfers[ i ] );
+		if ( rc != ITS_OK ) {
+			dev->xfer_count = i;
+			its_stream_free( dev );
+			return rc;
+		}
+	}
+	dev->xfer_count = config->transfers;
+	dev->transfer_size = config->transfer_size;
+	dev->timeout_ms = config->timeout_ms;
+	dev->cb = cb;
+	dev->user = user;
+	dev->in_flight = 0;
+	memset( &dev->stats, 0, sizeof( dev->stats ) );
+	dev->running = 1;
+
+	for ( i = 0; i < dev->xfer_count; i++ ) {
+		rc = dev->backend->submit( dev, &dev->xfers[ i ], dev->timeout_ms );
+		if ( rc != ITS_OK ) {
+			its_stream_fail( dev, rc );
+			its_stream_stop( dev );
+			return rc;
+		}
+		dev->xfers[ i ].in_flight = 1;
+		dev->in_flight++;
+	}
+	return ITS_OK;
+}
+
+int its_stream_run( its_dev* dev, int timeout_ms )
+{
+	int rc;
+
+	if ( !dev || !dev->xfers )
+		return 0;
+	if ( !dev->running )
+		return dev->stats.error ? dev->stats.error : 0;
+
+	rc = dev->backend->handle_events( dev, timeout_ms );
+	if ( rc != ITS_OK && rc != ITS_ERR_TIMEOUT ) {
+		its_stream_fail( dev, rc );
+		return rc;
+	}
+	if ( !dev->running )
+		return dev->stats.error ? dev->stats.error : 0;
+	return 1;
+}
+
+int its_stream_stop( its_dev* dev )
+{
+	unsigned i;
+
+	if ( !dev || !dev->xfers )
+		return ITS_OK;
+
+	dev->running = 0;
+	for ( i = 0; i < dev->xfer_count; i++ ) {
+		if ( dev->xfers[ i ].in_flight )
+			dev->backend->cancel( dev, &dev->xfers[ i ] );
+	}
+	while ( dev->in_flight > 0 ) {
+		if ( dev->backend->handle_events( dev, 100 ) == ITS_ERR_NO_DEVICE )
+			break;
+	}
+	its_stream_free( dev );
+	return dev->stats.error;
+}
+
+void its_stream_get_stats( its_dev* dev, its_stream_stats* stats )
+{
+	*stats = dev->stats;
+}
+
+int its_read_sync( its_dev* dev, void* buf, size_t len, size_t* actual, int timeout_ms )
+{
+	if ( !dev || !buf )
+		return ITS_ERR_ARG;
+	return dev->backend->bulk_read( dev, buf, len, actual, timeout_ms );
+}
+
+/* ---- Vendor commands ---- */
+
+static int its_out( its_dev* dev, uint8_t request, uint16_t value, uint16_t index )
+{
+	int rc = dev->backend->control( dev, REQ_OUT, request, value, index, NULL, 0 );
+	return ( rc < 0 ) ? rc : ITS_OK;
+}
+
+/* IN request expecting exactly len bytes */
+static int its_in( its_dev* dev, uint8_t request, uint16_t value, void* data, uint16_t len )
+{
+	int rc = dev->backend->control( dev, REQ_IN, request, value, 0, data, len );
+	if ( rc < 0 )
+		return rc;
+	return ( rc == len ) ? ITS_OK : ITS_ERR_IO;
+}
+
+int its_get_version( its_dev* dev, uint32_t* version )
+{
+	FirmwareDescription_t desc;
+	int rc = its_in( dev, CMD_GET_VERSION, 0, &desc, sizeof( desc ) );
+	if ( rc == ITS_OK )
+		*version = desc.version;
+	return rc;
+}
+
+int its_read_debug_info( its_dev* dev, uint32_t info[ 8 ] )
+{
+	return its_in( dev, CMD_READ_DEBUG_INFO, 0, info, 8 * sizeof( uint32_t ) );
+}
+
+int its_reg_write( its_dev* dev, uint8_t b0, uint8_t b1 )
+{
+	uint8_t data[ 2 ] = { b0, b1 };
+	int rc = dev->backend->control( dev, REQ_OUT, CMD_REG_WRITE, 0, 0, data, sizeof( data ) );
+	return ( rc < 0 ) ? rc : ITS_OK;
+}
+
+int its_reg_read( its_dev* dev, uint8_t b0, uint8_t b1, uint8_t reply[ 2 ] )
+{
+	int rc = dev->backend->control( dev, REQ_IN, CMD_REG_READ, b0, b1, reply, 2 );
+	if ( rc < 0 )
+		return rc;
+	return ( rc == 2 ) ? ITS_OK : ITS_ERR_IO;
+}
+
+int its_device_reset( its_dev* dev )
+{
+	return its_out( dev, CMD_CYPRESS_RESET, 0, 0 );
+}
+
+int its_read_usb_errors( its_dev* dev, UsbErrorStats_t* stats )
+{
+	return its_in( dev, CMD_READ_USB_ERRORS, 0, stats, sizeof( *stats ) );
+}
+
+int its_set_lpm_policy( its_dev* dev, uint8_t policy )
+{
+	return its_out( dev, CMD_SET_LPM_POLICY, policy, 0 );
+}
+
+int its_read_lpm_stats( its_dev* dev, LpmStats_t* stats )
+{
+	return its_in( dev, CMD_READ_LPM_STATS, 0, stats, sizeof( *stats ) );
+}
+
+int its_get_stream_status( its_dev* dev, StreamStatus_t* status )
+{
+	return its_in( dev, CMD_GET_STREAM_STATUS, 0, status, sizeof( *status ) );
+}
+
+int its_cmd_stream_start( its_dev* dev )
+{
+	return its_out( dev, CMD_STREAM_START, 0, 0 );
+}
+
+int its_cmd_stream_stop( its_dev* dev )
+{
+	return its_out( dev, CMD_STREAM_STOP, 0, 0 );
+}
+
+int its_stream_arm( its_dev* dev, uint8_t edge )
+{
+	return its_out( dev, CMD_STREAM_ARM, edge, 0 );
+}
+
+int its_read_trigger( its_dev* dev, TriggerStatus_t* status )
+{
+	return its_in( dev, CMD_READ_TRIGGER, 0, status, sizeof( *status ) );
+}
+
+int its_read_pps( its_dev* dev, PpsLog_t* log )
+{
+	return its_in( dev, CMD_READ_PPS, 0, log, sizeof( *log ) );
+}
+
+int its_read_gaps( its_dev* dev, GapLog_t* log )
+{
+	return its_in( dev, CMD_READ_GAPS, 0, log, sizeof( *log ) );
+}
+
+int its_snapshot( its_dev* dev, uint32_t length )
+{
+	return its_out( dev, CMD_SNAPSHOT, (uint16_t)length, (uint16_t)( length >> 16 ) );
+}
+
+int its_read_snapshot( its_dev* dev, SnapshotStatus_t* status )
+{
+	return its_in( dev, CMD_READ_SNAPSHOT, 0, status, sizeof( *status ) );
+}
+
+int its_pretrig_arm( its_dev* dev, uint16_t tail_bufs, uint8_t edge )
+{
+	return its_out( dev, CMD_PRETRIG_ARM, tail_bufs, edge );
+}
+
+int its_pretrig_fire( its_dev* dev )
+{
+	return its_out( dev, CMD_PRETRIG_FIRE, 0, 0 );
+}
+
+int its_read_pretrig( its_dev* dev, PretrigStatus_t* status )
+{
+	return its_in( dev, CMD_READ_PRETRIG, 0, status, sizeof( *status ) );
+}
+
+int its_decimate( its_dev* dev, uint8_t log2r )
+{
+	return its_out( dev, CMD_DECIMATE, log2r, 0 );
+}
+
+int its_read_decim( its_dev* dev, DecimStatus_t* status )
+{
+	return its_in( dev, CMD_READ_DECIM, 0, status, sizeof( *status ) );
+}
+
+int its_sample_stats( its_dev* dev, uint16_t buffers )
+{
+	return its_out( dev, CMD_SAMPLE_STATS, buffers, 0 );
+}
+
+int its_read_stats( its_dev* dev, SampleStats_t* stats )
+{
+	return its_in( dev, CMD_READ_STATS, 0, stats, sizeof( *stats ) );
+}
+
+int its_jam_config( its_dev* dev, const JamConfig_t* config )
+{
+	JamConfig_t copy = *config;
+	int rc = dev->backend->control( dev, REQ_OUT, CMD_JAM_CONFIG, 0, 0, &copy, sizeof( copy ) );
+	return ( rc < 0 ) ? rc : ITS_OK;
+}
+
+int its_read_jam( its_dev* dev, JamStatus_t* status, int clear )
+{
+	return its_in( dev, CMD_READ_JAM, clear ? 1 : 0, status, sizeof( *status ) );
+}
+
+int its_pib_clock( its_dev* dev, const PibClockConfig_t* config )
+{
+	PibClockConfig_t copy = *config;
+	int rc = dev->backend->control( dev, REQ_OUT, CMD_PIB_CLOCK, 0, 0, &copy, sizeof( copy ) );
+	return ( rc < 0 ) ? rc : ITS_OK;
+}
+
+int its_read_pib_clock( its_dev* dev, PibClockStatus_t* status )
+{
+	return its_in( dev, CMD_READ_PIB_CLOCK, 0, status, sizeof( *status ) );
+}
+
+int its_footer_stream( its_dev* dev )
+{
+	return its_out( dev, CMD_FOOTER_STREAM, 0, 0 );
+}
+
+int its_read_footer( its_dev* dev, FooterStatus_t* status )
+{
+	return its_in( dev, CMD_READ_FOOTER, 0, status, sizeof( *status ) );
+}
+
+int its_flush_deadline( its_dev* dev, uint16_t ms, uint16_t rate_kbps )
+{
+	return its_out( dev, CMD_FLUSH_DEADLINE, ms, rate_kbps );
+}
+
+int its_read_flush( its_dev* dev, FlushStatus_t* status )
+{
+	return its_in( dev, CMD_READ_FLUSH, 0, status, sizeof( *status ) );
+}
+
+int its_latency_mark( its_dev* dev, uint8_t level, LatencyMark_t* mark )
+{
+	return its_in( dev, CMD_LATENCY_MARK, level, mark, sizeof( *mark ) );
+}
+
+int its_read_profile( its_dev* dev, uint8_t region, int clear, ProfRegion_t* status )
+{
+	return its_in( dev, CMD_READ_PROFILE, region | ( clear ? PROF_READ_CLEAR : 0 ), status, sizeof( *status ) );
+}
+
+int its_pc_sample( its_dev* dev, uint16_t period_us, uint8_t shift )
+{
+	return its_out( dev, CMD_PC_SAMPLE, period_us, shift );
+}
+
+int its_read_pc_sample( its_dev* dev, uint16_t chunk, PcSampleChunk_t* status )
+{
+	return its_in( dev, CMD_READ_PC_SAMPLE, chunk, status, sizeof( *status ) );
+}
+
+int its_cpu_load( its_dev* dev, uint16_t period_us, uint16_t window_ms )
+{
+	return its_out( dev, CMD_CPU_LOAD, period_us, window_ms );
+}
+
+int its_read_cpu_load( its_dev* dev, CpuLoadStatus_t* status )
+{
+	return its_in( dev, CMD_READ_CPU_LOAD, 0, status, sizeof( *status ) );
+}
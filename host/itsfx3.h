@@ -0,0 +1,150 @@
+#ifndef ITSFX3_H_
+#define ITSFX3_H_
+
+/*
+ * Host library for the ItsFx3 firmware.
+ *
+ * Streaming keeps a ring of asynchronous bulk transfers on EP 0x81 in
+ * flight. Every filled transfer buffer is handed to the stream callback
+ * as is and resubmitted when the callback returns, nothing is copied.
+ * Callbacks run on the thread that calls its_stream_run.
+ *
+ * Every vendor command of host_commands.h has a typed call. All calls
+ * return 0 or a negative ITS_ERR_* code.
+ *
+ * Two device backends exist: a USB device through libusb (its_open_usb,
+ * built with USB=1) and a loopback stand-in that produces a synthetic
+ * stream at a modelled link rate (its_open_loopback).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "host_commands.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ITS_USB_VID             ( 0x04B4 )
+#define ITS_USB_PID             ( 0x00F1 )
+#define ITS_EP_STREAM           ( 0x81 )
+
+#define ITS_OK                  ( 0 )
+#define ITS_ERR_ARG             ( -1 )
+#define ITS_ERR_NO_DEVICE       ( -2 )
+#define ITS_ERR_IO              ( -3 )
+#define ITS_ERR_TIMEOUT         ( -4 )
+#define ITS_ERR_NO_MEM          ( -5 )
+#define ITS_ERR_BUSY            ( -6 )   /* Stream already running */
+#define ITS_ERR_STALL           ( -7 )   /* Command rejected by the firmware */
+#define ITS_ERR_NOT_SUPPORTED   ( -8 )
+#define ITS_ERR_FORMAT          ( -9 )   /* Not a recording, see itsfx3_rec.h */
+
+typedef struct its_dev its_dev;
+
+/* A filled stream buffer. Valid until the callback returns. */
+typedef struct its_buffer {
+	const uint8_t* data;
+	size_t   length;
+	uint64_t offset;        /* Stream bytes received before this buffer */
+	uint64_t seq;           /* Buffer number since its_stream_start */
+} its_buffer;
+
+/* Return 0 to continue, anything else stops the stream. */
+typedef int ( *its_stream_cb )( const its_buffer* buf, void* user );
+
+typedef struct its_stream_config {
+	unsigned transfers;     /* Transfers in flight, default 32 */
+	size_t   transfer_size; /* Bytes per transfer, multiple of 1024, default 1 MB */
+	int      timeout_ms;    /* Per transfer, 0 waits forever, default 1000 */
+} its_stream_config;
+
+typedef struct its_stream_stats {
+	uint64_t bytes;
+	uint64_t buffers;
+	uint64_t timeouts;      /* Transfers that expired and were resubmitted */
+	uint64_t short_buffers; /* Transfers completed with less than transfer_size */
+	int      error;         /* First error that stopped the stream, or 0 */
+} its_stream_stats;
+
+/* Loopback stand-in device. The stream is a sequence of little endian
+ * uint64 words holding their own byte offset, it only flows between
+ * CMD_STREAM_START and CMD_STREAM_STOP as on the real device. With a
+ * sample rate set, byte n of the stream exists n / sample_mbps after the
+ * start and CMD_FLUSH_DEADLINE sizes the device buffers as the firmware
+ * does. */
+typedef struct its_loopback_config {
+	double   link_mbps;     /* Modelled link rate in MB/s, 0 is unlimited */
+	unsigned latency_us;    /* From submit to the first byte of a transfer */
+	double   sample_mbps;   /* Front-end data rate in MB/s, 0 is unlimited */
+} its_loopback_config;
+
+/* Default link: USB 3.0 bulk IN, about 380 MB/s and 125 us turnaround,
+ * data as fast as the link takes it. */
+void its_loopback_defaults( its_loopback_config* config );
+
+int  its_open_loopback( its_dev** dev, const its_loopback_config* config );
+int  its_open_usb( its_dev** dev, uint16_t vid, uint16_t pid );
+void its_close( its_dev* dev );
+
+const char* its_strerror( int err );
+
+/* Streaming */
+void its_stream_defaults( its_stream_config* config );
+int  its_stream_start( its_dev* dev, const its_stream_config* config, its_stream_cb cb, void* user );
+/* Handle completions for up to timeout_ms. Returns 1 while the stream
+ * runs, 0 once it has stopped, or an error. */
+int  its_stream_run( its_dev* dev, int timeout_ms );
+/* Cancel the transfers in flight and wait for them. */
+int  its_stream_stop( its_dev* dev );
+void its_stream_get_stats( its_dev* dev, its_stream_stats* stats );
+
+/* One synchronous bulk read, the naive way. For comparison and tools. */
+int  its_read_sync( its_dev* dev, void* buf, size_t len, size_t* actual, int timeout_ms );
+
+/* Vendor commands, see host_commands.h */
+int  its_get_version( its_dev* dev, uint32_t* version );
+int  its_read_debug_info( its_dev* dev, uint32_t info[ 8 ] );
+int  its_reg_write( its_dev* dev, uint8_t b0, uint8_t b1 );
+int  its_reg_read( its_dev* dev, uint8_t b0, uint8_t b1, uint8_t reply[ 2 ] );
+int  its_device_reset( its_dev* dev );
+int  its_read_usb_errors( its_dev* dev, UsbErrorStats_t* stats );
+int  its_set_lpm_policy( its_dev* dev, uint8_t policy );
+int  its_read_lpm_stats( its_dev* dev, LpmStats_t* stats );
+int  its_get_stream_status( its_dev* dev, StreamStatus_t* status );
+int  its_cmd_stream_start( its_dev* dev );
+int  its_cmd_stream_stop( its_dev* dev );
+int  its_stream_arm( its_dev* dev, uint8_t edge );
+int  its_read_trigger( its_dev* dev, TriggerStatus_t* status );
+int  its_read_pps( its_dev* dev, PpsLog_t* log );
+int  its_read_gaps( its_dev* dev, GapLog_t* log );
+int  its_snapshot( its_dev* dev, uint32_t length );
+int  its_read_snapshot( its_dev* dev, SnapshotStatus_t* status );
+int  its_pretrig_arm( its_dev* dev, uint16_t tail_bufs, uint8_t edge );
+int  its_pretrig_fire( its_dev* dev );
+int  its_read_pretrig( its_dev* dev, PretrigStatus_t* status );
+int  its_decimate( its_dev* dev, uint8_t log2r );
+int  its_read_decim( its_dev* dev, DecimStatus_t* status );
+int  its_sample_stats( its_dev* dev, uint16_t buffers );
+int  its_read_stats( its_dev* dev, SampleStats_t* stats );
+int  its_jam_config( its_dev* dev, const JamConfig_t* config );
+int  its_read_jam( its_dev* dev, JamStatus_t* status, int clear );
+int  its_pib_clock( its_dev* dev, const PibClockConfig_t* config );
+int  its_read_pib_clock( its_dev* dev, PibClockStatus_t* status );
+int  its_footer_stream( its_dev* dev );
+int  its_read_footer( its_dev* dev, FooterStatus_t* status );
+int  its_flush_deadline( its_dev* dev, uint16_t ms, uint16_t rate_kbps );
+int  its_read_flush( its_dev* dev, FlushStatus_t* status );
+int  its_latency_mark( its_dev* dev, uint8_t level, LatencyMark_t* mark );
+int  its_read_profile( its_dev* dev, uint8_t region, int clear, ProfRegion_t* status );
+int  its_pc_sample( its_dev* dev, uint16_t period_us, uint8_t shift );
+int  its_read_pc_sample( its_dev* dev, uint16_t chunk, PcSampleChunk_t* status );
+int  its_cpu_load( its_dev* dev, uint16_t period_us, uint16_t window_ms );
+int  its_read_cpu_load( its_dev* dev, CpuLoadStatus_t* status );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ITSFX3_H_ */
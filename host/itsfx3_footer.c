@@ -0,0 +1,83 @@
+/*
+ * Footer stream verifier, see itsfx3_footer.h.
+ *
+ * A piece is split at the payload and footer boundaries of the buffers it
+ * covers. Payload goes through CyFxFooterSum straight from the transfer
+ * buffer, only the 16 footer bytes are copied, as a footer may straddle
+ * two transfers.
+ */
+
+#include <string.h>
+
+#include "itsfx3.h"
+#include "itsfx3_footer.h"
+
+int its_footer_init( its_footer_check* chk, size_t buf_size )
+{
+	if ( !chk || buf_size <= STREAM_FOOTER_SIZE || buf_size % 4 != 0 ||
+			buf_size - STREAM_FOOTER_SIZE > 0xFFFF )
+		return ITS_ERR_ARG;
+	memset( chk, 0, sizeof( *chk ) );
+	chk->buf_size = buf_size;
+	return ITS_OK;
+}
+
+static void footer_check( its_footer_check* chk )
+{
+	StreamFooter_t footer;
+	size_t payload = chk->buf_size - STREAM_FOOTER_SIZE;
+
+	memcpy( &footer, chk->footer, sizeof( footer ) );
+	chk->buffers++;
+	chk->payload_bytes += payload;
+
+	if ( footer.magic != STREAM_FOOTER_MAGIC || footer.bytes != payload ) {
+		/* Nothing else in it can be trusted */
+		chk->bad_footers++;
+	} else {
+		if ( footer.sum_a != chk->sum.a || footer.sum_b != chk->sum.b )
+			chk->bad_sums++;
+		if ( chk->synced && footer.sequence != chk->sequence )
+			chk->seq_gaps++;
+		chk->sequence = footer.sequence + 1;
+		chk->synced = 1;
+	}
+
+	chk->fill = 0;
+	chk->sum.a = 0;
+	chk->sum.b = 0;
+}
+
+int its_footer_feed( its_footer_check* chk, const uint8_t* data, size_t len )
+{
+	size_t payload = chk->buf_size - STREAM_FOOTER_SIZE;
+	size_t n;
+
+	if ( ( (uintptr_t)data | len ) & 3 )
+		return ITS_ERR_ARG;
+
+	while ( len > 0 ) {
+		if ( chk->fill < payload ) {
+			n = payload - chk->fill;
+			if ( n > len )
+				n = len;
+			CyFxFooterSum( &chk->sum, data, (uint32_t)n );
+		} else {
+			n = chk->buf_size - chk->fill;
+			if ( n > len )
+				n = len;
+			memcpy( chk->footer + ( chk->fill - payload ), data, n );
+		}
+		chk->fill += n;
+		data += n;
+		len -= n;
+		if ( chk->fill == chk->buf_size )
+			footer_check( chk );
+	}
+	return ITS_OK;
+}
+
+uint64_t its_footer_errors( const its_footer_check* chk )
+{
+	return chk->bad_sums + chk->bad_footers + chk->seq_gaps;
+}
@@ -0,0 +1,53 @@
+#ifndef ITSFX3_FOOTER_H_
+#define ITSFX3_FOOTER_H_
+
+/*
+ * Verifier for the footer stream of CMD_FOOTER_STREAM.
+ *
+ * The stream is a sequence of DMA buffers of buf_size bytes, each payload
+ * followed by a StreamFooter_t. The checker is fed the stream in pieces as
+ * it arrives and sums the payload with the firmware's footer_sum.c while
+ * it passes, so every byte is read once. Buffers are found by counting,
+ * which holds as long as no USB transfer ends short.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "host_commands.h"
+#include "footer_sum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct its_footer_check {
+	size_t   buf_size;      /* Payload + footer, the firmware DMA buffer */
+	size_t   fill;          /* Bytes of the current buffer seen */
+	FooterSum_t sum;
+	uint8_t  footer[ STREAM_FOOTER_SIZE ];
+	uint32_t sequence;      /* Expected in the next footer */
+	int      synced;        /* A footer has been seen */
+
+	uint64_t buffers;
+	uint64_t payload_bytes;
+	uint64_t bad_sums;      /* Payload does not match its footer */
+	uint64_t bad_footers;   /* Wrong magic or payload length */
+	uint64_t seq_gaps;      /* Sequence did not follow the previous one */
+} its_footer_check;
+
+/* buf_size 16384 at SuperSpeed, 8192 at high speed. */
+int  its_footer_init( its_footer_check* chk, size_t buf_size );
+
+/* Check the next len bytes of the stream. data 4 byte aligned and len a
+ * multiple of 4, as every bulk transfer of the stream is. */
+int  its_footer_feed( its_footer_check* chk, const uint8_t* data, size_t len );
+
+/* Bad sums, bad footers and sequence gaps */
+uint64_t its_footer_errors( const its_footer_check* chk );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ITSFX3_FOOTER_H_ */
@@ -0,0 +1,740 @@
+/*
+ * Loopback stand-in for an ItsFx3 device.
+ *
+ * A device thread serves bulk requests in submit order, as the host
+ * controller does for one endpoint. A request cannot start before
+ * latency_us after its submission nor before the previous one has ended,
+ * and takes length / link_mbps. So a single synchronous read pays the
+ * turnaround every time while a deep queue keeps the link busy, which is
+ * what separates the two on real hardware.
+ *
+ * The stream is little endian uint64 words holding their own byte offset
+ * since CMD_STREAM_START. Vendor requests are answered from a small model:
+ * stream start/stop, version and stream status, a single 8 bit GPIF
+ * configuration, the PIB clock on a 403.2 MHz system clock, zeros for the
+ * other status replies.
+ *
+ * CMD_FOOTER_STREAM starts the stream in footer mode: LB_FOOTER_BUF byte
+ * device buffers, each the offset pattern of the payload bytes alone
+ * followed by a StreamFooter_t, as the firmware sends them at SuperSpeed.
+ *
+ * With sample_mbps set a request also cannot end before its last byte
+ * exists. Under CMD_FLUSH_DEADLINE the device buffers are sized from the
+ * deadline and the given rate as in stream_flush.c. Smaller than
+ * LB_DEVICE_BUF they end in a short packet, a request ends short at the
+ * first buffer end after its first byte.
+ *
+ * CMD_LATENCY_MARK drives a marker line looped to data line LB_MARK_LINE
+ * of the 8 bit bus: from the first mark on, that bit of every stream byte
+ * is the line level, switching at the byte being produced when the mark
+ * was set. Requests are filled when they end so marks set while they wait
+ * show in them. The footer stream carries no marker.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "itsfx3_priv.h"
+#include "footer_sum.h"
+
+#define LB_VERSION  ( 0x26101900 )
+#define LB_SYS_HZ   ( 403200000u )
+#define LB_FOOTER_BUF     ( 16384 )
+#define LB_FOOTER_PAYLOAD ( LB_FOOTER_BUF - STREAM_FOOTER_SIZE )
+#define LB_DEVICE_BUF     ( 16384 )
+#define LB_MARK_LINE      ( 7 )
+#define LB_MARKS          ( 64 )
+
+typedef struct lb_req {
+	struct lb_req* next;
+	its_xfer* xfer;         /* NULL for a synchronous read */
+	uint8_t* buf;
+	size_t   len;
+	size_t   actual;
+	int      status;
+	int      done;
+	int      cancel;
+	int      timeout_ms;
+	uint64_t submit_ns;
+} lb_req;
+
+typedef struct lb_dev {
+	its_loopback_config config;
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t work;    /* New request, cancel, stream start, quit */
+	pthread_cond_t done;    /* Request completed */
+	lb_req* pending;
+	lb_req* pending_tail;
+	lb_req* completed;
+	lb_req* completed_tail;
+	int      quit;
+	int      streaming;
+	int      footer;        /* Started by CMD_FOOTER_STREAM */
+	uint32_t starts;
+	uint64_t offset;        /* Stream bytes produced since start */
+	uint64_t start_ns;      /* Of the stream */
+	uint16_t flush_ms;      /* CMD_FLUSH_DEADLINE */
+	uint16_t flush_kbps;
+	uint32_t flush_buf;     /* Device buffer under the deadline */
+	uint64_t link_free_ns;  /* End of the last transfer on the link */
+	uint64_t filled;        /* Stream bytes filled into requests */
+	int      marked;        /* The marker line shows in the stream */
+	uint8_t  mark_level;
+	uint32_t mark_seq;
+	unsigned mark_count;    /* Level changes of the stream still ahead of filled */
+	uint64_t mark_at[ LB_MARKS ];
+	uint8_t  mark_to[ LB_MARKS ];
+	PibClockStatus_t pib;
+	uint8_t  scratch[ LB_FOOTER_BUF ] __attribute__(( aligned( 8 ) ));  /* Device thread only */
+} lb_dev;
+
+static uint64_t lb_now_ns( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static struct timespec lb_timespec( uint64_t ns )
+{
+	struct timespec ts;
+	ts.tv_sec = (time_t)( ns / 1000000000ull );
+	ts.tv_nsec = (long)( ns % 1000000000ull );
+	return ts;
+}
+
+/* Buffer size for a deadline as CyFxFlushBufferSize in stream_flush.c. */
+static uint32_t lb_flush_buf( uint16_t ms, uint16_t kbps )
+{
+	uint32_t bytes = (uint32_t)kbps * ms;
+
+	if ( ms == 0 || bytes >= LB_DEVICE_BUF )
+		return LB_DEVICE_BUF;
+	bytes -= bytes % 16;
+	if ( bytes % 64 == 0 )
+		bytes -= 16;
+	return bytes < 16 ? 16 : bytes;
+}
+
+/* Same checks and rate as pib_clock.c in the firmware. */
+static uint32_t lb_pib_check( const PibClockConfig_t* config, uint32_t* pib_hz )
+{
+	static const uint8_t shift[] = { 4, 2, 1, 0 };
+
+	*pib_hz = 0;
+	if ( config->source > PIB_CLK_SRC_SYS || config->div < PIB_CLK_DIV_MIN ||
+			config->div > PIB_CLK_DIV_MAX || config->half_div > 1 || config->dll > 1 )
+		return PIB_CLK_BAD_ARGUMENT;
+	*pib_hz = (uint32_t)( ( (uint64_t)( LB_SYS_HZ >> shift[ config->source ] ) * 2 ) /
+			( config->div * 2u + config->half_div ) );
+	if ( config->sample_khz != 0 && *pib_hz < config->sample_khz * 1000ull )
+		return PIB_CLK_TOO_SLOW;
+	return PIB_CLK_OK;
+}
+
+static void lb_fill( uint8_t* buf, size_t len, uint64_t offset )
+{
+	size_t i;
+	uint64_t w;
+
+	for ( i = 0; i + 8 <= len; i += 8 ) {
+		w = offset + i;
+		memcpy( buf + i, &w, 8 );
+	}
+	for ( ; i < len; i++ ) {
+		w = ( offset + i ) & ~7ull;
+		buf[ i ] = (uint8_t)( w >> ( 8 * ( i & 7 ) ) );
+	}
+}
+
+/* Device buffer k of a footer stream */
+static void lb_footer_buffer( uint8_t* buf, uint64_t k )
+{
+	StreamFooter_t footer;
+	FooterSum_t sum = { 0, 0 };
+
+	lb_fill( buf, LB_FOOTER_PAYLOAD, k * LB_FOOTER_PAYLOAD );
+	CyFxFooterSum( &sum, buf, LB_FOOTER_PAYLOAD );
+	footer.sequence = (uint32_t)k;
+	footer.bytes = LB_FOOTER_PAYLOAD;
+	footer.magic = STREAM_FOOTER_MAGIC;
+	footer.sum_a = sum.a;
+	footer.sum_b = sum.b;
+	memcpy( buf + LB_FOOTER_PAYLOAD, &footer, sizeof( footer ) );
+}
+
+/* Whole device buffers are built in place, partly covered ones in the
+ * scratch buffer. */
+static void lb_fill_footer( lb_dev* lb, uint8_t* buf, size_t len, uint64_t offset )
+{
+	uint64_t k;
+	size_t at, n;
+
+	while ( len > 0 ) {
+		k = offset / LB_FOOTER_BUF;
+		at = (size_t)( offset % LB_FOOTER_BUF );
+		n = LB_FOOTER_BUF - at;
+		if ( n > len )
+			n = len;
+		if ( n == LB_FOOTER_BUF && ( (uintptr_t)buf & 3 ) == 0 ) {
+			lb_footer_buffer( buf, k );
+		} else {
+			lb_footer_buffer( lb->scratch, k );
+			memcpy( buf, lb->scratch + at, n );
+		}
+		buf += n;
+		len -= n;
+		offset += n;
+	}
+}
+
+/* Set the marker line in a filled piece of the stream. mark_at[ i ] is
+ * where the line changes to mark_to[ i ], in offset order. */
+static void lb_fill_marks( uint8_t* buf, size_t len, uint64_t offset,
+		const uint64_t* mark_at, const uint8_t* mark_to, unsigned count )
+{
+	uint64_t from, until;
+	unsigned i;
+	size_t k;
+
+	for ( i = 0; i < count; i++ ) {
+		from = mark_at[ i ] > offset ? mark_at[ i ] : offset;
+		until = i + 1 < count ? mark_at[ i + 1 ] : UINT64_MAX;
+		if ( until > offset + len )
+			until = offset + len;
+		if ( from >= until )
+			continue;
+		for ( k = (size_t)( from - offset ); k < (size_t)( until - offset ); k++ ) {
+			if ( mark_to[ i ] )
+				buf[ k ] |= 1u << LB_MARK_LINE;
+			else
+				buf[ k ] &= (uint8_t)~( 1u << LB_MARK_LINE );
+		}
+	}
+}
+
+/* Record a level change at offset. Changes only needed for bytes before
+ * filled are dropped. Lock held. */
+static void lb_mark_push( lb_dev* lb, uint64_t offset, uint8_t level )
+{
+	while ( lb->mark_count > 1 && lb->mark_at[ 1 ] <= lb->filled ) {
+		memmove( lb->mark_at, lb->mark_at + 1, ( lb->mark_count - 1 ) * sizeof( lb->mark_at[ 0 ] ) );
+		memmove( lb->mark_to, lb->mark_to + 1, lb->mark_count - 1 );
+		lb->mark_count--;
+	}
+	if ( lb->mark_count == LB_MARKS ) {
+		memmove( lb->mark_at, lb->mark_at + 1, ( LB_MARKS - 1 ) * sizeof( lb->mark_at[ 0 ] ) );
+		memmove( lb->mark_to, lb->mark_to + 1, LB_MARKS - 1 );
+		lb->mark_count--;
+	}
+	lb->mark_at[ lb->mark_count ] = offset;
+	lb->mark_to[ lb->mark_count ] = level;
+	lb->mark_count++;
+}
+
+static void lb_push( lb_req** head, lb_req** tail, lb_req* r )
+{
+	r->next = NULL;
+	if ( *tail )
+		( *tail )->next = r;
+	else
+		*head = r;
+	*tail = r;
+}
+
+/* Time at which the first n stream bytes exist, with a sample rate set */
+static uint64_t lb_produced_ns( const lb_dev* lb, uint64_t n )
+{
+	return lb->start_ns + (uint64_t)( (double)n * 1000.0 / lb->config.sample_mbps );
+}
+
+/* Bytes of a request at offset the device has sent by the time it can
+ * end, and that time. Lock held. */
+static size_t lb_available( lb_dev* lb, uint64_t offset, size_t len, uint64_t* ready_ns )
+{
+	size_t n;
+
+	*ready_ns = 0;
+	if ( lb->config.sample_mbps <= 0 )
+		return len;
+	*ready_ns = lb_produced_ns( lb, offset + len );
+	if ( lb->footer || lb->flush_buf >= LB_DEVICE_BUF )
+		return len;
+
+	n = (size_t)( ( offset / lb->flush_buf + 1 ) * lb->flush_buf - offset );
+	if ( n >= len )
+		return len;
+	*ready_ns = lb_produced_ns( lb, offset + n );
+	return n;
+}
+
+/* Called with the lock held */
+static void lb_complete( lb_dev* lb, lb_req* r, int status )
+{
+	r->status = status;
+	r->done = 1;
+	if ( r->xfer )
+		lb_push( &lb->completed, &lb->completed_tail, r );
+	pthread_cond_broadcast( &lb->done );
+}
+
+static void* lb_thread( void* arg )
+{
+	lb_dev* lb = arg;
+	lb_req* r;
+	uint64_t now, start, end, deadline, offset, ready;
+	uint64_t mark_at[ LB_MARKS ];
+	uint8_t mark_to[ LB_MARKS ];
+	unsigned marks;
+	struct timespec ts;
+	size_t actual;
+	int footer;
+
+	pthread_mutex_lock( &lb->lock );
+	while ( !lb->quit ) {
+		r = lb->pending;
+		if ( !r ) {
+			pthread_cond_wait( &lb->work, &lb->lock );
+			continue;
+		}
+		if ( r->cancel ) {
+			lb->pending = r->next;
+			if ( !lb->pending )
+				lb->pending_tail = NULL;
+			lb_complete( lb, r, ITS_XFER_CANCELLED );
+			continue;
+		}
+
+		now = lb_now_ns();
+		if ( !lb->streaming ) {
+			/* No data, the request waits for a stream start or expires. */
+			if ( r->timeout_ms > 0 ) {
+				deadline = r->submit_ns + (uint64_t)r->timeout_ms * 1000000ull;
+				if ( now >= deadline ) {
+					lb->pending = r->next;
+					if ( !lb->pending )
+						lb->pending_tail = NULL;
+					lb_complete( lb, r, ITS_XFER_TIMEOUT );
+					continue;
+				}
+				ts = lb_timespec( deadline );
+				pthread_cond_timedwait( &lb->work, &lb->lock, &ts );
+			} else {
+				pthread_cond_wait( &lb->work, &lb->lock );
+			}
+			continue;
+		}
+
+		lb->pending = r->next;
+		if ( !lb->pending )
+			lb->pending_tail = NULL;
+
+		offset = lb->offset;
+		actual = lb_available( lb, offset, r->len, &ready );
+		start = r->submit_ns + (uint64_t)lb->config.latency_us * 1000ull;
+		if ( start < lb->link_free_ns )
+			start = lb->link_free_ns;
+		end = start;
+		if ( lb->config.link_mbps > 0 )
+			end += (uint64_t)( (double)actual * 1000.0 / lb->config.link_mbps );
+		if ( end < ready )
+			end = ready;
+		lb->link_free_ns = end;
+		lb->offset += actual;
+
+		/* A cancel ends the wait, slow streams leave requests open long */
+		ts = lb_timespec( end );
+		while ( !r->cancel && !lb->quit && lb_now_ns() < end )
+			pthread_cond_timedwait( &lb->work, &lb->lock, &ts );
+
+		if ( !r->cancel ) {
+			/* Later marks go after this request */
+			lb->filled = offset + actual;
+			footer = lb->footer;
+			marks = footer ? 0 : lb->mark_count;
+			memcpy( mark_at, lb->mark_at, marks * sizeof( mark_at[ 0 ] ) );
+			memcpy( mark_to, lb->mark_to, marks );
+			pthread_mutex_unlock( &lb->lock );
+
+			if ( footer ) {
+				lb_fill_footer( lb, r->buf, actual, offset );
+			} else {
+				lb_fill( r->buf, actual, offset );
+				lb_fill_marks( r->buf, actual, offset, mark_at, mark_to, marks );
+			}
+			pthread_mutex_lock( &lb->lock );
+		}
+		r->actual = actual;
+		lb_complete( lb, r, r->cancel ? ITS_XFER_CANCELLED : ITS_XFER_OK );
+	}
+	pthread_mutex_unlock( &lb->lock );
+	return NULL;
+}
+
+static void lb_enqueue( lb_dev* lb, lb_req* r, int timeout_ms )
+{
+	r->done = 0;
+	r->cancel = 0;
+	r->actual = 0;
+	r->timeout_ms = timeout_ms;
+	r->submit_ns = lb_now_ns();
+	lb_push( &lb->pending, &lb->pending_tail, r );
+	pthread_cond_signal( &lb->work );
+}
+
+static int lb_control( its_dev* dev, int in, uint8_t request, uint16_t value, uint16_t index,
+		void* data, uint16_t len )
+{
+	lb_dev* lb = dev->priv;
+	uint8_t reply[ 512 ];
+	size_t n = 0;
+
+	if ( len > sizeof( reply ) )
+		return ITS_ERR_ARG;
+	memset( reply, 0, sizeof( reply ) );
+
+	pthread_mutex_lock( &lb->lock );
+	switch ( request ) {
+	case CMD_GET_VERSION: {
+		FirmwareDescription_t desc;
+		memset( &desc, 0, sizeof( desc ) );
+		desc.version = LB_VERSION;
+		memcpy( reply, &desc, sizeof( desc ) );
+		n = sizeof( desc );
+		break;
+	}
+	case CMD_GET_STREAM_STATUS: {
+		StreamStatus_t status;
+		memset( &status, 0, sizeof( status ) );
+		status.streaming = lb->streaming;
+		status.starts = lb->starts;
+		memcpy( reply, &status, sizeof( status ) );
+		n = sizeof( status );
+		break;
+	}
+	case CMD_STREAM_START:
+	case CMD_FOOTER_STREAM:
+		lb->streaming = 1;
+		lb->footer = ( request == CMD_FOOTER_STREAM );
+		lb->starts++;
+		lb->offset = 0;
+		lb->filled = 0;
+		lb->start_ns = lb_now_ns();
+		lb->mark_count = 0;
+		if ( lb->marked )
+			lb_mark_push( lb, 0, lb->mark_level );
+		/* Requests cancelled at the last stop do not hold the link */
+		lb->link_free_ns = 0;
+		pthread_cond_signal( &lb->work );
+		break;
+	case CMD_STREAM_STOP:
+		lb->streaming = 0;
+		break;
+	case CMD_PIB_CLOCK: {
+		PibClockConfig_t config;
+		uint32_t pib_hz;
+		if ( in || len != sizeof( config ) ) {
+			pthread_mutex_unlock( &lb->lock );
+			return ITS_ERR_STALL;
+		}
+		memcpy( &config, data, sizeof( config ) );
+		lb->pib.result = lb_pib_check( &config, &pib_hz );
+		if ( lb->pib.result != PIB_CLK_OK ) {
+			pthread_mutex_unlock( &lb->lock );
+			return ITS_ERR_STALL;
+		}
+		lb->pib.config = config;
+		lb->pib.pib_hz = pib_hz;
+		lb->pib.changes++;
+		break;
+	}
+	case CMD_READ_PIB_CLOCK:
+		memcpy( reply, &lb->pib, sizeof( lb->pib ) );
+		n = sizeof( lb->pib );
+		break;
+	case CMD_FLUSH_DEADLINE:
+		if ( value != 0 && ( value < FLUSH_DEADLINE_MIN_MS || value > FLUSH_DEADLINE_MAX_MS || index == 0 ) ) {
+			pthread_mutex_unlock( &lb->lock );
+			return ITS_ERR_STALL;
+		}
+		lb->flush_ms = value;
+		lb->flush_kbps = value ? index : 0;
+		lb->flush_buf = lb_flush_buf( value, index );
+		break;
+	case CMD_READ_FLUSH: {
+		FlushStatus_t status;
+		memset( &status, 0, sizeof( status ) );
+		status.supported = 1;
+		status.deadline_ms = lb->flush_ms;
+		status.rate_kbps = lb->flush_kbps;
+		status.buffer_bytes = lb->footer ? 0 : lb->flush_buf;
+		status.active = lb->flush_ms != 0 && lb->streaming && !lb->footer;
+		memcpy( reply, &status, sizeof( status ) );
+		n = sizeof( status );
+		break;
+	}
+	case CMD_LATENCY_MARK: {
+		LatencyMark_t mark;
+		uint64_t now = lb_now_ns();
+		uint64_t at = lb->filled;
+		if ( lb->streaming && lb->config.sample_mbps > 0 && now > lb->start_ns ) {
+			uint64_t produced = (uint64_t)( (double)( now - lb->start_ns ) * lb->config.sample_mbps / 1000.0 );
+			if ( produced > at )
+				at = produced;
+		}
+		lb->marked = 1;
+		lb->mark_level = value ? 1 : 0;
+		if ( lb->streaming )
+			lb_mark_push( lb, at, lb->mark_level );
+		memset( &mark, 0, sizeof( mark ) );
+		mark.line = LB_MARK_LINE;
+		mark.width = 8;
+		mark.level = lb->mark_level;
+		mark.flags = lb->streaming ? PPS_FLAG_STREAMING : 0;
+		mark.seq = ++lb->mark_seq;
+		mark.time_ms = (uint32_t)( now / 1000000ull );
+		mark.stream = lb->starts;
+		mark.offset = at;
+		memcpy( reply, &mark, sizeof( mark ) );
+		n = sizeof( mark );
+		break;
+	}
+	case CMD_READ_FOOTER: {
+		FooterStatus_t status;
+		memset( &status, 0, sizeof( status ) );
+		if ( lb->footer ) {
+			status.active = lb->streaming;
+			status.buffers = (uint32_t)( lb->offset / LB_FOOTER_BUF );
+			status.bytes = lb->offset / LB_FOOTER_BUF * LB_FOOTER_PAYLOAD;
+		}
+		memcpy( reply, &status, sizeof( status ) );
+		n = sizeof( status );
+		break;
+	}
+	case CMD_READ_DEBUG_INFO:
+	case CMD_REG_READ:
+	case CMD_READ_USB_ERRORS:
+	case CMD_READ_LPM_STATS:
+	case CMD_READ_TRIGGER:
+	case CMD_READ_PPS:
+	case CMD_READ_SNAPSHOT:
+	case CMD_READ_PRETRIG:
+	case CMD_READ_DECIM:
+	case CMD_READ_STATS:
+	case CMD_READ_JAM:
+	case CMD_READ_PROFILE:
+	case CMD_READ_PC_SAMPLE:
+	case CMD_READ_CPU_LOAD:
+	case CMD_READ_GAPS:
+		n = len;
+		break;
+	case CMD_REG_WRITE:
+	case CMD_CYPRESS_RESET:
+	case CMD_SET_LPM_POLICY:
+	case CMD_STREAM_ARM:
+	case CMD_SNAPSHOT:
+	case CMD_PRETRIG_ARM:
+	case CMD_PRETRIG_FIRE:
+	case CMD_DECIMATE:
+	case CMD_SAMPLE_STATS:
+	case CMD_JAM_CONFIG:
+		break;
+	default:
+		pthread_mutex_unlock( &lb->lock );
+		return ITS_ERR_STALL;
+	}
+	pthread_mutex_unlock( &lb->lock );
+
+	if ( !in )
+		return len;
+	if ( n > len )
+		n = len;
+	memcpy( data, reply, n );
+	return (int)n;
+}
+
+static int lb_xfer_init( its_dev* dev, its_xfer* xfer )
+{
+	lb_req* r;
+
+	(void)dev;
+	r = calloc( 1, sizeof( lb_req ) );
+	if ( !r )
+		return ITS_ERR_NO_MEM;
+	if ( posix_memalign( (void**)&xfer->buf, 4096, xfer->size ) != 0 ) {
+		free( r );
+		return ITS_ERR_NO_MEM;
+	}
+	r->xfer = xfer;
+	r->buf = xfer->buf;
+	r->len = xfer->size;
+	xfer->priv = r;
+	return ITS_OK;
+}
+
+static void lb_xfer_free( its_dev* dev, its_xfer* xfer )
+{
+	(void)dev;
+	free( xfer->buf );
+	free( xfer->priv );
+	xfer->buf = NULL;
+	xfer->priv = NULL;
+}
+
+static int lb_submit( its_dev* dev, its_xfer* xfer, int timeout_ms )
+{
+	lb_dev* lb = dev->priv;
+
+	pthread_mutex_lock( &lb->lock );
+	lb_enqueue( lb, xfer->priv, timeout_ms );
+	pthread_mutex_unlock( &lb->lock );
+	return ITS_OK;
+}
+
+static void lb_cancel( its_dev* dev, its_xfer* xfer )
+{
+	lb_dev* lb = dev->priv;
+	lb_req* r = xfer->priv;
+
+	pthread_mutex_lock( &lb->lock );
+	if ( !r->done ) {
+		r->cancel = 1;
+		pthread_cond_signal( &lb->work );
+	}
+	pthread_mutex_unlock( &lb->lock );
+}
+
+static int lb_handle_events( its_dev* dev, int timeout_ms )
+{
+	lb_dev* lb = dev->priv;
+	lb_req* list;
+	lb_req* r;
+	struct timespec ts;
+
+	pthread_mutex_lock( &lb->lock );
+	if ( !lb->completed && timeout_ms != 0 ) {
+		ts = lb_timespec( lb_now_ns() + (uint64_t)timeout_ms * 1000000ull );
+		while ( !lb->completed ) {
+			if ( pthread_cond_timedwait( &lb->done, &lb->lock, &ts ) == ETIMEDOUT )
+				break;
+		}
+	}
+	list = lb->completed;
+	lb->completed = NULL;
+	lb->completed_tail = NULL;
+	pthread_mutex_unlock( &lb->lock );
+
+	if ( !list )
+		return ITS_ERR_TIMEOUT;
+	while ( list ) {
+		r = list;
+		list = r->next;
+		r->xfer->actual = r->actual;
+		r->xfer->status = r->status;
+		its_xfer_done( r->xfer );
+	}
+	return ITS_OK;
+}
+
+static int lb_bulk_read( its_dev* dev, void* buf, size_t len, size_t* actual, int timeout_ms )
+{
+	lb_dev* lb = dev->priv;
+	lb_req r;
+
+	memset( &r, 0, sizeof( r ) );
+	r.buf = buf;
+	r.len = len;
+
+	pthread_mutex_lock( &lb->lock );
+	lb_enqueue( lb, &r, timeout_ms );
+	while ( !r.done )
+		pthread_cond_wait( &lb->done, &lb->lock );
+	pthread_mutex_unlock( &lb->lock );
+
+	if ( actual )
+		*actual = r.actual;
+	return ( r.status == ITS_XFER_OK ) ? ITS_OK : ITS_ERR_TIMEOUT;
+}
+
+static void lb_close( its_dev* dev )
+{
+	lb_dev* lb = dev->priv;
+
+	pthread_mutex_lock( &lb->lock );
+	lb->quit = 1;
+	pthread_cond_signal( &lb->work );
+	pthread_mutex_unlock( &lb->lock );
+	pthread_join( lb->thread, NULL );
+
+	pthread_cond_destroy( &lb->work );
+	pthread_cond_destroy( &lb->done );
+	pthread_mutex_destroy( &lb->lock );
+	free( lb );
+}
+
+static const its_backend lb_backend = {
+	lb_control,
+	lb_xfer_init,
+	lb_xfer_free,
+	lb_submit,
+	lb_cancel,
+	lb_handle_events,
+	lb_bulk_read,
+	lb_close,
+};
+
+void its_loopback_defaults( its_loopback_config* config )
+{
+	config->link_mbps = 380.0;
+	config->latency_us = 125;
+	config->sample_mbps = 0;
+}
+
+int its_open_loopback( its_dev** dev, const its_loopback_config* config )
+{
+	its_dev* d;
+	lb_dev* lb;
+	pthread_condattr_t attr;
+
+	if ( !dev )
+		return ITS_ERR_ARG;
+	d = calloc( 1, sizeof( its_dev ) );
+	lb = calloc( 1, sizeof( lb_dev ) );
+	if ( !d || !lb ) {
+		free( d );
+		free( lb );
+		return ITS_ERR_NO_MEM;
+	}
+	if ( config )
+		lb->config = *config;
+	else
+		its_loopback_defaults( &lb->config );
+	lb->flush_buf = LB_DEVICE_BUF;
+	lb->pib.config.div = 2;
+	lb->pib.config.source = PIB_CLK_SRC_SYS;
+	lb->pib.sys_hz = LB_SYS_HZ;
+	lb_pib_check( &lb->pib.config, &lb->pib.pib_hz );
+
+	/* Deadlines are CLOCK_MONOTONIC */
+	pthread_condattr_init( &attr );
+	pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+	pthread_mutex_init( &lb->lock, NULL );
+	pthread_cond_init( &lb->work, &attr );
+	pthread_cond_init( &lb->done, &attr );
+	pthread_condattr_destroy( &attr );
+	if ( pthread_create( &lb->thread, NULL, lb_thread, lb ) != 0 ) {
+		free( d );
+		free( lb );
+		return ITS_ERR_NO_MEM;
+	}
+
+	d->backend = &lb_backend;
+	d->priv = lb;
+	*dev = d;
+	return ITS_OK;
+}
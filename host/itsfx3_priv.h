@@ -0,0 +1,58 @@
+#ifndef ITSFX3_PRIV_H_
+#define ITSFX3_PRIV_H_
+
+/* Interface between the library core (itsfx3.c) and the device backends. */
+
+#include "itsfx3.h"
+
+#define ITS_XFER_OK         ( 0 )
+#define ITS_XFER_TIMEOUT    ( 1 )
+#define ITS_XFER_CANCELLED  ( 2 )
+#define ITS_XFER_ERROR      ( 3 )
+
+#define ITS_CTRL_TIMEOUT_MS ( 1000 )
+
+typedef struct its_xfer {
+	its_dev* dev;
+	uint8_t* buf;
+	size_t   size;
+	size_t   actual;
+	int      status;        /* ITS_XFER_* */
+	int      in_flight;
+	void*    priv;          /* Backend state */
+} its_xfer;
+
+typedef struct its_backend {
+	/* Vendor request, in != 0 reads data from the device. Returns the
+	 * bytes transferred or an error. */
+	int  ( *control )( its_dev* dev, int in, uint8_t request, uint16_t value, uint16_t index,
+			void* data, uint16_t len );
+	int  ( *xfer_init )( its_dev* dev, its_xfer* xfer );
+	void ( *xfer_free )( its_dev* dev, its_xfer* xfer );
+	int  ( *submit )( its_dev* dev, its_xfer* xfer, int timeout_ms );
+	void ( *cancel )( its_dev* dev, its_xfer* xfer );
+	/* Wait up to timeout_ms for completions, report each through its_xfer_done. */
+	int  ( *handle_events )( its_dev* dev, int timeout_ms );
+	int  ( *bulk_read )( its_dev* dev, void* buf, size_t len, size_t* actual, int timeout_ms );
+	void ( *close )( its_dev* dev );
+} its_backend;
+
+struct its_dev {
+	const its_backend* backend;
+	void*    priv;          /* Backend state */
+
+	its_xfer* xfers;
+	unsigned xfer_count;
+	unsigned in_flight;
+	int      running;       /* Completions are resubmitted */
+	int      timeout_ms;
+	size_t   transfer_size;
+	its_stream_cb cb;
+	void*    user;
+	its_stream_stats stats;
+};
+
+/* Called by the backend for every completed, failed or cancelled transfer. */
+void its_xfer_done( its_xfer* xfer );
+
+#endif /* ITSFX3_PRIV_H_ */
@@ -0,0 +1,128 @@
+/*
+ * Marker latency probe, see itsfx3_probe.h.
+ *
+ * Before the edge the marker line holds the level of the previous mark,
+ * from the device offset on the first byte with the new level is the
+ * edge. The device offset is where GPIF was writing when the line moved,
+ * exact to one DMA buffer, so the search only covers the bytes GPIF wrote
+ * in that buffer before the mark.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "itsfx3_probe.h"
+
+static double probe_now( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int cmp_double( const void* a, const void* b )
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return ( x > y ) - ( x < y );
+}
+
+void its_probe_init( its_probe* p )
+{
+	memset( p, 0, sizeof( *p ) );
+	p->stride = 1;
+	p->mask = 1;
+}
+
+void its_probe_free( its_probe* p )
+{
+	free( p->latency );
+	p->latency = NULL;
+	p->count = p->alloc = 0;
+}
+
+int its_probe_mark( its_dev* dev, its_probe* p )
+{
+	LatencyMark_t mark;
+	double t0, t1;
+	unsigned width;
+	int rc;
+
+	if ( p->pending ) {
+		if ( probe_now() - p->t_mark < ITS_PROBE_TIMEOUT_S )
+			return ITS_ERR_BUSY;
+		p->pending = 0;
+		p->lost++;
+	}
+
+	t0 = probe_now();
+	rc = its_latency_mark( dev, !p->level, &mark );
+	t1 = probe_now();
+	if ( rc != ITS_OK )
+		return rc;
+	width = mark.width ? mark.width : 8;
+	if ( mark.line >= width )
+		return ITS_ERR_IO;
+
+	p->level = mark.level;
+	p->stride = width / 8;
+	p->lane = mark.line / 8;
+	p->mask = (uint8_t)( 1u << ( mark.line % 8 ) );
+	if ( !( mark.flags & PPS_FLAG_STREAMING ) )
+		return ITS_OK;
+
+	p->pending = 1;
+	p->from = mark.offset;
+	p->t_mark = ( t0 + t1 ) / 2;
+	p->t_half = ( t1 - t0 ) / 2;
+	p->marks++;
+	return ITS_OK;
+}
+
+int its_probe_feed( its_probe* p, const its_buffer* buf )
+{
+	uint8_t want = p->level ? p->mask : 0;
+	uint64_t at;
+	size_t i;
+	double* q;
+
+	if ( !p->pending || buf->offset + buf->length <= p->from )
+		return 0;
+
+	/* First byte of the lane at or after the device offset */
+	at = buf->offset > p->from ? buf->offset : p->from;
+	at += ( p->lane + p->stride - at % p->stride ) % p->stride;
+	for ( i = (size_t)( at - buf->offset ); i < buf->length; i += p->stride ) {
+		if ( ( buf->data[ i ] & p->mask ) == want )
+			break;
+	}
+	if ( i >= buf->length )
+		return 0;
+
+	if ( p->count == p->alloc ) {
+		q = realloc( p->latency, ( p->alloc ? p->alloc * 2 : 1024 ) * sizeof( double ) );
+		if ( !q )
+			return ITS_ERR_NO_MEM;
+		p->latency = q;
+		p->alloc = p->alloc ? p->alloc * 2 : 1024;
+	}
+	p->latency[ p->count++ ] = probe_now() - p->t_mark;
+	if ( p->t_half > p->half_max )
+		p->half_max = p->t_half;
+	if ( buf->offset + i - p->from > p->lag_max )
+		p->lag_max = buf->offset + i - p->from;
+	p->pending = 0;
+	return 1;
+}
+
+double its_probe_percentile( its_probe* p, double q )
+{
+	size_t i;
+
+	if ( p->count == 0 )
+		return 0;
+	qsort( p->latency, p->count, sizeof( double ), cmp_double );
+	i = (size_t)( q * ( p->count - 1 ) + 0.5 );
+	return p->latency[ i < p->count ? i : p->count - 1 ];
+}
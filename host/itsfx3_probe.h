@@ -0,0 +1,74 @@
+#ifndef ITSFX3_PROBE_H_
+#define ITSFX3_PROBE_H_
+
+/*
+ * End-to-end sample latency with the marker line of CMD_LATENCY_MARK.
+ *
+ * its_probe_mark toggles the marker and times the command on the host
+ * clock, the edge happens at the device somewhere within it. The stream
+ * callback passes every buffer to its_probe_feed, which looks for the new
+ * level on the marker line from the stream offset the device reported
+ * and takes the time the buffer holding the edge reached the application.
+ * The latency is that time less the middle of the command, known to half
+ * the command time: from the P-port pins to the application, whatever
+ * the buffers and transfers in between.
+ *
+ * Stream offsets are those of its_buffer, which match the device's as
+ * long as the host stream was started before CMD_STREAM_START. One mark
+ * is in flight at a time. Not thread safe: mark and feed on the thread
+ * that runs the stream.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "itsfx3.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ITS_PROBE_TIMEOUT_S  ( 1.0 )   /* An edge not seen by then is lost */
+
+typedef struct its_probe {
+	/* Marker line in the stream, from the last reply */
+	unsigned stride;        /* Bytes per bus word */
+	unsigned lane;          /* Byte of the word holding the line */
+	uint8_t  mask;          /* The line in that byte */
+
+	/* Mark in flight */
+	int      pending;
+	uint8_t  level;
+	uint64_t from;          /* Device offset at the mark, the edge is not before it */
+	double   t_mark;        /* Middle of the command, host clock, s */
+	double   t_half;        /* Half the command time */
+
+	double*  latency;       /* Per edge found, s */
+	size_t   count;
+	size_t   alloc;
+	uint64_t marks;         /* Marks set while streaming */
+	uint64_t lost;          /* Edges not seen within ITS_PROBE_TIMEOUT_S */
+	double   half_max;      /* Largest half command time */
+	uint64_t lag_max;       /* Largest edge offset less device offset, bytes */
+} its_probe;
+
+void its_probe_init( its_probe* p );
+void its_probe_free( its_probe* p );
+
+/* Toggle the marker. ITS_ERR_BUSY while the previous edge is still on its
+ * way, ITS_ERR_STALL if the image has no marker line. A mark set while
+ * the device does not stream is not counted. */
+int  its_probe_mark( its_dev* dev, its_probe* p );
+
+/* Look for the edge in the next stream buffer. 1 if found, else 0, or
+ * ITS_ERR_NO_MEM. */
+int  its_probe_feed( its_probe* p, const its_buffer* buf );
+
+/* Latency percentile q in 0 .. 1 of the edges found so far, s. Sorts. */
+double its_probe_percentile( its_probe* p, double q );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ITSFX3_PROBE_H_ */
@@ -0,0 +1,479 @@
+/*
+ * Recording writer and mmap reader, see itsfx3_rec.h.
+ *
+ * The writer collects stream bytes in one chunk sized, page aligned
+ * buffer and writes it out whole at its file offset. Gaps and events only
+ * remember their data offset while recording. Sample indices depend on
+ * every gap before them, so they are computed once in its_rec_finish.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "itsfx3.h"
+#include "itsfx3_rec.h"
+#include "its_sample_format.h"
+
+struct its_rec_writer {
+	int      fd;
+	its_rec_header hdr;
+	uint8_t* chunk;
+	size_t   fill;          /* Bytes in chunk */
+	uint64_t written;       /* Stream bytes received */
+	its_rec_event* events;  /* Gaps are events of type OVERFLOW */
+	size_t   event_count;
+	size_t   event_alloc;
+	its_rec_reg* regs;
+	size_t   reg_count;
+};
+
+struct its_rec_reader {
+	int      fd;
+	uint8_t* map;
+	size_t   map_size;
+	its_rec_header hdr;
+};
+
+static uint64_t rec_align( uint64_t v )
+{
+	return ( v + ITS_REC_ALIGN - 1 ) & ~(uint64_t)( ITS_REC_ALIGN - 1 );
+}
+
+static int rec_pwrite( int fd, const void* buf, size_t len, uint64_t offset )
+{
+	const uint8_t* p = buf;
+	ssize_t n;
+
+	while ( len > 0 ) {
+		n = pwrite( fd, p, len, (off_t)offset );
+		if ( n < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			return ITS_ERR_IO;
+		}
+		p += n;
+		len -= (size_t)n;
+		offset += (uint64_t)n;
+	}
+	return ITS_OK;
+}
+
+/* ---- Writer ---- */
+
+void its_rec_defaults( its_rec_config* config )
+{
+	memset( config, 0, sizeof( *config ) );
+	config->chunk_size = ITS_REC_CHUNK_DEFAULT;
+}
+
+int its_rec_create( its_rec_writer** rec, const char* path, const its_rec_config* config )
+{
+	its_rec_config def;
+	its_rec_writer* w;
+	struct timespec ts;
+
+	if ( !rec || !path )
+		return ITS_ERR_ARG;
+	if ( !config ) {
+		its_rec_defaults( &def );
+		config = &def;
+	}
+	if ( config->chunk_size == 0 || config->chunk_size % ITS_REC_ALIGN != 0 )
+		return ITS_ERR_ARG;
+
+	w = calloc( 1, sizeof( *w ) );
+	if ( !w )
+		return ITS_ERR_NO_MEM;
+	if ( posix_memalign( (void**)&w->chunk, ITS_REC_ALIGN, config->chunk_size ) != 0 ) {
+		free( w );
+		return ITS_ERR_NO_MEM;
+	}
+	if ( config->reg_count > 0 ) {
+		w->regs = malloc( config->reg_count * sizeof( its_rec_reg ) );
+		if ( !w->regs ) {
+			free( w->chunk );
+			free( w );
+			return ITS_ERR_NO_MEM;
+		}
+		memcpy( w->regs, config->regs, config->reg_count * sizeof( its_rec_reg ) );
+		w->reg_count = config->reg_count;
+	}
+
+	w->fd = open( path, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if ( w->fd < 0 ) {
+		free( w->regs );
+		free( w->chunk );
+		free( w );
+		return ITS_ERR_IO;
+	}
+
+	clock_gettime( CLOCK_REALTIME, &ts );
+	memcpy( w->hdr.magic, ITS_REC_MAGIC, sizeof( w->hdr.magic ) );
+	w->hdr.format = ITS_REC_FORMAT;
+	w->hdr.header_size = ITS_REC_HEADER_SIZE;
+	w->hdr.chunk_size = config->chunk_size;
+	w->hdr.fw_version = config->fw_version;
+	w->hdr.channels = ITS_SAMPLE_CHANNELS;
+	w->hdr.sample_bits = ITS_SAMPLE_BITS;
+	w->hdr.sample_bytes = ( ITS_SAMPLE_CHANNELS * ITS_SAMPLE_BITS + 7 ) / 8;
+	w->hdr.sample_rate = config->sample_rate;
+	w->hdr.start_time_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+	w->hdr.data_offset = ITS_REC_HEADER_SIZE;
+
+	/* Header without ITS_REC_FINISHED, rewritten at the end */
+	memset( w->chunk, 0, ITS_REC_HEADER_SIZE );
+	memcpy( w->chunk, &w->hdr, sizeof( w->hdr ) );
+	if ( rec_pwrite( w->fd, w->chunk, ITS_REC_HEADER_SIZE, 0 ) != ITS_OK ) {
+		close( w->fd );
+		free( w->regs );
+		free( w->chunk );
+		free( w );
+		return ITS_ERR_IO;
+	}
+
+	*rec = w;
+	return ITS_OK;
+}
+
+static int rec_flush( its_rec_writer* w )
+{
+	uint64_t offset;
+	int rc;
+
+	if ( w->fill == 0 )
+		return ITS_OK;
+	offset = w->hdr.data_offset + w->written - w->fill;
+	rc = rec_pwrite( w->fd, w->chunk, w->fill, offset );
+	w->fill = 0;
+	return rc;
+}
+
+int its_rec_write( its_rec_writer* w, const void* data, size_t len )
+{
+	const uint8_t* p = data;
+	size_t n;
+	int rc;
+
+	while ( len > 0 ) {
+		n = w->hdr.chunk_size - w->fill;
+		if ( n > len )
+			n = len;
+		memcpy( w->chunk + w->fill, p, n );
+		w->fill += n;
+		w->written += n;
+		p += n;
+		len -= n;
+		if ( w->fill == w->hdr.chunk_size ) {
+			rc = rec_flush( w );
+			if ( rc != ITS_OK )
+				return rc;
+		}
+	}
+	return ITS_OK;
+}
+
+int its_rec_add_event( its_rec_writer* w, uint64_t data_offset, uint32_t type, uint64_t value )
+{
+	its_rec_event* e;
+	size_t alloc;
+
+	if ( w->event_count == w->event_alloc ) {
+		alloc = w->event_alloc ? w->event_alloc * 2 : 64;
+		e = realloc( w->events, alloc * sizeof( its_rec_event ) );
+		if ( !e )
+			return ITS_ERR_NO_MEM;
+		w->events = e;
+		w->event_alloc = alloc;
+	}
+	e = &w->events[ w->event_count++ ];
+	memset( e, 0, sizeof( *e ) );
+	e->data_offset = data_offset;
+	e->type = type;
+	e->value = value;
+	return ITS_OK;
+}
+
+int its_rec_gap( its_rec_writer* w, uint64_t data_offset, uint64_t lost )
+{
+	if ( data_offset > w->written )
+		return ITS_ERR_ARG;
+	return its_rec_add_event( w, data_offset, ITS_REC_EVT_OVERFLOW, lost );
+}
+
+uint64_t its_rec_written( const its_rec_writer* w )
+{
+	return w->written;
+}
+
+static int event_cmp( const void* a, const void* b )
+{
+	const its_rec_event* x = a;
+	const its_rec_event* y = b;
+
+	if ( x->data_offset != y->data_offset )
+		return ( x->data_offset < y->data_offset ) ? -1 : 1;
+	/* Gaps first, so events at a gap get the index after it */
+	if ( ( x->type == ITS_REC_EVT_OVERFLOW ) != ( y->type == ITS_REC_EVT_OVERFLOW ) )
+		return ( x->type == ITS_REC_EVT_OVERFLOW ) ? -1 : 1;
+	return 0;
+}
+
+/* Sorts the events, fills in their sample index and builds the index:
+ * one entry per chunk start and per gap, in data offset order. */
+static its_rec_index* rec_build_index( its_rec_writer* w, size_t* count )
+{
+	uint64_t chunks = ( w->written + w->hdr.chunk_size - 1 ) / w->hdr.chunk_size;
+	uint64_t bps = w->hdr.sample_bytes;
+	uint64_t lost = 0, chunk = 0, offset;
+	its_rec_index* index;
+	size_t n = 0, e = 0;
+
+	qsort( w->events, w->event_count, sizeof( its_rec_event ), event_cmp );
+
+	index = malloc( ( chunks + w->event_count + 1 ) * sizeof( its_rec_index ) );
+	if ( !index )
+		return NULL;
+
+	while ( chunk < chunks || e < w->event_count ) {
+		if ( e < w->event_count &&
+				( chunk >= chunks || w->events[ e ].data_offset <= chunk * w->hdr.chunk_size ) ) {
+			its_rec_event* ev = &w->events[ e++ ];
+			if ( ev->type == ITS_REC_EVT_OVERFLOW ) {
+				lost += ev->value;
+				ev->sample_index = ev->data_offset / bps + lost;
+				if ( n > 0 && index[ n - 1 ].data_offset == ev->data_offset )
+					n--;
+				index[ n ].data_offset = ev->data_offset;
+				index[ n ].sample_index = ev->sample_index;
+				n++;
+			} else {
+				ev->sample_index = ev->data_offset / bps + lost;
+			}
+		} else {
+			offset = chunk++ * w->hdr.chunk_size;
+			if ( n > 0 && index[ n - 1 ].data_offset == offset )
+				continue;
+			index[ n ].data_offset = offset;
+			index[ n ].sample_index = offset / bps + lost;
+			n++;
+		}
+	}
+
+	w->hdr.lost_samples = lost;
+	*count = n;
+	return index;
+}
+
+int its_rec_finish( its_rec_writer* w )
+{
+	its_rec_index* index = NULL;
+	size_t index_count = 0;
+	uint64_t offset;
+	int rc;
+
+	rc = rec_flush( w );
+
+	if ( rc == ITS_OK ) {
+		index = rec_build_index( w, &index_count );
+		if ( !index )
+			rc = ITS_ERR_NO_MEM;
+	}
+
+	w->hdr.data_bytes = w->written;
+	offset = rec_align( w->hdr.data_offset + w->written );
+	w->hdr.index_offset = offset;
+	w->hdr.index_count = index_count;
+	offset += index_count * sizeof( its_rec_index );
+	w->hdr.event_offset = offset;
+	w->hdr.event_count = w->event_count;
+	offset += w->event_count * sizeof( its_rec_event );
+	w->hdr.reg_offset = offset;
+	w->hdr.reg_count = w->reg_count;
+
+	if ( rc == ITS_OK && index_count > 0 )
+		rc = rec_pwrite( w->fd, index, index_count * sizeof( its_rec_index ), w->hdr.index_offset );
+	if ( rc == ITS_OK && w->event_count > 0 )
+		rc = rec_pwrite( w->fd, w->events, w->event_count * sizeof( its_rec_event ), w->hdr.event_offset );
+	if ( rc == ITS_OK && w->reg_count > 0 )
+		rc = rec_pwrite( w->fd, w->regs, w->reg_count * sizeof( its_rec_reg ), w->hdr.reg_offset );
+	if ( rc == ITS_OK && fdatasync( w->fd ) != 0 )
+		rc = ITS_ERR_IO;
+	/* Header last, a file is only marked finished once the tables are on disk */
+	if ( rc == ITS_OK ) {
+		w->hdr.flags |= ITS_REC_FINISHED;
+		rc = rec_pwrite( w->fd, &w->hdr, sizeof( w->hdr ), 0 );
+	}
+	if ( close( w->fd ) != 0 && rc == ITS_OK )
+		rc = ITS_ERR_IO;
+
+	free( index );
+	free( w->events );
+	free( w->regs );
+	free( w->chunk );
+	free( w );
+	return rc;
+}
+
+/* ---- Reader ---- */
+
+static int rec_table_ok( const its_rec_reader* r, uint64_t offset, uint64_t count, size_t size )
+{
+	if ( count == 0 )
+		return 1;
+	if ( count > r->map_size / size )
+		return 0;
+	return offset <= r->map_size && count * size <= r->map_size - offset;
+}
+
+int its_rec_open( its_rec_reader** rec, const char* path )
+{
+	its_rec_reader* r;
+	struct stat st;
+
+	if ( !rec || !path )
+		return ITS_ERR_ARG;
+	r = calloc( 1, sizeof( *r ) );
+	if ( !r )
+		return ITS_ERR_NO_MEM;
+
+	r->fd = open( path, O_RDONLY );
+	if ( r->fd < 0 || fstat( r->fd, &st ) != 0 || (size_t)st.st_size < ITS_REC_HEADER_SIZE )
+		goto fail_format;
+	r->map_size = (size_t)st.st_size;
+	r->map = mmap( NULL, r->map_size, PROT_READ, MAP_SHARED, r->fd, 0 );
+	if ( r->map == MAP_FAILED ) {
+		r->map = NULL;
+		goto fail_format;
+	}
+
+	memcpy( &r->hdr, r->map, sizeof( r->hdr ) );
+	if ( memcmp( r->hdr.magic, ITS_REC_MAGIC, sizeof( r->hdr.magic ) ) != 0 ||
+			r->hdr.format != ITS_REC_FORMAT || r->hdr.sample_bytes == 0 ||
+			r->hdr.data_offset > r->map_size )
+		goto fail_format;
+
+	if ( !( r->hdr.flags & ITS_REC_FINISHED ) ) {
+		/* Writer did not finish: data up to the end of the file, no tables */
+		r->hdr.data_bytes = r->map_size - r->hdr.data_offset;
+		r->hdr.index_count = 0;
+		r->hdr.event_count = 0;
+		r->hdr.reg_count = 0;
+		r->hdr.lost_samples = 0;
+	}
+	if ( !rec_table_ok( r, r->hdr.data_offset, r->hdr.data_bytes, 1 ) ||
+			!rec_table_ok( r, r->hdr.index_offset, r->hdr.index_count, sizeof( its_rec_index ) ) ||
+			!rec_table_ok( r, r->hdr.event_offset, r->hdr.event_count, sizeof( its_rec_event ) ) ||
+			!rec_table_ok( r, r->hdr.reg_offset, r->hdr.reg_count, sizeof( its_rec_reg ) ) )
+		goto fail_format;
+
+	madvise( r->map + r->hdr.data_offset, (size_t)r->hdr.data_bytes, MADV_RANDOM );
+	*rec = r;
+	return ITS_OK;
+
+fail_format:
+	its_rec_close( r );
+	return ITS_ERR_FORMAT;
+}
+
+void its_rec_close( its_rec_reader* r )
+{
+	if ( !r )
+		return;
+	if ( r->map )
+		munmap( r->map, r->map_size );
+	if ( r->fd >= 0 )
+		close( r->fd );
+	free( r );
+}
+
+const its_rec_header* its_rec_info( const its_rec_reader* r )
+{
+	return &r->hdr;
+}
+
+const uint8_t* its_rec_data( const its_rec_reader* r, uint64_t* bytes )
+{
+	if ( bytes )
+		*bytes = r->hdr.data_bytes;
+	return r->map + r->hdr.data_offset;
+}
+
+const its_rec_index* its_rec_index_table( const its_rec_reader* r, uint64_t* count )
+{
+	*count = r->hdr.index_count;
+	return (const its_rec_index*)( r->map + r->hdr.index_offset );
+}
+
+const its_rec_event* its_rec_events( const its_rec_reader* r, uint64_t* count )
+{
+	*count = r->hdr.event_count;
+	return (const its_rec_event*)( r->map + r->hdr.event_offset );
+}
+
+const its_rec_reg* its_rec_regs( const its_rec_reader* r, uint64_t* count )
+{
+	*count = r->hdr.reg_count;
+	return (const its_rec_reg*)( r->map + r->hdr.reg_offset );
+}
+
+/* Last index entry with key <= value, by sample index or data offset */
+static const its_rec_index* rec_lookup( const its_rec_reader* r, uint64_t value, int by_sample )
+{
+	uint64_t count;
+	const its_rec_index* index = its_rec_index_table( r, &count );
+	uint64_t lo = 0, hi = count, mid, key;
+
+	while ( lo < hi ) {
+		mid = lo + ( hi - lo ) / 2;
+		key = by_sample ? index[ mid ].sample_index : index[ mid ].data_offset;
+		if ( key <= value )
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return ( lo > 0 ) ? &index[ lo - 1 ] : NULL;
+}
+
+int its_rec_find_sample( const its_rec_reader* r, uint64_t sample, uint64_t* data_offset )
+{
+	const its_rec_index* e = rec_lookup( r, sample, 1 );
+	uint64_t bps = r->hdr.sample_bytes;
+	uint64_t count, offset;
+	const its_rec_index* index = its_rec_index_table( r, &count );
+
+	if ( !e ) {
+		/* Before the first entry: no index, or samples lost at the start */
+		if ( count > 0 && sample < index[ 0 ].sample_index ) {
+			*data_offset = index[ 0 ].data_offset;
+			return 1;
+		}
+		offset = sample * bps;
+	} else {
+		offset = e->data_offset + ( sample - e->sample_index ) * bps;
+		/* Past the next entry's offset means the sample lies in its gap */
+		if ( e + 1 < index + count && offset >= e[ 1 ].data_offset ) {
+			*data_offset = e[ 1 ].data_offset;
+			return 1;
+		}
+	}
+	if ( offset >= r->hdr.data_bytes )
+		return ITS_ERR_ARG;
+	*data_offset = offset;
+	return 0;
+}
+
+uint64_t its_rec_sample_at( const its_rec_reader* r, uint64_t data_offset )
+{
+	const its_rec_index* e = rec_lookup( r, data_offset, 0 );
+
+	if ( !e )
+		return data_offset / r->hdr.sample_bytes;
+	return e->sample_index + ( data_offset - e->data_offset ) / r->hdr.sample_bytes;
+}
@@ -0,0 +1,137 @@
+#ifndef ITSFX3_REC_H_
+#define ITSFX3_REC_H_
+
+/*
+ * Recording format for raw EP 0x81 captures.
+ *
+ *   0              header, ITS_REC_HEADER_SIZE bytes
+ *   data_offset    stream bytes as received, written in chunk_size pieces
+ *                  at chunk aligned file offsets
+ *   index_offset   its_rec_index[ index_count ]   (page aligned)
+ *   event_offset   its_rec_event[ event_count ]
+ *   reg_offset     its_rec_reg[ reg_count ]
+ *
+ * All fields are little endian. The data region is contiguous, so the
+ * reader maps the file and hands out pointers into it.
+ *
+ * Sample index counts samples since the start of the stream, including
+ * the ones lost in overflow gaps, data offset counts bytes in the data
+ * region. The index has an entry for every chunk and for every gap, so a
+ * sample index is found by a binary search and one multiplication.
+ *
+ * Tables and the final header are written by its_rec_finish. A file
+ * without ITS_REC_FINISHED (writer killed) is still readable, its data
+ * runs to the end of the file and it has no index, events or registers.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ITS_REC_MAGIC           "ITSFX3RC"
+#define ITS_REC_FORMAT          ( 1 )
+#define ITS_REC_HEADER_SIZE     ( 4096 )
+#define ITS_REC_ALIGN           ( 4096 )
+#define ITS_REC_CHUNK_DEFAULT   ( 4 * 1024 * 1024 )
+
+#define ITS_REC_FINISHED        ( 1 << 0 )
+
+#define ITS_REC_EVT_OVERFLOW    ( 1 )   /* value: samples lost before data_offset */
+#define ITS_REC_EVT_PPS         ( 2 )   /* value: PpsEvent_t.seq */
+#define ITS_REC_EVT_MARK        ( 3 )   /* value: user defined */
+#define ITS_REC_EVT_GAPS_MISSED ( 4 )   /* value: gaps before data_offset not recorded, indices after it are off */
+
+typedef struct its_rec_header {
+	char     magic[ 8 ];
+	uint32_t format;
+	uint32_t header_size;
+	uint32_t chunk_size;
+	uint32_t flags;         /* ITS_REC_* */
+	uint32_t fw_version;    /* CMD_GET_VERSION, 0 if unknown */
+	uint8_t  channels;
+	uint8_t  sample_bits;   /* Per channel */
+	uint8_t  sample_bytes;  /* Bytes per sample of all channels */
+	uint8_t  reserved;
+	double   sample_rate;   /* Hz, 0 if unknown */
+	uint64_t start_time_ns; /* CLOCK_REALTIME at creation */
+	uint64_t data_offset;
+	uint64_t data_bytes;
+	uint64_t lost_samples;  /* Sum over the overflow gaps */
+	uint64_t index_offset;
+	uint64_t index_count;
+	uint64_t event_offset;
+	uint64_t event_count;
+	uint64_t reg_offset;
+	uint64_t reg_count;
+} its_rec_header;
+
+typedef struct its_rec_index {
+	uint64_t data_offset;
+	uint64_t sample_index;  /* Of the sample at data_offset */
+} its_rec_index;
+
+typedef struct its_rec_event {
+	uint64_t data_offset;
+	uint64_t sample_index;
+	uint32_t type;          /* ITS_REC_EVT_* */
+	uint32_t reserved;
+	uint64_t value;
+} its_rec_event;
+
+/* One register write as sent with its_reg_write */
+typedef struct its_rec_reg {
+	uint8_t  b0;
+	uint8_t  b1;
+} its_rec_reg;
+
+/* ---- Writer ---- */
+
+typedef struct its_rec_writer its_rec_writer;
+
+typedef struct its_rec_config {
+	uint32_t chunk_size;    /* Multiple of ITS_REC_ALIGN */
+	double   sample_rate;
+	uint32_t fw_version;
+	const its_rec_reg* regs;
+	size_t   reg_count;
+} its_rec_config;
+
+void its_rec_defaults( its_rec_config* config );
+int  its_rec_create( its_rec_writer** rec, const char* path, const its_rec_config* config );
+/* Append stream bytes */
+int  its_rec_write( its_rec_writer* rec, const void* data, size_t len );
+/* lost samples are missing from the stream right before data_offset,
+ * which may lie in the past. Also records an ITS_REC_EVT_OVERFLOW. */
+int  its_rec_gap( its_rec_writer* rec, uint64_t data_offset, uint64_t lost );
+int  its_rec_add_event( its_rec_writer* rec, uint64_t data_offset, uint32_t type, uint64_t value );
+uint64_t its_rec_written( const its_rec_writer* rec );
+/* Flush, write the tables and the header, close and free. */
+int  its_rec_finish( its_rec_writer* rec );
+
+/* ---- Reader ---- */
+
+typedef struct its_rec_reader its_rec_reader;
+
+int  its_rec_open( its_rec_reader** rec, const char* path );
+void its_rec_close( its_rec_reader* rec );
+
+const its_rec_header* its_rec_info( const its_rec_reader* rec );
+const uint8_t* its_rec_data( const its_rec_reader* rec, uint64_t* bytes );
+const its_rec_index* its_rec_index_table( const its_rec_reader* rec, uint64_t* count );
+const its_rec_event* its_rec_events( const its_rec_reader* rec, uint64_t* count );
+const its_rec_reg* its_rec_regs( const its_rec_reader* rec, uint64_t* count );
+
+/* Data offset of a sample. Returns 0, 1 if the sample was lost in a gap
+ * (offset is then the first sample after the gap), or an error. */
+int  its_rec_find_sample( const its_rec_reader* rec, uint64_t sample, uint64_t* data_offset );
+/* Sample index of the sample at data_offset */
+uint64_t its_rec_sample_at( const its_rec_reader* rec, uint64_t data_offset );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ITSFX3_REC_H_ */
@@ -0,0 +1,308 @@
+/*
+ * Sample unpack kernels, see itsfx3_unpack.h.
+ *
+ * Every byte holds one 2 bit code per channel, bit 0 magnitude, bit 1
+ * sign. The vector kernels take 16 (SSE2) or 32 (AVX2) bytes at a time:
+ * shift the channel down with a 16 bit shift, mask to the code, map the
+ * code to its value and store the lanes to the channel array.
+ *
+ * SSE2 has no byte shuffle, so the value is computed: v = 1 + 2 m, then
+ * negated with (v ^ -s) + s. AVX2 maps the code through a vpshufb table.
+ * Float output sign extends the int8 values and converts 4 or 8 at a time.
+ */
+
+#include "itsfx3_unpack.h"
+
+#if ITS_SAMPLE_CHANNELS != 4 || ITS_SAMPLE_BITS != 2
+#error "Kernels are written for four 2 bit channels per byte"
+#endif
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define ITS_UNPACK_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void ( *unpack_i8_fn )( const uint8_t*, size_t, int8_t* const* );
+typedef void ( *unpack_f32_fn )( const uint8_t*, size_t, float* const* );
+
+/* Byte to the four channel values, channel c in byte c */
+static int8_t lut_i8[ 256 ][ ITS_SAMPLE_CHANNELS ];
+static int lut_ready = 0;
+
+static void lut_init( void )
+{
+	int b, c;
+
+	for ( b = 0; b < 256; b++ )
+		for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ )
+			lut_i8[ b ][ c ] = (int8_t)ITS_SAMPLE_VALUE( ITS_SAMPLE_CODE( b, c ) );
+	lut_ready = 1;
+}
+
+/* ---- Scalar ---- */
+
+static void unpack_i8_scalar( const uint8_t* in, size_t len, int8_t* const* out )
+{
+	int8_t* o0 = out[ 0 ];
+	int8_t* o1 = out[ 1 ];
+	int8_t* o2 = out[ 2 ];
+	int8_t* o3 = out[ 3 ];
+	const int8_t* v;
+	size_t i;
+
+	for ( i = 0; i < len; i++ ) {
+		v = lut_i8[ in[ i ] ];
+		o0[ i ] = v[ 0 ];
+		o1[ i ] = v[ 1 ];
+		o2[ i ] = v[ 2 ];
+		o3[ i ] = v[ 3 ];
+	}
+}
+
+static void unpack_f32_scalar( const uint8_t* in, size_t len, float* const* out )
+{
+	float* o0 = out[ 0 ];
+	float* o1 = out[ 1 ];
+	float* o2 = out[ 2 ];
+	float* o3 = out[ 3 ];
+	const int8_t* v;
+	size_t i;
+
+	for ( i = 0; i < len; i++ ) {
+		v = lut_i8[ in[ i ] ];
+		o0[ i ] = v[ 0 ];
+		o1[ i ] = v[ 1 ];
+		o2[ i ] = v[ 2 ];
+		o3[ i ] = v[ 3 ];
+	}
+}
+
+#ifdef ITS_UNPACK_X86
+
+/* ---- SSE2 ---- */
+
+__attribute__(( target( "sse2" ) ))
+static inline __m128i sse2_values( __m128i bytes, int ch )
+{
+	const __m128i one = _mm_set1_epi8( 1 );
+	__m128i code = _mm_srli_epi16( bytes, ITS_SAMPLE_BITS * ch );
+	__m128i m = _mm_and_si128( code, one );
+	__m128i s = _mm_and_si128( _mm_srli_epi16( code, 1 ), one );
+	__m128i neg = _mm_sub_epi8( _mm_setzero_si128(), s );
+	__m128i v = _mm_add_epi8( _mm_add_epi8( m, m ), one );
+	return _mm_add_epi8( _mm_xor_si128( v, neg ), s );
+}
+
+__attribute__(( target( "sse2" ) ))
+static void unpack_i8_sse2( const uint8_t* in, size_t len, int8_t* const* out )
+{
+	size_t i, n = len & ~(size_t)15;
+	__m128i b;
+	int c;
+
+	for ( i = 0; i < n; i += 16 ) {
+		b = _mm_loadu_si128( (const __m128i*)( in + i ) );
+		for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ )
+			_mm_storeu_si128( (__m128i*)( out[ c ] + i ), sse2_values( b, c ) );
+	}
+	if ( n < len ) {
+		int8_t* tail[ ITS_SAMPLE_CHANNELS ];
+		for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ )
+			tail[ c ] = out[ c ] + n;
+		unpack_i8_scalar( in + n, len - n, tail );
+	}
+}
+
+/* Sign extend 16 int8 and store them as floats */
+__attribute__(( target( "sse2" ) ))
+static inline void sse2_store_f32( float* out, __m128i v )
+{
+	__m128i sign = _mm_cmpgt_epi8( _mm_setzero_si128(), v );
+	__m128i lo = _mm_unpacklo_epi8( v, sign );
+	__m128i hi = _mm_unpackhi_epi8( v, sign );
+	__m128i slo = _mm_srai_epi16( lo, 15 );
+	__m128i shi = _mm_srai_epi16( hi, 15 );
+
+	_mm_storeu_ps( out + 0, _mm_cvtepi32_ps( _mm_unpacklo_epi16( lo, slo ) ) );
+	_mm_storeu_ps( out + 4, _mm_cvtepi32_ps( _mm_unpackhi_epi16( lo, slo ) ) );
+	_mm_storeu_ps( out + 8, _mm_cvtepi32_ps( _mm_unpacklo_epi16( hi, shi ) ) );
+	_mm_storeu_ps( out + 12, _mm_cvtepi32_ps( _mm_unpackhi_epi16( hi, shi ) ) );
+}
+
+__attribute__(( target( "sse2" ) ))
+static void unpack_f32_sse2( const uint8_t* in, size_t len, float* const* out )
+{
+	size_t i, n = len & ~(size_t)15;
+	__m128i b;
+	int c;
+
+	for ( i = 0; i < n; i += 16 ) {
+		b = _mm_loadu_si128( (const __m128i*)( in + i ) );
+		for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ )
+			sse2_store_f32( out[ c ] + i, sse2_values( b, c ) );
+	}
+	if ( n < len ) {
+		float* tail[ ITS_SAMPLE_CHANNELS ];
+		for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ )
+			tail[ c ] = out[ c ] + n;
+		unpack_f32_scalar( in + n, len - n, tail );
+	}
+}
+
+/* ---- AVX2 ---- */
+
+__attribute__(( target( "avx2" ) ))
+static inline __m256i avx2_values( __m256i bytes, __m256i table, int ch )
+{
+	const __m256i mask = _mm256_set1_epi8( 0x3 );
+	__m256i code = _mm256_and_si256( _mm256_srli_epi16( bytes, ITS_SAMPLE_BITS * ch ), mask );
+	return _mm256_shuffle_epi8( table, code );
+}
+
+__attribute__(( target( "avx2" ) ))
+static inline __m256i avx2_table( void )
+{
+	return _mm256_setr_epi8(
+			ITS_SAMPLE_VALUE( 0 ), ITS_SAMPLE_VALUE( 1 ), ITS_SAMPLE_VALUE( 2 ), ITS_SAMPLE_VALUE( 3 ),
+			0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+			ITS_SAMPLE_VALUE( 0 ), ITS_SAMPLE_VALUE( 1 ), ITS_SAMPLE_VALUE( 2 ), ITS_SAMPLE_VALUE( 3 ),
+			0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 );
+}
+
+__attribute__(( target( "avx2" ) ))
+static void unpack_i8_avx2( const uint8_t* in, size_t len, int8_t* const* out )
+{
+	const __m256i table = avx2_table();
+	size_t i, n = len & ~(size_t)31;
+	__m256i b;
+	int c;
+
+	for ( i = 0; i < n; i += 32 ) {
+		b = _mm256_loadu_si256( (const __m256i*)( in + i ) );
+		for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ )
+			_mm256_storeu_si256( (__m256i*)( out[ c ] + i ), avx2_values( b, table, c ) );
+	}
+	if ( n < len ) {
+		int8_t* tail[ ITS_SAMPLE_CHANNELS ];
+		for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ )
+			tail[ c ] = out[ c ] + n;
+		unpack_i8_scalar( in + n, len - n, tail );
+	}
+}
+
+__attribute__(( target( "avx2" ) ))
+static void unpack_f32_avx2( const uint8_t* in, size_t len, float* const* out )
+{
+	const __m256i table = avx2_table();
+	size_t i, n = len & ~(size_t)31;
+	__m256i b, v;
+	__m128i lo, hi;
+	float* o;
+	int c;
+
+	for ( i = 0; i < n; i += 32 ) {
+		b = _mm256_loadu_si256( (const __m256i*)( in + i ) );
+		for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ ) {
+			v = avx2_values( b, table, c );
+			lo = _mm256_castsi256_si128( v );
+			hi = _mm256_extracti128_si256( v, 1 );
+			o = out[ c ] + i;
+			_mm256_storeu_ps( o + 0, _mm256_cvtepi32_ps( _mm256_cvtepi8_epi32( lo ) ) );
+			_mm256_storeu_ps( o + 8, _mm256_cvtepi32_ps( _mm256_cvtepi8_epi32( _mm_srli_si128( lo, 8 ) ) ) );
+			_mm256_storeu_ps( o + 16, _mm256_cvtepi32_ps( _mm256_cvtepi8_epi32( hi ) ) );
+			_mm256_storeu_ps( o + 24, _mm256_cvtepi32_ps( _mm256_cvtepi8_epi32( _mm_srli_si128( hi, 8 ) ) ) );
+		}
+	}
+	if ( n < len ) {
+		float* tail[ ITS_SAMPLE_CHANNELS ];
+		for ( c = 0; c < ITS_SAMPLE_CHANNELS; c++ )
+			tail[ c ] = out[ c ] + n;
+		unpack_f32_scalar( in + n, len - n, tail );
+	}
+}
+
+#endif /* ITS_UNPACK_X86 */
+
+/* ---- Dispatch ---- */
+
+static unpack_i8_fn unpack_i8 = NULL;
+static unpack_f32_fn unpack_f32 = NULL;
+
+int its_unpack_supported( its_unpack_kernel kernel )
+{
+#ifdef ITS_UNPACK_X86
+	__builtin_cpu_init();
+#endif
+	switch ( kernel ) {
+	case ITS_UNPACK_AUTO:
+	case ITS_UNPACK_SCALAR:
+		return 1;
+#ifdef ITS_UNPACK_X86
+	case ITS_UNPACK_SSE2:
+		return __builtin_cpu_supports( "sse2" );
+	case ITS_UNPACK_AVX2:
+		return __builtin_cpu_supports( "avx2" );
+#endif
+	default:
+		return 0;
+	}
+}
+
+const char* its_unpack_name( its_unpack_kernel kernel )
+{
+	switch ( kernel ) {
+	case ITS_UNPACK_AUTO:   return "auto";
+	case ITS_UNPACK_SCALAR: return "scalar";
+	case ITS_UNPACK_SSE2:   return "sse2";
+	case ITS_UNPACK_AVX2:   return "avx2";
+	}
+	return "unknown";
+}
+
+its_unpack_kernel its_unpack_select( its_unpack_kernel kernel )
+{
+	if ( !lut_ready )
+		lut_init();
+
+	if ( kernel == ITS_UNPACK_AUTO || !its_unpack_supported( kernel ) ) {
+		if ( its_unpack_supported( ITS_UNPACK_AVX2 ) )
+			kernel = ITS_UNPACK_AVX2;
+		else if ( its_unpack_supported( ITS_UNPACK_SSE2 ) )
+			kernel = ITS_UNPACK_SSE2;
+		else
+			kernel = ITS_UNPACK_SCALAR;
+	}
+
+	switch ( kernel ) {
+#ifdef ITS_UNPACK_X86
+	case ITS_UNPACK_AVX2:
+		unpack_i8 = unpack_i8_avx2;
+		unpack_f32 = unpack_f32_avx2;
+		break;
+	case ITS_UNPACK_SSE2:
+		unpack_i8 = unpack_i8_sse2;
+		unpack_f32 = unpack_f32_sse2;
+		break;
+#endif
+	default:
+		kernel = ITS_UNPACK_SCALAR;
+		unpack_i8 = unpack_i8_scalar;
+		unpack_f32 = unpack_f32_scalar;
+		break;
+	}
+	return kernel;
+}
+
+void its_unpack_i8( const uint8_t* in, size_t len, int8_t* const out[ ITS_SAMPLE_CHANNELS ] )
+{
+	if ( !unpack_i8 )
+		its_unpack_select( ITS_UNPACK_AUTO );
+	unpack_i8( in, len, out );
+}
+
+void its_unpack_f32( const uint8_t* in, size_t len, float* const out[ ITS_SAMPLE_CHANNELS ] )
+{
+	if ( !unpack_f32 )
+		its_unpack_select( ITS_UNPACK_AUTO );
+	unpack_f32( in, len, out );
+}
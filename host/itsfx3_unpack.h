@@ -0,0 +1,44 @@
+#ifndef ITSFX3_UNPACK_H_
+#define ITSFX3_UNPACK_H_
+
+/*
+ * Unpacking of the raw GPIF byte stream into one array per channel.
+ * The bit layout and the code to value map are its_sample_format.h, the
+ * same header the firmware builds with.
+ *
+ * Kernels: scalar table lookup, SSE2 and AVX2 on x86. The fastest kernel
+ * the CPU supports is picked on first use, its_unpack_select overrides.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "its_sample_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum its_unpack_kernel {
+	ITS_UNPACK_AUTO = 0,
+	ITS_UNPACK_SCALAR,
+	ITS_UNPACK_SSE2,
+	ITS_UNPACK_AVX2,
+} its_unpack_kernel;
+
+/* Use kernel if the CPU supports it, else the best one that is. Returns
+ * the kernel in use. */
+its_unpack_kernel its_unpack_select( its_unpack_kernel kernel );
+int its_unpack_supported( its_unpack_kernel kernel );
+const char* its_unpack_name( its_unpack_kernel kernel );
+
+/* Sample n of channel c is byte n of in, written to out[ c ][ n ]. Values
+ * are +-1 and +-3. out arrays hold len elements, no alignment needed. */
+void its_unpack_i8( const uint8_t* in, size_t len, int8_t* const out[ ITS_SAMPLE_CHANNELS ] );
+void its_unpack_f32( const uint8_t* in, size_t len, float* const out[ ITS_SAMPLE_CHANNELS ] );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ITSFX3_UNPACK_H_ */
@@ -0,0 +1,243 @@
+/*
+ * libusb backend of the ItsFx3 host library. Built with USB=1.
+ *
+ * Stream transfers are libusb async bulk transfers on EP 0x81. Their
+ * buffers come from libusb_dev_mem_alloc where the platform supports it
+ * (usbfs zero-copy on Linux), otherwise from the heap. Completions are
+ * collected by libusb_handle_events_timeout_completed on the thread that
+ * calls its_stream_run.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <libusb.h>
+
+#include "itsfx3_priv.h"
+
+#define USB_INTERFACE  ( 0 )
+
+typedef struct usb_dev {
+	libusb_context* ctx;
+	libusb_device_handle* handle;
+} usb_dev;
+
+typedef struct usb_xfer {
+	struct libusb_transfer* transfer;
+	int dev_mem;            /* Buffer from libusb_dev_mem_alloc */
+} usb_xfer;
+
+static int usb_error( int rc )
+{
+	switch ( rc ) {
+	case LIBUSB_ERROR_TIMEOUT:       return ITS_ERR_TIMEOUT;
+	case LIBUSB_ERROR_PIPE:          return ITS_ERR_STALL;
+	case LIBUSB_ERROR_NO_DEVICE:     return ITS_ERR_NO_DEVICE;
+	case LIBUSB_ERROR_NOT_FOUND:     return ITS_ERR_NO_DEVICE;
+	case LIBUSB_ERROR_NO_MEM:        return ITS_ERR_NO_MEM;
+	case LIBUSB_ERROR_INVALID_PARAM: return ITS_ERR_ARG;
+	case LIBUSB_ERROR_NOT_SUPPORTED: return ITS_ERR_NOT_SUPPORTED;
+	case LIBUSB_ERROR_BUSY:          return ITS_ERR_BUSY;
+	}
+	return ITS_ERR_IO;
+}
+
+static int usb_control( its_dev* dev, int in, uint8_t request, uint16_t value, uint16_t index,
+		void* data, uint16_t len )
+{
+	usb_dev* usb = dev->priv;
+	uint8_t type = LIBUSB_REQUEST_TYPE_VENDOR | LIBUSB_RECIPIENT_DEVICE |
+			( in ? LIBUSB_ENDPOINT_IN : LIBUSB_ENDPOINT_OUT );
+	int rc;
+
+	rc = libusb_control_transfer( usb->handle, type, request, value, index,
+			(unsigned char*)data, len, ITS_CTRL_TIMEOUT_MS );
+	return ( rc < 0 ) ? usb_error( rc ) : rc;
+}
+
+static void LIBUSB_CALL usb_transfer_cb( struct libusb_transfer* transfer )
+{
+	its_xfer* xfer = transfer->user_data;
+
+	xfer->actual = (size_t)transfer->actual_length;
+	switch ( transfer->status ) {
+	case LIBUSB_TRANSFER_COMPLETED:
+		xfer->status = ITS_XFER_OK;
+		break;
+	case LIBUSB_TRANSFER_TIMED_OUT:
+		/* Data received before the timeout is still valid */
+		xfer->status = ( xfer->actual > 0 ) ? ITS_XFER_OK : ITS_XFER_TIMEOUT;
+		break;
+	case LIBUSB_TRANSFER_CANCELLED:
+		xfer->status = ITS_XFER_CANCELLED;
+		break;
+	default:
+		xfer->status = ITS_XFER_ERROR;
+		break;
+	}
+	its_xfer_done( xfer );
+}
+
+static int usb_xfer_init( its_dev* dev, its_xfer* xfer )
+{
+	usb_dev* usb = dev->priv;
+	usb_xfer* ux;
+
+	ux = calloc( 1, sizeof( usb_xfer ) );
+	if ( !ux )
+		return ITS_ERR_NO_MEM;
+	ux->transfer = libusb_alloc_transfer( 0 );
+	if ( !ux->transfer ) {
+		free( ux );
+		return ITS_ERR_NO_MEM;
+	}
+
+#if defined( LIBUSB_API_VERSION ) && ( LIBUSB_API_VERSION >= 0x01000105 )
+	xfer->buf = libusb_dev_mem_alloc( usb->handle, xfer->size );
+	ux->dev_mem = ( xfer->buf != NULL );
+#endif
+	if ( !xfer->buf )
+		xfer->buf = malloc( xfer->size );
+	if ( !xfer->buf ) {
+		libusb_free_transfer( ux->transfer );
+		free( ux );
+		return ITS_ERR_NO_MEM;
+	}
+
+	xfer->priv = ux;
+	return ITS_OK;
+}
+
+static void usb_xfer_free( its_dev* dev, its_xfer* xfer )
+{
+	usb_xfer* ux = xfer->priv;
+
+	if ( !ux )
+		return;
+#if defined( LIBUSB_API_VERSION ) && ( LIBUSB_API_VERSION >= 0x01000105 )
+	if ( ux->dev_mem )
+		libusb_dev_mem_free( ( (usb_dev*)dev->priv )->handle, xfer->buf, xfer->size );
+	else
+		free( xfer->buf );
+#else
+	(void)dev;
+	free( xfer->buf );
+#endif
+	libusb_free_transfer( ux->transfer );
+	free( ux );
+	xfer->buf = NULL;
+	xfer->priv = NULL;
+}
+
+static int usb_submit( its_dev* dev, its_xfer* xfer, int timeout_ms )
+{
+	usb_dev* usb = dev->priv;
+	usb_xfer* ux = xfer->priv;
+	int rc;
+
+	libusb_fill_bulk_transfer( ux->transfer, usb->handle, ITS_EP_STREAM, xfer->buf,
+			(int)xfer->size, usb_transfer_cb, xfer, (unsigned int)timeout_ms );
+	rc = libusb_submit_transfer( ux->transfer );
+	return ( rc < 0 ) ? usb_error( rc ) : ITS_OK;
+}
+
+static void usb_cancel( its_dev* dev, its_xfer* xfer )
+{
+	usb_xfer* ux = xfer->priv;
+
+	(void)dev;
+	libusb_cancel_transfer( ux->transfer );
+}
+
+static int usb_handle_events( its_dev* dev, int timeout_ms )
+{
+	usb_dev* usb = dev->priv;
+	struct timeval tv;
+	int rc;
+
+	tv.tv_sec = timeout_ms / 1000;
+	tv.tv_usec = ( timeout_ms % 1000 ) * 1000;
+	rc = libusb_handle_events_timeout_completed( usb->ctx, &tv, NULL );
+	if ( rc == LIBUSB_ERROR_INTERRUPTED )
+		return ITS_OK;
+	return ( rc < 0 ) ? usb_error( rc ) : ITS_OK;
+}
+
+static int usb_bulk_read( its_dev* dev, void* buf, size_t len, size_t* actual, int timeout_ms )
+{
+	usb_dev* usb = dev->priv;
+	int got = 0;
+	int rc;
+
+	rc = libusb_bulk_transfer( usb->handle, ITS_EP_STREAM, buf, (int)len, &got, (unsigned int)timeout_ms );
+	if ( actual )
+		*actual = (size_t)got;
+	if ( rc == LIBUSB_ERROR_TIMEOUT && got > 0 )
+		return ITS_OK;
+	return ( rc < 0 ) ? usb_error( rc ) : ITS_OK;
+}
+
+static void usb_close( its_dev* dev )
+{
+	usb_dev* usb = dev->priv;
+
+	libusb_release_interface( usb->handle, USB_INTERFACE );
+	libusb_close( usb->handle );
+	libusb_exit( usb->ctx );
+	free( usb );
+}
+
+static const its_backend usb_backend = {
+	usb_control,
+	usb_xfer_init,
+	usb_xfer_free,
+	usb_submit,
+	usb_cancel,
+	usb_handle_events,
+	usb_bulk_read,
+	usb_close,
+};
+
+int its_open_usb( its_dev** dev, uint16_t vid, uint16_t pid )
+{
+	its_dev* d;
+	usb_dev* usb;
+	int rc;
+
+	if ( !dev )
+		return ITS_ERR_ARG;
+	d = calloc( 1, sizeof( its_dev ) );
+	usb = calloc( 1, sizeof( usb_dev ) );
+	if ( !d || !usb ) {
+		rc = ITS_ERR_NO_MEM;
+		goto fail;
+	}
+
+	rc = libusb_init( &usb->ctx );
+	if ( rc < 0 ) {
+		rc = usb_error( rc );
+		goto fail;
+	}
+	usb->handle = libusb_open_device_with_vid_pid( usb->ctx, vid, pid );
+	if ( !usb->handle ) {
+		rc = ITS_ERR_NO_DEVICE;
+		goto fail_exit;
+	}
+	rc = libusb_claim_interface( usb->handle, USB_INTERFACE );
+	if ( rc < 0 ) {
+		rc = usb_error( rc );
+		libusb_close( usb->handle );
+		goto fail_exit;
+	}
+
+	d->backend = &usb_backend;
+	d->priv = usb;
+	*dev = d;
+	return ITS_OK;
+
+fail_exit:
+	libusb_exit( usb->ctx );
+fail:
+	free( usb );
+	free( d );
+	return rc;
+}
@@ -0,0 +1,206 @@
+/*
+ * itslatency: how old stream data is when the application gets it, with
+ * and without CMD_FLUSH_DEADLINE.
+ *
+ *   itslatency [-u] [-s seconds] [-r rate MB/s] [-f deadline ms] [-t transfers] [-S transfer KB]
+ *
+ * Byte n of the stream is taken n / rate after the stream start, so the
+ * time a completed transfer reaches the callback, less the time its first
+ * and last byte were taken, is their age. The host clock stands in for
+ * the sample clock: the ages carry a constant bias of the start command
+ * on a real device and the rate must be the actual front-end rate.
+ *
+ * The stream is run once without a deadline and once with it. Without -u
+ * the loopback device models the rate.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "itsfx3.h"
+
+typedef struct latency_state {
+	double   t_start;
+	double   deadline;
+	double   rate;          /* Bytes per second */
+	double*  oldest;        /* Age of the first byte of each transfer, s */
+	double*  newest;        /* Age of the last byte */
+	size_t   count;
+	size_t   alloc;
+} latency_state;
+
+static double now_sec( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int latency_cb( const its_buffer* buf, void* user )
+{
+	latency_state* st = user;
+	double t = now_sec();
+	double* p;
+
+	if ( st->count == st->alloc ) {
+		st->alloc = st->alloc ? st->alloc * 2 : 4096;
+		p = realloc( st->oldest, st->alloc * sizeof( double ) );
+		if ( !p )
+			return ITS_ERR_NO_MEM;
+		st->oldest = p;
+		p = realloc( st->newest, st->alloc * sizeof( double ) );
+		if ( !p )
+			return ITS_ERR_NO_MEM;
+		st->newest = p;
+	}
+	st->oldest[ st->count ] = t - ( st->t_start + buf->offset / st->rate );
+	st->newest[ st->count ] = t - ( st->t_start + ( buf->offset + buf->length ) / st->rate );
+	st->count++;
+	return t >= st->deadline;
+}
+
+static int cmp_double( const void* a, const void* b )
+{
+	double x = *(const double*)a;
+	double y = *(const double*)b;
+	return ( x > y ) - ( x < y );
+}
+
+static double percentile( const double* sorted, size_t n, double p )
+{
+	size_t i = (size_t)( p * ( n - 1 ) + 0.5 );
+	return sorted[ i < n ? i : n - 1 ];
+}
+
+/* Rate argument of CMD_FLUSH_DEADLINE */
+static uint16_t rate_kbps( double rate_mbps )
+{
+	double kbps = rate_mbps * 1000.0;
+	return kbps >= 65535 ? 65535 : kbps < 1 ? 1 : (uint16_t)kbps;
+}
+
+/* One stream, prints a line. Returns 0 on success. */
+static int run( its_dev* dev, const its_stream_config* config, double rate_mbps, uint16_t flush_ms, double seconds )
+{
+	its_stream_stats stats;
+	FlushStatus_t flush;
+	latency_state st;
+	double t0;
+	int rc;
+
+	rc = its_flush_deadline( dev, flush_ms, rate_kbps( rate_mbps ) );
+	if ( rc != ITS_OK ) {
+		printf( "%8u ms  not supported by the image (%s)\n", flush_ms, its_strerror( rc ) );
+		return rc == ITS_ERR_STALL ? 0 : 1;
+	}
+
+	memset( &st, 0, sizeof( st ) );
+	st.rate = rate_mbps * 1e6;
+	rc = its_stream_start( dev, config, latency_cb, &st );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "stream start: %s\n", its_strerror( rc ) );
+		return 1;
+	}
+	/* The device starts somewhere within the command */
+	t0 = now_sec();
+	rc = its_cmd_stream_start( dev );
+	st.t_start = ( t0 + now_sec() ) / 2;
+	st.deadline = st.t_start + seconds;
+	if ( rc == ITS_OK ) {
+		while ( ( rc = its_stream_run( dev, 100 ) ) > 0 )
+			;
+	}
+	its_stream_get_stats( dev, &stats );
+	its_stream_stop( dev );
+	its_cmd_stream_stop( dev );
+	if ( rc < 0 ) {
+		fprintf( stderr, "stream: %s\n", its_strerror( rc ) );
+		free( st.oldest );
+		free( st.newest );
+		return 1;
+	}
+	if ( its_read_flush( dev, &flush ) != ITS_OK )
+		memset( &flush, 0, sizeof( flush ) );
+
+	if ( st.count == 0 ) {
+		printf( "%8u ms  no data\n", flush_ms );
+	} else {
+		qsort( st.oldest, st.count, sizeof( double ), cmp_double );
+		qsort( st.newest, st.count, sizeof( double ), cmp_double );
+		printf( "%8u ms %9.2f %9.2f %9.2f %9.2f %9.2f %8zu %8llu %8lu\n", flush_ms,
+				percentile( st.newest, st.count, 0 ) * 1e3,
+				percentile( st.oldest, st.count, 0.5 ) * 1e3,
+				percentile( st.oldest, st.count, 0.9 ) * 1e3,
+				percentile( st.oldest, st.count, 0.99 ) * 1e3,
+				percentile( st.oldest, st.count, 1 ) * 1e3,
+				st.count, (unsigned long long)stats.short_buffers, (unsigned long)flush.buffer_bytes );
+	}
+	free( st.oldest );
+	free( st.newest );
+	return 0;
+}
+
+static void usage( const char* name )
+{
+	fprintf( stderr,
+			"usage: %s [-u] [-s seconds] [-r rate MB/s] [-f deadline ms] [-t transfers] [-S transfer KB]\n"
+			"  -r is the front-end data rate, also modelled by the loopback without -u\n", name );
+}
+
+int main( int argc, char** argv )
+{
+	its_stream_config config;
+	its_loopback_config lb;
+	its_dev* dev = NULL;
+	double seconds = 2.0;
+	double rate = 1.0;
+	unsigned flush_ms = 4;
+	int use_usb = 0;
+	int opt, rc;
+
+	its_loopback_defaults( &lb );
+	its_stream_defaults( &config );
+	config.transfers = 8;
+	config.transfer_size = 64 * 1024;
+	while ( ( opt = getopt( argc, argv, "us:r:f:t:S:h" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'u': use_usb = 1; break;
+		case 's': seconds = atof( optarg ); break;
+		case 'r': rate = atof( optarg ); break;
+		case 'f': flush_ms = (unsigned)atoi( optarg ); break;
+		case 't': config.transfers = (unsigned)atoi( optarg ); break;
+		case 'S': config.transfer_size = (size_t)atoi( optarg ) * 1024; break;
+		default: usage( argv[ 0 ] ); return 2;
+		}
+	}
+	if ( rate <= 0 || flush_ms < FLUSH_DEADLINE_MIN_MS || flush_ms > FLUSH_DEADLINE_MAX_MS ) {
+		fprintf( stderr, "rate > 0 and deadline %d .. %d ms\n", FLUSH_DEADLINE_MIN_MS, FLUSH_DEADLINE_MAX_MS );
+		return 2;
+	}
+
+	lb.sample_mbps = rate;
+	if ( use_usb )
+		rc = its_open_usb( &dev, ITS_USB_VID, ITS_USB_PID );
+	else
+		rc = its_open_loopback( &dev, &lb );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "open: %s\n", its_strerror( rc ) );
+		return 1;
+	}
+
+	printf( "%s, %.2f MB/s, %u x %zu KB transfers, %.1f s per run, ages in ms\n",
+			use_usb ? "device" : "loopback", rate, config.transfers, config.transfer_size / 1024, seconds );
+	printf( "%11s %9s %9s %9s %9s %9s %8s %8s %8s\n", "deadline", "newest", "p50", "p90", "p99", "max",
+			"xfers", "short", "buffer" );
+	rc = run( dev, &config, rate, 0, seconds );
+	if ( rc == 0 )
+		rc = run( dev, &config, rate, (uint16_t)flush_ms, seconds );
+	its_flush_deadline( dev, 0, 0 );
+
+	its_close( dev );
+	return rc;
+}
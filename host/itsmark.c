@@ -0,0 +1,177 @@
+/*
+ * itsmark: sample latency from the front-end pins to the application,
+ * measured with the marker line of CMD_LATENCY_MARK.
+ *
+ *   itsmark [-u] [-s seconds] [-r rate MB/s] [-f deadline ms] [-p mark period ms]
+ *           [-t transfers] [-S transfer KB]
+ *
+ * The marker is toggled at random intervals around the period while the
+ * stream runs and every edge is timed on its way to the stream callback,
+ * see itsfx3_probe.h. Unlike itslatency this needs neither the sample rate
+ * nor a start time, the edge itself is the reference.
+ *
+ * Without -u the loopback device models the marker, the rate and the
+ * flush. The tool fails if marks were set but no edge came back.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "itsfx3.h"
+#include "itsfx3_probe.h"
+
+typedef struct mark_state {
+	its_probe probe;
+	double   deadline;
+	int      error;
+} mark_state;
+
+static double now_sec( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int mark_cb( const its_buffer* buf, void* user )
+{
+	mark_state* st = user;
+	int rc = its_probe_feed( &st->probe, buf );
+
+	if ( rc < 0 ) {
+		st->error = rc;
+		return 1;
+	}
+	return now_sec() >= st->deadline;
+}
+
+static void usage( const char* name )
+{
+	fprintf( stderr,
+			"usage: %s [-u] [-s seconds] [-r rate MB/s] [-f deadline ms] [-p mark period ms]"
+			" [-t transfers] [-S transfer KB]\n"
+			"  -r and -f only shape the loopback stream, 0 is unlimited / off\n", name );
+}
+
+int main( int argc, char** argv )
+{
+	its_stream_config config;
+	its_loopback_config lb;
+	its_stream_stats stats;
+	its_probe* probe;
+	mark_state st;
+	its_dev* dev = NULL;
+	double seconds = 2.0;
+	double rate = 1.0;
+	double period_ms = 20.0;
+	double next, t;
+	unsigned flush_ms = 0;
+	uint16_t kbps;
+	uint64_t rng = 1;
+	int use_usb = 0;
+	int opt, rc;
+
+	its_loopback_defaults( &lb );
+	its_stream_defaults( &config );
+	config.transfers = 8;
+	config.transfer_size = 64 * 1024;
+	while ( ( opt = getopt( argc, argv, "us:r:f:p:t:S:h" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'u': use_usb = 1; break;
+		case 's': seconds = atof( optarg ); break;
+		case 'r': rate = atof( optarg ); break;
+		case 'f': flush_ms = (unsigned)atoi( optarg ); break;
+		case 'p': period_ms = atof( optarg ); break;
+		case 't': config.transfers = (unsigned)atoi( optarg ); break;
+		case 'S': config.transfer_size = (size_t)atoi( optarg ) * 1024; break;
+		default: usage( argv[ 0 ] ); return 2;
+		}
+	}
+	if ( rate < 0 || period_ms <= 0 || seconds <= 0 ||
+			( flush_ms != 0 && ( flush_ms < FLUSH_DEADLINE_MIN_MS || flush_ms > FLUSH_DEADLINE_MAX_MS ) ) ) {
+		fprintf( stderr, "rate >= 0, period > 0 and deadline 0 or %d .. %d ms\n",
+				FLUSH_DEADLINE_MIN_MS, FLUSH_DEADLINE_MAX_MS );
+		return 2;
+	}
+
+	lb.sample_mbps = rate;
+	if ( use_usb )
+		rc = its_open_usb( &dev, ITS_USB_VID, ITS_USB_PID );
+	else
+		rc = its_open_loopback( &dev, &lb );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "open: %s\n", its_strerror( rc ) );
+		return 1;
+	}
+	/* Rate 0 is unlimited, which never needs smaller buffers */
+	kbps = ( rate == 0 || rate * 1000.0 >= 65535 ) ? 65535 : rate * 1000.0 < 1 ? 1 : (uint16_t)( rate * 1000.0 );
+	if ( its_flush_deadline( dev, (uint16_t)flush_ms, kbps ) != ITS_OK && flush_ms != 0 ) {
+		fprintf( stderr, "flush deadline not supported by the image, running without\n" );
+		flush_ms = 0;
+	}
+
+	memset( &st, 0, sizeof( st ) );
+	probe = &st.probe;
+	its_probe_init( probe );
+	rc = its_stream_start( dev, &config, mark_cb, &st );
+	if ( rc == ITS_OK )
+		rc = its_cmd_stream_start( dev );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "stream start: %s\n", its_strerror( rc ) );
+		its_close( dev );
+		return 1;
+	}
+
+	t = now_sec();
+	st.deadline = t + seconds;
+	next = t + period_ms * 1e-3;
+	while ( ( rc = its_stream_run( dev, 1 ) ) > 0 ) {
+		t = now_sec();
+		if ( t < next || t >= st.deadline - ITS_PROBE_TIMEOUT_S / 4 )
+			continue;
+		rc = its_probe_mark( dev, probe );
+		if ( rc == ITS_ERR_STALL ) {
+			fprintf( stderr, "the image has no marker line (ITS_FX3_LATENCY_MARK_LINE)\n" );
+			break;
+		}
+		if ( rc != ITS_OK && rc != ITS_ERR_BUSY ) {
+			fprintf( stderr, "mark: %s\n", its_strerror( rc ) );
+			break;
+		}
+		/* Uniform over 0.5 .. 1.5 periods, not locked to the buffers */
+		rng ^= rng << 13;
+		rng ^= rng >> 7;
+		rng ^= rng << 17;
+		next = t + period_ms * 1e-3 * ( 0.5 + ( rng >> 11 ) / 9007199254740992.0 );
+	}
+	its_stream_get_stats( dev, &stats );
+	its_stream_stop( dev );
+	its_cmd_stream_stop( dev );
+	its_flush_deadline( dev, 0, 0 );
+	its_close( dev );
+	if ( rc < 0 || st.error ) {
+		if ( rc < 0 && rc != ITS_ERR_STALL )
+			fprintf( stderr, "stream: %s\n", its_strerror( rc < 0 ? rc : st.error ) );
+		its_probe_free( probe );
+		return 1;
+	}
+
+	printf( "%s, %.2f MB/s, deadline %u ms, %u x %zu KB transfers, %.1f s, latency in ms\n",
+			use_usb ? "device" : "loopback", rate, flush_ms, config.transfers,
+			config.transfer_size / 1024, seconds );
+	printf( "%8s %8s %8s %9s %9s %9s %9s %9s %10s\n", "marks", "edges", "lost", "p50", "p90", "p99", "max",
+			"+/-", "lag bytes" );
+	printf( "%8llu %8zu %8llu %9.2f %9.2f %9.2f %9.2f %9.2f %10llu\n",
+			(unsigned long long)probe->marks, probe->count, (unsigned long long)probe->lost,
+			its_probe_percentile( probe, 0.5 ) * 1e3, its_probe_percentile( probe, 0.9 ) * 1e3,
+			its_probe_percentile( probe, 0.99 ) * 1e3, its_probe_percentile( probe, 1 ) * 1e3,
+			probe->half_max * 1e3, (unsigned long long)probe->lag_max );
+
+	rc = ( probe->marks > 0 && probe->count == 0 ) ? 1 : 0;
+	its_probe_free( probe );
+	return rc;
+}
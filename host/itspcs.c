@@ -0,0 +1,454 @@
+/*
+ * itspcs: where the firmware spends its time, from the PC histogram of an
+ * image built with ITS_FX3_PC_SAMPLE.
+ *
+ *   itspcs [-u] [-p period us] [-b bucket log2] [-s seconds] [-S] [-m map file]
+ *          [-n top] [-w dump] [-r dump]
+ *
+ * Samples for the given time, with -S while streaming, reads the histogram
+ * with CMD_READ_PC_SAMPLE and prints the busiest functions. Functions come
+ * from the GNU ld map file of the firmware build (cyfxslfifosync.map): the
+ * global symbols it lists and, for objects built with -ffunction-sections,
+ * the .text.<name> input sections, which also name static functions. Other
+ * code is attributed to its object file. A bucket goes to the function at
+ * its start, so with large buckets small neighbours blur together.
+ *
+ * -w writes the raw histogram ("address count" per line, counters as
+ * comments), -r reads one instead of a device, so a run can be mapped
+ * again against another map file. Without -m the busiest buckets are
+ * printed. Without -u the loopback device answers, which has no firmware
+ * to sample.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "itsfx3.h"
+
+typedef struct pcs_symbol {
+	uint32_t addr;
+	char     name[ 64 ];
+	uint64_t samples;
+} pcs_symbol;
+
+typedef struct pcs_map {
+	pcs_symbol* sym;
+	size_t   count;
+	size_t   alloc;
+} pcs_map;
+
+typedef struct pcs_hist {
+	PcSampleChunk_t head;   /* Counters, counts unused */
+	uint32_t counts[ PC_SAMPLE_BUCKETS ];
+} pcs_hist;
+
+static double now_sec( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int map_add( pcs_map* map, uint32_t addr, const char* name )
+{
+	pcs_symbol* p;
+
+	if ( map->count == map->alloc ) {
+		p = realloc( map->sym, ( map->alloc ? map->alloc * 2 : 1024 ) * sizeof( pcs_symbol ) );
+		if ( !p )
+			return ITS_ERR_NO_MEM;
+		map->sym = p;
+		map->alloc = map->alloc ? map->alloc * 2 : 1024;
+	}
+	p = &map->sym[ map->count++ ];
+	p->addr = addr;
+	snprintf( p->name, sizeof( p->name ), "%s", name );
+	p->samples = 0;
+	return ITS_OK;
+}
+
+static int cmp_addr( const void* a, const void* b )
+{
+	const pcs_symbol* x = a;
+	const pcs_symbol* y = b;
+	return ( x->addr > y->addr ) - ( x->addr < y->addr );
+}
+
+static int cmp_samples( const void* a, const void* b )
+{
+	const pcs_symbol* x = a;
+	const pcs_symbol* y = b;
+	return ( x->samples < y->samples ) - ( x->samples > y->samples );
+}
+
+static int is_ident( const char* s )
+{
+	if ( !isalpha( (unsigned char)*s ) && *s != '_' )
+		return 0;
+	for ( ; *s; s++ ) {
+		if ( !isalnum( (unsigned char)*s ) && *s != '_' )
+			return 0;
+	}
+	return 1;
+}
+
+/* Code symbols of an ld map file, sorted by address. Where a section and a
+ * symbol share an address the symbol name is kept. */
+static int map_load( pcs_map* map, const char* path )
+{
+	char line[ 512 ];
+	char section[ 256 ] = "";
+	char a[ 256 ], b[ 256 ], c[ 256 ], d[ 256 ];
+	unsigned long addr, size;
+	const char* file;
+	int in_map = 0;
+	int n, rc;
+	size_t i, j;
+	FILE* f;
+
+	f = fopen( path, "r" );
+	if ( !f )
+		return ITS_ERR_ARG;
+	while ( fgets( line, sizeof( line ), f ) ) {
+		if ( !in_map ) {
+			in_map = strncmp( line, "Linker script and memory map", 28 ) == 0;
+			continue;
+		}
+		n = sscanf( line, " %255s %255s %255s %255s", a, b, c, d );
+		rc = ITS_OK;
+
+		/* Input section: " .text[.name] 0xaddr 0xsize file.o", the name
+		 * on a line of its own when it is long */
+		if ( line[ 0 ] == ' ' && strncmp( a, ".text", 5 ) == 0 && ( a[ 5 ] == 0 || a[ 5 ] == '.' ) ) {
+			snprintf( section, sizeof( section ), "%s", a );
+			if ( n == 1 )
+				continue;
+			memmove( a, b, sizeof( a ) );
+			memmove( b, c, sizeof( b ) );
+			memmove( c, d, sizeof( c ) );
+			n--;
+		} else if ( section[ 0 ] && n == 3 && strncmp( a, "0x", 2 ) == 0 && strncmp( b, "0x", 2 ) == 0 ) {
+			/* Continuation of a long section name */
+		} else {
+			/* Symbol: "   0xaddr   name" */
+			if ( n == 2 && strncmp( a, "0x", 2 ) == 0 && is_ident( b ) &&
+					sscanf( a, "%lx", &addr ) == 1 && addr != 0 )
+				rc = map_add( map, (uint32_t)addr, b );
+			section[ 0 ] = 0;
+			if ( rc != ITS_OK )
+				break;
+			continue;
+		}
+
+		if ( n >= 3 && sscanf( a, "%lx", &addr ) == 1 && sscanf( b, "%lx", &size ) == 1 && size != 0 ) {
+			if ( section[ 5 ] == '.' && is_ident( section + 6 ) ) {
+				rc = map_add( map, (uint32_t)addr, section + 6 );
+			} else {
+				file = strrchr( c, '/' );
+				snprintf( d, sizeof( d ), "(%s)", file ? file + 1 : c );
+				rc = map_add( map, (uint32_t)addr, d );
+			}
+		}
+		section[ 0 ] = 0;
+		if ( rc != ITS_OK )
+			break;
+	}
+	fclose( f );
+	if ( rc != ITS_OK )
+		return rc;
+
+	qsort( map->sym, map->count, sizeof( pcs_symbol ), cmp_addr );
+	for ( i = 0, j = 0; i < map->count; i++ ) {
+		if ( j > 0 && map->sym[ j - 1 ].addr == map->sym[ i ].addr ) {
+			if ( map->sym[ j - 1 ].name[ 0 ] == '(' )
+				map->sym[ j - 1 ] = map->sym[ i ];
+			continue;
+		}
+		map->sym[ j++ ] = map->sym[ i ];
+	}
+	map->count = j;
+	return map->count ? ITS_OK : ITS_ERR_FORMAT;
+}
+
+/* Symbol at or below addr */
+static pcs_symbol* map_find( pcs_map* map, uint32_t addr )
+{
+	size_t lo = 0, hi = map->count;
+
+	while ( hi - lo > 1 ) {
+		size_t mid = ( lo + hi ) / 2;
+		if ( map->sym[ mid ].addr <= addr )
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return ( map->count && map->sym[ lo ].addr <= addr ) ? &map->sym[ lo ] : NULL;
+}
+
+static int read_device( its_dev* dev, pcs_hist* hist )
+{
+	PcSampleChunk_t chunk;
+	uint16_t i;
+	int rc;
+
+	for ( i = 0; i < PC_SAMPLE_BUCKETS / PC_SAMPLE_CHUNK; i++ ) {
+		rc = its_read_pc_sample( dev, i, &chunk );
+		if ( rc != ITS_OK )
+			return rc;
+		if ( !chunk.supported )
+			return ITS_ERR_NOT_SUPPORTED;
+		if ( chunk.base != PC_SAMPLE_BASE || chunk.buckets != PC_SAMPLE_BUCKETS )
+			return ITS_ERR_FORMAT;
+		memcpy( &hist->counts[ chunk.first ], chunk.counts, sizeof( chunk.counts ) );
+		if ( i == 0 )
+			hist->head = chunk;
+	}
+	return ITS_OK;
+}
+
+/* Counters of the dump header, in file order */
+static void dump_counters( pcs_hist* hist, const char** names, uint32_t** values )
+{
+	static const char* const n[] = { "samples", "idle", "nested", "itcm", "other", "unknown" };
+	size_t i;
+
+	for ( i = 0; i < 6; i++ )
+		names[ i ] = n[ i ];
+	values[ 0 ] = &hist->head.samples;
+	values[ 1 ] = &hist->head.idle;
+	values[ 2 ] = &hist->head.nested;
+	values[ 3 ] = &hist->head.itcm;
+	values[ 4 ] = &hist->head.other;
+	values[ 5 ] = &hist->head.unknown;
+}
+
+static int write_dump( const char* path, pcs_hist* hist )
+{
+	const char* names[ 6 ];
+	uint32_t* values[ 6 ];
+	FILE* f = fopen( path, "w" );
+	size_t i;
+
+	if ( !f )
+		return ITS_ERR_ARG;
+	dump_counters( hist, names, values );
+	fprintf( f, "# shift %u\n", hist->head.shift );
+	for ( i = 0; i < 6; i++ )
+		fprintf( f, "# %s %lu\n", names[ i ], (unsigned long)*values[ i ] );
+	for ( i = 0; i < PC_SAMPLE_BUCKETS; i++ ) {
+		if ( hist->counts[ i ] )
+			fprintf( f, "0x%08lx %lu\n", (unsigned long)( PC_SAMPLE_BASE + ( i << hist->head.shift ) ),
+					(unsigned long)hist->counts[ i ] );
+	}
+	return fclose( f ) == 0 ? ITS_OK : ITS_ERR_IO;
+}
+
+static int read_dump( const char* path, pcs_hist* hist )
+{
+	const char* names[ 6 ];
+	uint32_t* values[ 6 ];
+	char line[ 256 ], name[ 64 ];
+	unsigned long addr, value;
+	size_t i;
+	FILE* f = fopen( path, "r" );
+
+	if ( !f )
+		return ITS_ERR_ARG;
+	dump_counters( hist, names, values );
+	hist->head.supported = 1;
+	while ( fgets( line, sizeof( line ), f ) ) {
+		if ( sscanf( line, "# %63s %lu", name, &value ) == 2 ) {
+			if ( strcmp( name, "shift" ) == 0 && value <= PC_SAMPLE_SHIFT_MAX )
+				hist->head.shift = (uint8_t)value;
+			for ( i = 0; i < 6; i++ ) {
+				if ( strcmp( name, names[ i ] ) == 0 )
+					*values[ i ] = (uint32_t)value;
+			}
+		} else if ( sscanf( line, "%lx %lu", &addr, &value ) == 2 && addr >= PC_SAMPLE_BASE &&
+				( ( addr - PC_SAMPLE_BASE ) >> hist->head.shift ) < PC_SAMPLE_BUCKETS ) {
+			hist->counts[ ( addr - PC_SAMPLE_BASE ) >> hist->head.shift ] += (uint32_t)value;
+		}
+	}
+	fclose( f );
+	return ITS_OK;
+}
+
+static int discard_cb( const its_buffer* buf, void* user )
+{
+	(void)buf;
+	(void)user;
+	return 0;
+}
+
+/* Sample for seconds, streaming if asked */
+static int sample( its_dev* dev, uint16_t period_us, uint8_t shift, double seconds, int stream )
+{
+	its_stream_config config;
+	double end;
+	int rc, run;
+
+	rc = its_pc_sample( dev, period_us, shift );
+	if ( rc != ITS_OK )
+		return rc;
+	end = now_sec() + seconds;
+	if ( !stream ) {
+		usleep( (useconds_t)( seconds * 1e6 ) );
+	} else {
+		its_stream_defaults( &config );
+		rc = its_stream_start( dev, &config, discard_cb, NULL );
+		if ( rc == ITS_OK )
+			rc = its_cmd_stream_start( dev );
+		while ( rc == ITS_OK && now_sec() < end ) {
+			run = its_stream_run( dev, 100 );
+			if ( run < 0 )
+				rc = run;
+			else if ( run == 0 )
+				break;
+		}
+		its_stream_stop( dev );
+		its_cmd_stream_stop( dev );
+	}
+	/* Freeze the histogram for the read */
+	its_pc_sample( dev, 0, shift );
+	return rc;
+}
+
+static void usage( const char* name )
+{
+	fprintf( stderr,
+			"usage: %s [-u] [-p period us] [-b bucket log2] [-s seconds] [-S] [-m map file] [-n top]"
+			" [-w dump] [-r dump]\n", name );
+}
+
+int main( int argc, char** argv )
+{
+	static pcs_hist hist;
+	pcs_map map = { NULL, 0, 0 };
+	pcs_symbol* sym;
+	its_dev* dev = NULL;
+	const char* map_path = NULL;
+	const char* dump_out = NULL;
+	const char* dump_in = NULL;
+	double seconds = 5.0;
+	unsigned period_us = 100;
+	unsigned shift = 6;
+	unsigned top = 20;
+	uint64_t in_buckets = 0;
+	size_t i, shown;
+	int use_usb = 0;
+	int stream = 0;
+	int opt, rc;
+
+	while ( ( opt = getopt( argc, argv, "up:b:s:Sm:n:w:r:h" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'u': use_usb = 1; break;
+		case 'p': period_us = (unsigned)atoi( optarg ); break;
+		case 'b': shift = (unsigned)atoi( optarg ); break;
+		case 's': seconds = atof( optarg ); break;
+		case 'S': stream = 1; break;
+		case 'm': map_path = optarg; break;
+		case 'n': top = (unsigned)atoi( optarg ); break;
+		case 'w': dump_out = optarg; break;
+		case 'r': dump_in = optarg; break;
+		default: usage( argv[ 0 ] ); return 2;
+		}
+	}
+	if ( period_us < PC_SAMPLE_MIN_US || period_us > 0xFFFF ||
+			shift < PC_SAMPLE_SHIFT_MIN || shift > PC_SAMPLE_SHIFT_MAX || seconds <= 0 ) {
+		fprintf( stderr, "period %d .. 65535 us, bucket log2 %d .. %d\n",
+				PC_SAMPLE_MIN_US, PC_SAMPLE_SHIFT_MIN, PC_SAMPLE_SHIFT_MAX );
+		return 2;
+	}
+
+	if ( dump_in ) {
+		rc = read_dump( dump_in, &hist );
+		if ( rc != ITS_OK ) {
+			fprintf( stderr, "%s: cannot read\n", dump_in );
+			return 1;
+		}
+	} else {
+		if ( use_usb )
+			rc = its_open_usb( &dev, ITS_USB_VID, ITS_USB_PID );
+		else
+			rc = its_open_loopback( &dev, NULL );
+		if ( rc != ITS_OK ) {
+			fprintf( stderr, "open: %s\n", its_strerror( rc ) );
+			return 1;
+		}
+		rc = sample( dev, (uint16_t)period_us, (uint8_t)shift, seconds, stream );
+		if ( rc == ITS_OK )
+			rc = read_device( dev, &hist );
+		its_close( dev );
+		if ( rc == ITS_ERR_STALL || rc == ITS_ERR_NOT_SUPPORTED ) {
+			printf( "%s: image built without ITS_FX3_PC_SAMPLE\n", use_usb ? "device" : "loopback" );
+			return 0;
+		}
+		if ( rc != ITS_OK ) {
+			fprintf( stderr, "pc sample: %s\n", its_strerror( rc ) );
+			return 1;
+		}
+	}
+	if ( dump_out && write_dump( dump_out, &hist ) != ITS_OK ) {
+		fprintf( stderr, "%s: cannot write\n", dump_out );
+		return 1;
+	}
+
+	for ( i = 0; i < PC_SAMPLE_BUCKETS; i++ )
+		in_buckets += hist.counts[ i ];
+	printf( "%lu samples, %u byte buckets: %.1f%% idle, %.1f%% in other interrupts, %.1f%% itcm,"
+			" %.1f%% above the buckets, %.1f%% unknown frame\n",
+			(unsigned long)hist.head.samples, 1u << hist.head.shift,
+			100.0 * hist.head.idle / ( hist.head.samples ? hist.head.samples : 1 ),
+			100.0 * hist.head.nested / ( hist.head.samples ? hist.head.samples : 1 ),
+			100.0 * hist.head.itcm / ( hist.head.samples ? hist.head.samples : 1 ),
+			100.0 * hist.head.other / ( hist.head.samples ? hist.head.samples : 1 ),
+			100.0 * hist.head.unknown / ( hist.head.samples ? hist.head.samples : 1 ) );
+	if ( in_buckets == 0 )
+		return 0;
+
+	if ( map_path ) {
+		rc = map_load( &map, map_path );
+		if ( rc != ITS_OK ) {
+			fprintf( stderr, "%s: no code symbols\n", map_path );
+			free( map.sym );
+			return 1;
+		}
+		for ( i = 0; i < PC_SAMPLE_BUCKETS; i++ ) {
+			if ( !hist.counts[ i ] )
+				continue;
+			sym = map_find( &map, PC_SAMPLE_BASE + ( (uint32_t)i << hist.head.shift ) );
+			if ( sym )
+				sym->samples += hist.counts[ i ];
+		}
+		qsort( map.sym, map.count, sizeof( pcs_symbol ), cmp_samples );
+		printf( "%8s %7s  %-10s  %s\n", "samples", "%", "address", "function" );
+		for ( i = 0, shown = 0; i < map.count && shown < top && map.sym[ i ].samples; i++, shown++ ) {
+			printf( "%8lu %6.2f%%  0x%08lx  %s\n", (unsigned long)map.sym[ i ].samples,
+					100.0 * map.sym[ i ].samples / in_buckets, (unsigned long)map.sym[ i ].addr,
+					map.sym[ i ].name );
+		}
+		free( map.sym );
+	} else {
+		printf( "%8s %7s  %s\n", "samples", "%", "bucket" );
+		for ( shown = 0; shown < top; shown++ ) {
+			size_t best = 0;
+			for ( i = 1; i < PC_SAMPLE_BUCKETS; i++ ) {
+				if ( hist.counts[ i ] > hist.counts[ best ] )
+					best = i;
+			}
+			if ( !hist.counts[ best ] )
+				break;
+			printf( "%8lu %6.2f%%  0x%08lx\n", (unsigned long)hist.counts[ best ],
+					100.0 * hist.counts[ best ] / in_buckets,
+					(unsigned long)( PC_SAMPLE_BASE + ( best << hist.head.shift ) ) );
+			hist.counts[ best ] = 0;
+		}
+	}
+	return 0;
+}
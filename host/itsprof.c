@@ -0,0 +1,117 @@
+/*
+ * itsprof: region timings of a firmware built with ITS_FX3_PROFILE.
+ *
+ *   itsprof [-u] [-c] [-w seconds]
+ *
+ * Reads every region with CMD_READ_PROFILE and prints count, min, mean
+ * and max in us, less the cost of the hooks themselves, and the log2
+ * histogram of the raw durations. -c clears the regions after the read,
+ * -w clears them, waits and reads, for a timing window of known length.
+ * Without -u the loopback device answers, which has no firmware to time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "itsfx3.h"
+
+static const char* const region_names[ PROF_REGIONS ] = {
+	"setup_cb", "spi", "gpif_cb", "gpio_isr", "cic",
+};
+
+/* The CIC region times one 16 KB DMA buffer of the decimating stream */
+#define CIC_BUFFER_BYTES  ( 16384 )
+
+static double ticks_us( const ProfRegion_t* r, double ticks )
+{
+	ticks -= r->overhead;
+	return ( ticks > 0 ? ticks : 0 ) * 1e6 / r->tick_hz;
+}
+
+static void print_region( const ProfRegion_t* r )
+{
+	const char* name = r->region < PROF_REGIONS ? region_names[ r->region ] : "?";
+	unsigned b;
+
+	if ( r->count == 0 ) {
+		printf( "%-10s %10u\n", name, 0u );
+		return;
+	}
+	printf( "%-10s %10lu %10.2f %10.2f %10.2f  ", name, (unsigned long)r->count,
+			ticks_us( r, r->min ), ticks_us( r, (double)r->sum / r->count ), ticks_us( r, r->max ) );
+	for ( b = 0; b < PROF_BUCKETS; b++ ) {
+		if ( r->hist[ b ] )
+			printf( " 2^%u:%lu", b, (unsigned long)r->hist[ b ] );
+	}
+	printf( "\n" );
+	if ( r->region == PROF_REGION_CIC && ticks_us( r, r->max ) > 0 )
+		printf( "%-10s keeps up with %.1f MB/s on the mean, %.1f MB/s on the slowest buffer\n", "",
+				CIC_BUFFER_BYTES / ticks_us( r, (double)r->sum / r->count ),
+				CIC_BUFFER_BYTES / ticks_us( r, r->max ) );
+}
+
+int main( int argc, char** argv )
+{
+	ProfRegion_t r;
+	its_dev* dev = NULL;
+	double wait_s = 0;
+	int use_usb = 0;
+	int clear = 0;
+	int opt, rc;
+	uint8_t i;
+
+	while ( ( opt = getopt( argc, argv, "ucw:h" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'u': use_usb = 1; break;
+		case 'c': clear = 1; break;
+		case 'w': wait_s = atof( optarg ); break;
+		default:
+			fprintf( stderr, "usage: %s [-u] [-c] [-w seconds]\n", argv[ 0 ] );
+			return 2;
+		}
+	}
+
+	if ( use_usb )
+		rc = its_open_usb( &dev, ITS_USB_VID, ITS_USB_PID );
+	else
+		rc = its_open_loopback( &dev, NULL );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "open: %s\n", its_strerror( rc ) );
+		return 1;
+	}
+
+	rc = its_read_profile( dev, 0, wait_s > 0, &r );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "read profile: %s\n", its_strerror( rc ) );
+		its_close( dev );
+		return 1;
+	}
+	if ( !r.supported || r.tick_hz == 0 ) {
+		printf( "%s: image built without ITS_FX3_PROFILE\n", use_usb ? "device" : "loopback" );
+		its_close( dev );
+		return 0;
+	}
+	if ( wait_s > 0 ) {
+		for ( i = 1; i < r.regions; i++ )
+			its_read_profile( dev, i, 1, &r );
+		usleep( (useconds_t)( wait_s * 1e6 ) );
+	}
+
+	printf( "timer %.1f MHz, hooks %lu ticks, times in us, histogram in raw ticks\n",
+			r.tick_hz * 1e-6, (unsigned long)r.overhead );
+	printf( "%-10s %10s %10s %10s %10s   %s\n", "region", "count", "min", "mean", "max", "histogram" );
+	for ( i = 0; i < r.regions; i++ ) {
+		rc = its_read_profile( dev, i, clear, &r );
+		if ( rc != ITS_OK ) {
+			fprintf( stderr, "read profile %u: %s\n", i, its_strerror( rc ) );
+			break;
+		}
+		print_region( &r );
+	}
+	its_close( dev );
+	return rc == ITS_OK ? 0 : 1;
+}
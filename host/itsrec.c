@@ -0,0 +1,281 @@
+/*
+ * itsrec: record the stream into the indexed format of itsfx3_rec.h and
+ * inspect recordings.
+ *
+ *   itsrec record [-u] [-s seconds] [-r rate Hz] [-c chunk KB] [-w b0:b1]... file
+ *   itsrec info file
+ *   itsrec seek file sample
+ *
+ * record writes the -w registers with its_reg_write before the stream
+ * starts and stores them with the firmware version. While recording the
+ * gap log and the PPS log are polled: new gaps of the stream (overflow
+ * recoveries, GPIF and clock switches) become gaps of lost_ms worth of
+ * samples (needs -r), new PPS edges become events. Gaps that dropped out
+ * of the firmware log between two polls are recorded as one
+ * ITS_REC_EVT_GAPS_MISSED event, sample indices after it are not
+ * reliable. Without -u the loopback device is recorded.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "itsfx3.h"
+#include "itsfx3_rec.h"
+
+#define MAX_REGS  ( 64 )
+
+typedef struct record_state {
+	its_rec_writer* rec;
+	int error;
+} record_state;
+
+static double now_sec( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int record_cb( const its_buffer* buf, void* user )
+{
+	record_state* st = user;
+
+	st->error = its_rec_write( st->rec, buf->data, buf->length );
+	return st->error;
+}
+
+/* Turn new gaps of the stream and PPS edges into gaps and events */
+static void record_poll( its_dev* dev, its_rec_writer* rec, double rate, uint32_t stream,
+		uint32_t* gap_seq, uint32_t* pps_seq )
+{
+	GapLog_t gaps;
+	PpsLog_t pps;
+	uint32_t i;
+
+	if ( its_read_gaps( dev, &gaps ) == ITS_OK && gaps.total > *gap_seq && gaps.count ) {
+		if ( gaps.events[ 0 ].seq > *gap_seq + 1 ) {
+			fprintf( stderr, "%u gaps not recorded, sample indices from offset %llu on are off\n",
+					gaps.events[ 0 ].seq - *gap_seq - 1, (unsigned long long)gaps.events[ 0 ].offset );
+			its_rec_add_event( rec, gaps.events[ 0 ].offset, ITS_REC_EVT_GAPS_MISSED,
+					gaps.events[ 0 ].seq - *gap_seq - 1 );
+		}
+		for ( i = 0; i < gaps.count && i < GAP_LOG_LEN; i++ ) {
+			if ( gaps.events[ i ].seq > *gap_seq && gaps.events[ i ].stream == stream )
+				its_rec_gap( rec, gaps.events[ i ].offset,
+						(uint64_t)( gaps.events[ i ].lost_ms * rate / 1000.0 ) );
+		}
+		*gap_seq = gaps.total;
+	}
+	if ( its_read_pps( dev, &pps ) == ITS_OK ) {
+		for ( i = 0; i < pps.count && i < PPS_LOG_LEN; i++ ) {
+			if ( pps.events[ i ].seq > *pps_seq && ( pps.events[ i ].flags & PPS_FLAG_STREAMING ) ) {
+				its_rec_add_event( rec, pps.events[ i ].offset, ITS_REC_EVT_PPS, pps.events[ i ].seq );
+				*pps_seq = pps.events[ i ].seq;
+			}
+		}
+	}
+}
+
+static int cmd_record( int argc, char** argv )
+{
+	its_rec_reg regs[ MAX_REGS ];
+	its_rec_config config;
+	its_stream_stats stats;
+	its_dev* dev = NULL;
+	record_state st;
+	double seconds = 5.0, t0, next_poll;
+	StreamStatus_t status;
+	GapLog_t gaps;
+	uint32_t stream = 0, gap_seq = 0, pps_seq = 0;
+	unsigned b0, b1;
+	size_t i;
+	int use_usb = 0, opt, rc;
+
+	its_rec_defaults( &config );
+	config.regs = regs;
+	while ( ( opt = getopt( argc, argv, "us:r:c:w:" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'u': use_usb = 1; break;
+		case 's': seconds = atof( optarg ); break;
+		case 'r': config.sample_rate = atof( optarg ); break;
+		case 'c': config.chunk_size = (uint32_t)atoi( optarg ) * 1024; break;
+		case 'w':
+			if ( config.reg_count == MAX_REGS || sscanf( optarg, "%i:%i", &b0, &b1 ) != 2 ) {
+				fprintf( stderr, "bad register write %s\n", optarg );
+				return 1;
+			}
+			regs[ config.reg_count ].b0 = (uint8_t)b0;
+			regs[ config.reg_count ].b1 = (uint8_t)b1;
+			config.reg_count++;
+			break;
+		default:
+			return 2;
+		}
+	}
+	if ( optind != argc - 1 )
+		return 2;
+
+	rc = use_usb ? its_open_usb( &dev, ITS_USB_VID, ITS_USB_PID ) : its_open_loopback( &dev, NULL );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "open: %s\n", its_strerror( rc ) );
+		return 1;
+	}
+	its_get_version( dev, &config.fw_version );
+	for ( i = 0; i < config.reg_count; i++ ) {
+		rc = its_reg_write( dev, regs[ i ].b0, regs[ i ].b1 );
+		if ( rc != ITS_OK )
+			fprintf( stderr, "register write %u:%u: %s\n", regs[ i ].b0, regs[ i ].b1, its_strerror( rc ) );
+	}
+
+	memset( &st, 0, sizeof( st ) );
+	rc = its_rec_create( &st.rec, argv[ optind ], &config );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "%s: %s\n", argv[ optind ], its_strerror( rc ) );
+		its_close( dev );
+		return 1;
+	}
+
+	/* Gaps from before this stream are not ours */
+	if ( its_read_gaps( dev, &gaps ) == ITS_OK )
+		gap_seq = gaps.total;
+	rc = its_stream_start( dev, NULL, record_cb, &st );
+	if ( rc == ITS_OK )
+		rc = its_cmd_stream_start( dev );
+	if ( rc == ITS_OK && its_get_stream_status( dev, &status ) == ITS_OK )
+		stream = status.starts;
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "stream: %s\n", its_strerror( rc ) );
+	} else {
+		t0 = now_sec();
+		next_poll = t0;
+		while ( now_sec() - t0 < seconds && its_stream_run( dev, 100 ) > 0 ) {
+			if ( now_sec() >= next_poll ) {
+				record_poll( dev, st.rec, config.sample_rate, stream, &gap_seq, &pps_seq );
+				next_poll += 0.2;
+			}
+		}
+		its_cmd_stream_stop( dev );
+	}
+	its_stream_get_stats( dev, &stats );
+	its_stream_stop( dev );
+	its_close( dev );
+
+	if ( st.error )
+		fprintf( stderr, "write: %s\n", its_strerror( st.error ) );
+	rc = its_rec_finish( st.rec );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "finish: %s\n", its_strerror( rc ) );
+		return 1;
+	}
+	printf( "%llu bytes recorded\n", (unsigned long long)stats.bytes );
+	return st.error ? 1 : 0;
+}
+
+static const char* event_name( uint32_t type )
+{
+	switch ( type ) {
+	case ITS_REC_EVT_OVERFLOW: return "overflow";
+	case ITS_REC_EVT_PPS:      return "pps";
+	case ITS_REC_EVT_MARK:     return "mark";
+	case ITS_REC_EVT_GAPS_MISSED: return "gaps missed";
+	}
+	return "?";
+}
+
+static int cmd_info( int argc, char** argv )
+{
+	const its_rec_header* h;
+	const its_rec_event* ev;
+	const its_rec_reg* regs;
+	its_rec_reader* rec;
+	uint64_t i, n;
+	int rc;
+
+	if ( argc != 2 )
+		return 2;
+	rc = its_rec_open( &rec, argv[ 1 ] );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "%s: %s\n", argv[ 1 ], its_strerror( rc ) );
+		return 1;
+	}
+	h = its_rec_info( rec );
+	printf( "finished        %s\n", ( h->flags & ITS_REC_FINISHED ) ? "yes" : "no" );
+	printf( "firmware        0x%08x\n", h->fw_version );
+	printf( "format          %u channels x %u bit, %u byte per sample\n", h->channels, h->sample_bits, h->sample_bytes );
+	printf( "sample rate     %.0f Hz\n", h->sample_rate );
+	printf( "chunk size      %u\n", h->chunk_size );
+	printf( "data            %llu bytes at %llu\n", (unsigned long long)h->data_bytes, (unsigned long long)h->data_offset );
+	printf( "lost samples    %llu\n", (unsigned long long)h->lost_samples );
+	printf( "index entries   %llu\n", (unsigned long long)h->index_count );
+
+	regs = its_rec_regs( rec, &n );
+	for ( i = 0; i < n; i++ )
+		printf( "register        0x%02x 0x%02x\n", regs[ i ].b0, regs[ i ].b1 );
+	ev = its_rec_events( rec, &n );
+	printf( "events          %llu\n", (unsigned long long)n );
+	for ( i = 0; i < n; i++ )
+		printf( "  %-9s offset %llu sample %llu value %llu\n", event_name( ev[ i ].type ),
+				(unsigned long long)ev[ i ].data_offset, (unsigned long long)ev[ i ].sample_index,
+				(unsigned long long)ev[ i ].value );
+
+	its_rec_close( rec );
+	return 0;
+}
+
+static int cmd_seek( int argc, char** argv )
+{
+	its_rec_reader* rec;
+	const uint8_t* data;
+	uint64_t bytes, sample, offset, i;
+	int rc;
+
+	if ( argc != 3 )
+		return 2;
+	rc = its_rec_open( &rec, argv[ 1 ] );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "%s: %s\n", argv[ 1 ], its_strerror( rc ) );
+		return 1;
+	}
+	sample = strtoull( argv[ 2 ], NULL, 0 );
+	rc = its_rec_find_sample( rec, sample, &offset );
+	if ( rc < 0 ) {
+		fprintf( stderr, "sample %llu is not in the recording\n", (unsigned long long)sample );
+		its_rec_close( rec );
+		return 1;
+	}
+	if ( rc == 1 )
+		printf( "sample %llu was lost, next sample %llu\n", (unsigned long long)sample,
+				(unsigned long long)its_rec_sample_at( rec, offset ) );
+	printf( "data offset %llu:", (unsigned long long)offset );
+	data = its_rec_data( rec, &bytes );
+	for ( i = offset; i < bytes && i < offset + 16; i++ )
+		printf( " %02x", data[ i ] );
+	printf( "\n" );
+
+	its_rec_close( rec );
+	return 0;
+}
+
+int main( int argc, char** argv )
+{
+	int rc = 2;
+
+	if ( argc >= 2 ) {
+		if ( strcmp( argv[ 1 ], "record" ) == 0 )
+			rc = cmd_record( argc - 1, argv + 1 );
+		else if ( strcmp( argv[ 1 ], "info" ) == 0 )
+			rc = cmd_info( argc - 1, argv + 1 );
+		else if ( strcmp( argv[ 1 ], "seek" ) == 0 )
+			rc = cmd_seek( argc - 1, argv + 1 );
+	}
+	if ( rc == 2 )
+		fprintf( stderr,
+				"usage: itsrec record [-u] [-s seconds] [-r rate Hz] [-c chunk KB] [-w b0:b1]... file\n"
+				"       itsrec info file\n"
+				"       itsrec seek file sample\n" );
+	return rc;
+}
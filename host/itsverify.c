@@ -0,0 +1,246 @@
+/*
+ * itsverify: end-to-end check of the footer stream of CMD_FOOTER_STREAM.
+ *
+ *   itsverify [-u] [-s seconds] [-b buffer KB] [-t transfers] [-S transfer KB]
+ *
+ * First a self test: synthetic footer buffers with a flipped bit, two
+ * swapped words and a dropped buffer must each be caught, and the
+ * verifier's own rate is measured on buffers in memory. Then the stream
+ * is started in footer mode and every byte is checked as it arrives.
+ * Without -u the loopback device is used, whose rate is its link model
+ * and says nothing of the firmware. Exits non-zero on any error.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "itsfx3.h"
+#include "itsfx3_footer.h"
+
+#define SELFTEST_BUFFERS  ( 1024 )
+
+typedef struct verify_state {
+	its_footer_check chk;
+	double deadline;
+	int error;
+} verify_state;
+
+static double now_sec( void )
+{
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Random payload and the footer the firmware would write */
+static void make_buffer( uint8_t* buf, size_t buf_size, uint32_t sequence, uint64_t* rng )
+{
+	size_t payload = buf_size - STREAM_FOOTER_SIZE;
+	StreamFooter_t footer;
+	FooterSum_t sum = { 0, 0 };
+	size_t i;
+
+	for ( i = 0; i < payload; i += 8 ) {
+		*rng ^= *rng << 13;
+		*rng ^= *rng >> 7;
+		*rng ^= *rng << 17;
+		memcpy( buf + i, rng, payload - i < 8 ? payload - i : 8 );
+	}
+	CyFxFooterSum( &sum, buf, (uint32_t)payload );
+	footer.sequence = sequence;
+	footer.bytes = (uint16_t)payload;
+	footer.magic = STREAM_FOOTER_MAGIC;
+	footer.sum_a = sum.a;
+	footer.sum_b = sum.b;
+	memcpy( buf + payload, &footer, sizeof( footer ) );
+}
+
+/* Feed in odd sized pieces, so footers straddle them */
+static uint64_t check_region( size_t buf_size, const uint8_t* data, size_t len, size_t piece )
+{
+	its_footer_check chk;
+	size_t n;
+
+	its_footer_init( &chk, buf_size );
+	while ( len > 0 ) {
+		n = piece < len ? piece : len;
+		its_footer_feed( &chk, data, n );
+		data += n;
+		len -= n;
+	}
+	return its_footer_errors( &chk );
+}
+
+static int self_test( size_t buf_size )
+{
+	size_t len = SELFTEST_BUFFERS * buf_size;
+	uint8_t* region;
+	its_footer_check chk;
+	uint64_t rng = 0x9E3779B97F4A7C15ull;
+	uint32_t w[ 2 ];
+	uint64_t bytes = 0;
+	double t0, t;
+	size_t i;
+	int ok = 1;
+
+	if ( posix_memalign( (void**)&region, 4096, len ) != 0 )
+		return 0;
+	for ( i = 0; i < SELFTEST_BUFFERS; i++ )
+		make_buffer( region + i * buf_size, buf_size, (uint32_t)i, &rng );
+
+	if ( check_region( buf_size, region, len, 1020 ) != 0 ) {
+		printf( "self test: clean stream reported errors\n" );
+		ok = 0;
+	}
+
+	/* One bit in the middle of buffer 3 */
+	region[ 3 * buf_size + 1001 ] ^= 0x10;
+	if ( check_region( buf_size, region, len, 65536 ) != 1 ) {
+		printf( "self test: flipped bit not caught\n" );
+		ok = 0;
+	}
+	region[ 3 * buf_size + 1001 ] ^= 0x10;
+
+	/* Two words of buffer 5 swapped, sum a is unchanged */
+	memcpy( w, region + 5 * buf_size + 64, 8 );
+	if ( w[ 0 ] == w[ 1 ] )
+		w[ 1 ]++;
+	memcpy( region + 5 * buf_size + 64, &w[ 1 ], 4 );
+	memcpy( region + 5 * buf_size + 68, &w[ 0 ], 4 );
+	if ( check_region( buf_size, region, len, 65536 ) != 1 ) {
+		printf( "self test: swapped words not caught\n" );
+		ok = 0;
+	}
+	make_buffer( region + 5 * buf_size, buf_size, 5, &rng );
+
+	/* Buffer 7 lost on the way */
+	its_footer_init( &chk, buf_size );
+	its_footer_feed( &chk, region, 7 * buf_size );
+	its_footer_feed( &chk, region + 8 * buf_size, len - 8 * buf_size );
+	if ( chk.seq_gaps != 1 || its_footer_errors( &chk ) != 1 ) {
+		printf( "self test: dropped buffer not caught\n" );
+		ok = 0;
+	}
+
+	t0 = now_sec();
+	do {
+		its_footer_init( &chk, buf_size );
+		its_footer_feed( &chk, region, len );
+		if ( its_footer_errors( &chk ) != 0 )
+			ok = 0;
+		bytes += len;
+		t = now_sec();
+	} while ( t - t0 < 0.5 );
+
+	printf( "self test %s, verifier %.0f MB/s on %zu byte buffers\n",
+			ok ? "ok" : "FAILED", bytes / ( t - t0 ) / 1e6, buf_size );
+	free( region );
+	return ok;
+}
+
+static int verify_cb( const its_buffer* buf, void* user )
+{
+	verify_state* st = user;
+
+	st->error = its_footer_feed( &st->chk, buf->data, buf->length );
+	if ( st->error != ITS_OK )
+		return st->error;
+	return now_sec() >= st->deadline;
+}
+
+static void usage( const char* name )
+{
+	fprintf( stderr,
+			"usage: %s [-u] [-s seconds] [-b buffer KB] [-t transfers] [-S transfer KB]\n"
+			"  -b is the firmware DMA buffer, 16 at SuperSpeed, 8 at high speed\n", name );
+}
+
+int main( int argc, char** argv )
+{
+	its_stream_config config;
+	its_stream_stats stats;
+	FooterStatus_t fw;
+	verify_state st;
+	its_dev* dev = NULL;
+	double seconds = 2.0;
+	double t0, t1;
+	size_t buf_size = 16384;
+	int use_usb = 0;
+	int opt, rc, ok;
+
+	its_stream_defaults( &config );
+	while ( ( opt = getopt( argc, argv, "us:b:t:S:h" ) ) != -1 ) {
+		switch ( opt ) {
+		case 'u': use_usb = 1; break;
+		case 's': seconds = atof( optarg ); break;
+		case 'b': buf_size = (size_t)atoi( optarg ) * 1024; break;
+		case 't': config.transfers = (unsigned)atoi( optarg ); break;
+		case 'S': config.transfer_size = (size_t)atoi( optarg ) * 1024; break;
+		default: usage( argv[ 0 ] ); return 2;
+		}
+	}
+
+	memset( &st, 0, sizeof( st ) );
+	if ( its_footer_init( &st.chk, buf_size ) != ITS_OK ) {
+		fprintf( stderr, "bad buffer size %zu\n", buf_size );
+		return 2;
+	}
+	ok = self_test( buf_size );
+
+	if ( use_usb )
+		rc = its_open_usb( &dev, ITS_USB_VID, ITS_USB_PID );
+	else
+		rc = its_open_loopback( &dev, NULL );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "open: %s\n", its_strerror( rc ) );
+		return 1;
+	}
+
+	t0 = now_sec();
+	st.deadline = t0 + seconds;
+	rc = its_stream_start( dev, &config, verify_cb, &st );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "stream start: %s\n", its_strerror( rc ) );
+		its_close( dev );
+		return 1;
+	}
+	rc = its_footer_stream( dev );
+	if ( rc != ITS_OK ) {
+		fprintf( stderr, "footer stream: %s\n", its_strerror( rc ) );
+		its_stream_stop( dev );
+		its_close( dev );
+		return 1;
+	}
+	while ( ( rc = its_stream_run( dev, 100 ) ) > 0 )
+		;
+	t1 = now_sec();
+	its_stream_get_stats( dev, &stats );
+	its_stream_stop( dev );
+	its_cmd_stream_stop( dev );
+	if ( rc < 0 )
+		fprintf( stderr, "stream: %s\n", its_strerror( rc ) );
+	if ( st.error != ITS_OK ) {
+		fprintf( stderr, "transfer not a multiple of 4 bytes, buffers lost track\n" );
+		ok = 0;
+	}
+
+	printf( "%s, %.1f s: %.1f MB/s, %llu buffers, %llu payload bytes\n",
+			use_usb ? "device" : "loopback", t1 - t0, stats.bytes / ( t1 - t0 ) / 1e6,
+			(unsigned long long)st.chk.buffers, (unsigned long long)st.chk.payload_bytes );
+	printf( "bad sums %llu, bad footers %llu, sequence gaps %llu, short transfers %llu\n",
+			(unsigned long long)st.chk.bad_sums, (unsigned long long)st.chk.bad_footers,
+			(unsigned long long)st.chk.seq_gaps, (unsigned long long)stats.short_buffers );
+	if ( its_read_footer( dev, &fw ) == ITS_OK )
+		printf( "firmware: %lu buffers footered, %lu commit errors\n",
+				(unsigned long)fw.buffers, (unsigned long)fw.errors );
+
+	if ( its_footer_errors( &st.chk ) != 0 || st.chk.buffers == 0 )
+		ok = 0;
+	printf( "verify %s\n", ok ? "ok" : "FAILED" );
+	its_close( dev );
+	return ok ? 0 : 1;
+}
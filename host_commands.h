@@ -6,6 +6,40 @@
 #define CMD_REG_WRITE       ( 0xB3 )
 #define CMD_READ_DEBUG_INFO ( 0xB4 )
 #define CMD_REG_READ        ( 0xB5 )
+#define CMD_READ_USB_ERRORS ( 0xB6 )
+#define CMD_SET_LPM_POLICY  ( 0xB7 )
+#define CMD_READ_LPM_STATS  ( 0xB8 )
+#define CMD_GET_STREAM_STATUS ( 0xB9 )
+#define CMD_STREAM_START    ( 0xBA )
+#define CMD_STREAM_STOP     ( 0xBB )
+#define CMD_STREAM_ARM      ( 0xBC )
+#define CMD_READ_TRIGGER    ( 0xBD )
+#define CMD_READ_PPS        ( 0xBE )
+#define CMD_SNAPSHOT        ( 0xC0 )
+#define CMD_READ_SNAPSHOT   ( 0xC1 )
+#define CMD_PRETRIG_ARM     ( 0xC2 )
+#define CMD_PRETRIG_FIRE    ( 0xC3 )
+#define CMD_READ_PRETRIG    ( 0xC4 )
+#define CMD_DECIMATE        ( 0xC5 )
+#define CMD_READ_DECIM      ( 0xC6 )
+#define CMD_SAMPLE_STATS    ( 0xC7 )
+#define CMD_READ_STATS      ( 0xC8 )
+#define CMD_JAM_CONFIG      ( 0xC9 )
+#define CMD_READ_JAM        ( 0xCA )
+/* 0xCB and 0xCC are not used */
+#define CMD_PIB_CLOCK       ( 0xCD )
+#define CMD_READ_PIB_CLOCK  ( 0xCE )
+#define CMD_FOOTER_STREAM   ( 0xCF )
+#define CMD_READ_FOOTER     ( 0xD0 )
+#define CMD_FLUSH_DEADLINE  ( 0xD1 )
+#define CMD_READ_FLUSH      ( 0xD2 )
+#define CMD_LATENCY_MARK    ( 0xD3 )
+#define CMD_READ_PROFILE    ( 0xD4 )
+#define CMD_PC_SAMPLE       ( 0xD5 )
+#define CMD_READ_PC_SAMPLE  ( 0xD6 )
+#define CMD_CPU_LOAD        ( 0xD7 )
+#define CMD_READ_CPU_LOAD   ( 0xD8 )
+#define CMD_READ_GAPS       ( 0xD9 )
 #define CMD_CYPRESS_RESET   ( 0xBF )
 
 typedef struct FirmwareDescription_t {
@@ -13,5 +47,450 @@ typedef struct FirmwareDescription_t {
 	uint8_t  reserved[ 28 ];
 } FirmwareDescription_t;
 
+#define USB_ERR_HISTORY_LEN ( 16 )
+
+/* Reply to CMD_READ_USB_ERRORS. Totals are accumulated by a periodic
+ * sampler in firmware, history holds per-second deltas, oldest first. */
+typedef struct UsbErrorStats_t {
+	uint64_t phy_total;
+	uint64_t lnk_total;
+	uint32_t seconds;        /* Seconds of SuperSpeed link time sampled */
+	uint32_t history_len;    /* Valid entries in phy/lnk_per_sec */
+	uint32_t phy_per_sec[ USB_ERR_HISTORY_LEN ];
+	uint32_t lnk_per_sec[ USB_ERR_HISTORY_LEN ];
+} UsbErrorStats_t;
+
+/* wValue of CMD_SET_LPM_POLICY */
+#define LPM_POLICY_ALLOW     ( 0 )  /* Always accept U1/U2 entry */
+#define LPM_POLICY_STREAMING ( 1 )  /* Reject U1/U2 while GPIF is streaming (default) */
+#define LPM_POLICY_REJECT    ( 2 )  /* Always reject U1/U2 entry */
+
+/* Reply to CMD_READ_LPM_STATS */
+typedef struct LpmStats_t {
+	uint8_t  policy;
+	uint8_t  streaming;
+	uint8_t  lpm_disabled;   /* CyU3PUsbLPMDisable is in effect */
+	uint8_t  link_state;     /* CyU3PUsbLinkPowerMode at the time of request */
+	uint32_t u1_requests;
+	uint32_t u2_requests;
+	uint32_t accepted;
+	uint32_t rejected;
+	uint32_t suspends;       /* U3 entries */
+	uint32_t resumes;
+	uint32_t recoveries;     /* Link recovery events */
+	uint32_t disable_count;  /* Times LPM was disabled for streaming */
+} LpmStats_t;
+
+/* Reply to CMD_GET_STREAM_STATUS */
+typedef struct StreamStatus_t {
+	uint32_t streaming;
+	uint32_t overflows;         /* GPIF overflow interrupts */
+	uint32_t recoveries;        /* Overflows recovered in place, without device reset */
+	uint32_t last_recovery_ms;  /* Overflow interrupt to state machine restart */
+	uint32_t max_recovery_ms;
+	uint32_t starts;            /* Streams started by CMD_STREAM_START or trigger */
+	uint64_t last_gap_offset;   /* Byte offset in the stream where data was lost last time */
+} StreamStatus_t;
+
+#define GAP_LOG_LEN        ( 16 )
+
+/* One discontinuity of the stream: an overflow recovery or a resume after
+ * a GPIF or clock switch. Data from lost_ms before offset is missing. */
+typedef struct GapEvent_t {
+	uint64_t offset;      /* Stream byte offset of the first byte after the gap */
+	uint32_t seq;         /* Gap number since power up, starts from 1 */
+	uint32_t lost_ms;     /* Overflow or pause to GPIF restart */
+	uint32_t stream;      /* StreamStatus_t.starts of the stream offset belongs to */
+	uint32_t reserved;
+} GapEvent_t;
+
+/* Reply to CMD_READ_GAPS, the last count gaps, oldest first. */
+typedef struct GapLog_t {
+	uint32_t total;       /* Gaps since power up */
+	uint32_t count;
+	GapEvent_t events[ GAP_LOG_LEN ];
+} GapLog_t;
+
+/* wValue of CMD_STREAM_ARM. TRIGGER_EDGE_NONE disarms and stops the stream. */
+#define TRIGGER_EDGE_NONE    ( 0 )
+#define TRIGGER_EDGE_RISING  ( 1 )
+#define TRIGGER_EDGE_FALLING ( 2 )
+
+/* Reply to CMD_READ_TRIGGER.
+ *
+ * GPIF starts from the GPIO interrupt, after its latency, a few us on an
+ * idle CPU and up to the longest interrupt handler or interrupts-off
+ * section on a busy one. delay_ticks is that latency, measured from the
+ * edge latched in hardware to the GPIF start, in ticks of tick_hz. The
+ * first sample of a started stream, sample_index 0, was taken delay_ticks
+ * after the edge, so boards sharing the trigger align on
+ * delay_ticks * sample rate / tick_hz samples. For TRIGGER_ACTION_FIRE
+ * sample_index is the upload offset of the pre-trigger buffer holding the
+ * edge and delay_ticks the time from the edge to the fire. */
+#define TRIGGER_DELAY_UNKNOWN ( 0xFFFFFFFF )  /* Edge time not latched */
+
+typedef struct TriggerStatus_t {
+	uint8_t  armed;         /* Waiting for the edge */
+	uint8_t  edge;          /* TRIGGER_EDGE_* armed, NONE after firing */
+	uint8_t  fired;         /* Last arm ended with a triggered start */
+	uint8_t  reserved;
+	uint32_t fire_time_ms;  /* CyU3PGetTime() at the trigger interrupt */
+	uint32_t fired_count;
+	uint32_t start_errors;  /* Triggers on which GPIF failed to start */
+	uint64_t sample_index;  /* Byte offset of the first sample GPIF took after the edge */
+	uint32_t delay_ticks;   /* Edge to GPIF start or fire, TRIGGER_DELAY_UNKNOWN */
+	uint32_t tick_hz;       /* Edge timer ticks per second */
+} TriggerStatus_t;
+
+#define PPS_LOG_LEN        ( 16 )
+#define PPS_FLAG_STREAMING ( 1 << 0 )  /* GPIF was running at the edge */
+
+/* One 1PPS edge. offset is the stream byte offset of the DMA buffer GPIF
+ * was filling, the edge lies within that buffer: 16 KB, or
+ * FlushStatus_t.buffer_bytes under a flush deadline. */
+typedef struct PpsEvent_t {
+	uint64_t offset;
+	uint32_t seq;         /* Edge number since power up, starts from 1 */
+	uint32_t time_ms;     /* CyU3PGetTime() at the edge */
+	uint32_t stream;      /* StreamStatus_t.starts of the stream offset belongs to */
+	uint32_t flags;       /* PPS_FLAG_* */
+} PpsEvent_t;
+
+/* Reply to CMD_READ_PPS, the last count edges, oldest first. */
+typedef struct PpsLog_t {
+	uint32_t total;       /* Edges seen since power up */
+	uint32_t count;
+	PpsEvent_t events[ PPS_LOG_LEN ];
+} PpsLog_t;
+
+/* CMD_SNAPSHOT captures ( wIndex << 16 ) | wValue bytes, then stops GPIF.
+ * The host reads exactly that many bytes from EP 0x81. */
+#define SNAPSHOT_IDLE     ( 0 )
+#define SNAPSHOT_RUNNING  ( 1 )
+#define SNAPSHOT_DONE     ( 2 )  /* All bytes were taken by the host */
+#define SNAPSHOT_FAILED   ( 3 )  /* GPIF overflowed before the data was captured */
+#define SNAPSHOT_ABORTED  ( 4 )  /* Replaced by a stream start/stop or USB reset */
+
+/* Reply to CMD_READ_SNAPSHOT */
+typedef struct SnapshotStatus_t {
+	uint32_t state;        /* SNAPSHOT_* */
+	uint32_t duration_ms;  /* Start to completion, when DONE */
+	uint64_t length;
+	uint64_t sent;         /* Bytes taken by the host so far */
+} SnapshotStatus_t;
+
+/* CMD_PRETRIG_ARM keeps the newest samples in a ring of DMA buffers in
+ * device RAM. wValue is the post-trigger tail in buffers, wIndex is
+ * TRIGGER_EDGE_* for TRIGGER_IN, NONE for CMD_PRETRIG_FIRE only. Once
+ * frozen, ( pre_bufs + tail_bufs ) * buf_size bytes come from EP 0x81, the
+ * trigger lies in the buffer at offset pre_bufs * buf_size. */
+#define PRETRIG_IDLE       ( 0 )
+#define PRETRIG_FILLING    ( 1 )  /* Waiting for the trigger */
+#define PRETRIG_TRIGGERED  ( 2 )  /* Collecting the tail */
+#define PRETRIG_FROZEN     ( 3 )
+#define PRETRIG_UPLOADING  ( 4 )
+#define PRETRIG_DONE       ( 5 )
+#define PRETRIG_FAILED     ( 6 )  /* GPIF overflowed during the tail */
+#define PRETRIG_ABORTED    ( 7 )
+
+/* Reply to CMD_READ_PRETRIG */
+typedef struct PretrigStatus_t {
+	uint8_t  state;         /* PRETRIG_* */
+	uint8_t  reserved;
+	uint16_t buf_size;      /* Bytes per DMA buffer */
+	uint16_t buf_count;     /* Buffers in the ring */
+	uint16_t pre_bufs;      /* Buffers before the one holding the trigger */
+	uint16_t tail_bufs;     /* Buffers from the one holding the trigger on */
+	uint16_t sent_bufs;     /* Buffers taken by the host */
+	uint32_t discarded;     /* Old buffers dropped while waiting */
+	uint32_t fire_time_ms;
+	uint32_t upload_bytes;  /* Valid from PRETRIG_FROZEN on */
+} PretrigStatus_t;
+
+/* CMD_DECIMATE starts a stream through the on-device CIC-2 decimator,
+ * wValue is log2 of the decimation, 4 .. 7. See cic_decim.h for the output
+ * format. PPS offsets keep counting raw input bytes. */
+typedef struct DecimStatus_t {
+	uint8_t  log2r;
+	uint8_t  active;
+	uint8_t  reserved[ 2 ];
+	uint32_t buffers;       /* DMA buffers processed */
+	uint32_t errors;        /* Failed commits */
+	uint32_t reserved2;
+	uint64_t bytes_in;
+	uint64_t bytes_out;
+} DecimStatus_t;
+
+/* CMD_SAMPLE_STATS clears the statistics and samples the next wValue DMA
+ * buffers of the running stream, the first CY_FX_STATS_SAMPLE_BYTES of
+ * each. wValue 0 stops. Only plain streaming is sampled. */
+#define STATS_IDLE     ( 0 )
+#define STATS_RUNNING  ( 1 )
+#define STATS_DONE     ( 2 )
+
+/* Reply to CMD_READ_STATS. Channel c is bits [2c+1:2c] of a sample byte,
+ * hist[ c ][ code ] counts codes, see its_sample_format.h. The mean of a
+ * channel is sum[ c ] / samples. */
+typedef struct SampleStats_t {
+	uint16_t state;         /* STATS_* */
+	uint16_t requested;     /* Buffers to sample */
+	uint32_t buffers;       /* Buffers sampled */
+	uint32_t samples;       /* Sample bytes, per channel */
+	uint32_t idle;          /* Polls without a new buffer */
+	uint32_t dropped;       /* Samples dropped, buffer reused while read */
+	uint32_t hist[ 4 ][ 4 ];
+	int32_t  sum[ 4 ];      /* Sum of sample values, +-1 / +-3 */
+	uint32_t crossings[ 4 ];/* Sign changes between neighbouring samples */
+} SampleStats_t;
+
+/* Narrowband interference detector. CMD_JAM_CONFIG carries a JamConfig_t
+ * in its data stage and clears the status, bins 0 disables the detector.
+ * An invalid configuration disables it too and stalls. CMD_READ_JAM returns a
+ * JamStatus_t, wValue 1 clears the latched alarms and peaks after the read.
+ *
+ * Each new buffer of the running stream is CIC decimated by 2^log2r and a
+ * Goertzel filter per bin runs over block samples of every channel. A bin
+ * at frequency f, with fs the decimated sample rate (input byte rate
+ * >> log2r), has coeff_q14 = round( 2 cos( 2 pi f / fs ) * 16384 ).
+ * Levels are |X[k]|^2 / sum(x^2) in Q8, about 256 for white noise. */
+#define JAM_MAX_BINS   ( 8 )
+#define JAM_MIN_BLOCK  ( 16 )
+#define JAM_MAX_BLOCK  ( 512 )
+
+typedef struct JamConfig_t {
+	uint8_t  bins;          /* Bins in use, 0 .. JAM_MAX_BINS */
+	uint8_t  log2r;         /* CIC decimation, 4 .. 7 */
+	uint16_t block;         /* Samples per filter run, (block + 2) << log2r must fit a buffer */
+	uint32_t threshold_q8;  /* Alarm level */
+	int16_t  coeff_q14[ JAM_MAX_BINS ];
+} JamConfig_t;
+
+typedef struct JamStatus_t {
+	uint8_t  bins;
+	uint8_t  log2r;
+	uint16_t block;
+	uint32_t blocks;        /* Buffers analysed */
+	uint32_t dropped;       /* Buffers too short or reused while read */
+	uint32_t alarms;        /* Buffers with a level over the threshold */
+	uint32_t alarm_mask;    /* Latched, bit ch * JAM_MAX_BINS + bin */
+	uint32_t last_alarm_ms;
+	uint32_t level_q8[ 4 ][ JAM_MAX_BINS ];  /* Last buffer */
+	uint32_t peak_q8[ 4 ][ JAM_MAX_BINS ];   /* Latched maximum */
+} JamStatus_t;
+
+/* CMD_PIB_CLOCK carries a PibClockConfig_t in its data stage and
+ * re-initializes the P-port with it. A running stream or decimated stream
+ * goes on after a gap reported like an overflow recovery, a snapshot or
+ * pre-trigger capture is cancelled. The PIB clock is the source clock
+ * divided by div, or by div + 0.5 with half_div. It must not be slower
+ * than the GPIF interface clock sample_khz (0 skips the check). A rejected or failed
+ * setting stalls, the reason is in PibClockStatus_t.result. */
+#define PIB_CLK_SRC_SYS_BY_16   ( 0 )
+#define PIB_CLK_SRC_SYS_BY_4    ( 1 )
+#define PIB_CLK_SRC_SYS_BY_2    ( 2 )
+#define PIB_CLK_SRC_SYS         ( 3 )
+
+#define PIB_CLK_DIV_MIN         ( 2 )
+#define PIB_CLK_DIV_MAX         ( 1024 )
+
+#define PIB_CLK_OK              ( 0 )
+#define PIB_CLK_BAD_ARGUMENT    ( 1 )   /* Source, divider or flags out of range */
+#define PIB_CLK_TOO_SLOW        ( 2 )   /* Below sample_khz */
+#define PIB_CLK_INIT_FAILED     ( 3 )   /* P-port init or GPIF load failed, previous clock restored */
+
+typedef struct PibClockConfig_t {
+	uint16_t div;           /* PIB_CLK_DIV_MIN .. PIB_CLK_DIV_MAX */
+	uint8_t  half_div;
+	uint8_t  dll;           /* Enable the PIB DLL, only useful with an internal interface clock */
+	uint8_t  source;        /* PIB_CLK_SRC_* */
+	uint8_t  reserved[ 3 ];
+	uint32_t sample_khz;    /* GPIF interface clock */
+} PibClockConfig_t;
+
+/* Reply to CMD_READ_PIB_CLOCK */
+typedef struct PibClockStatus_t {
+	PibClockConfig_t config;/* In use */
+	uint32_t pib_hz;        /* Resulting PIB clock */
+	uint32_t sys_hz;        /* System clock it is derived from */
+	uint32_t changes;       /* Successful CMD_PIB_CLOCK */
+	uint32_t result;        /* PIB_CLK_* of the last CMD_PIB_CLOCK */
+	uint32_t last_switch_ms;/* Stop to restart of the last change */
+} PibClockStatus_t;
+
+
+/* CMD_FOOTER_STREAM starts a stream in which every DMA buffer ends in a
+ * StreamFooter_t. The raw stream bytes in front of it are the payload,
+ * sum_a and sum_b are the footer_sum.h sums over them. The sequence
+ * counts buffers from 0 with every start.
+ * The sums are taken by the CPU from FX3 RAM, not by the GPIF CRC, so
+ * this checks the path from RAM to the host, not the front-end bus. The
+ * stream rate the CPU sustains in this mode is unmeasured on a device. */
+#define STREAM_FOOTER_MAGIC ( 0xF00E )
+#define STREAM_FOOTER_SIZE  ( 16 )
+
+typedef struct StreamFooter_t {
+	uint32_t sequence;
+	uint16_t bytes;         /* Payload in front of the footer */
+	uint16_t magic;         /* STREAM_FOOTER_MAGIC */
+	uint32_t sum_a;
+	uint32_t sum_b;
+} StreamFooter_t;
+
+/* Reply to CMD_READ_FOOTER */
+typedef struct FooterStatus_t {
+	uint8_t  active;
+	uint8_t  reserved[ 3 ];
+	uint32_t buffers;       /* Buffers given a footer */
+	uint32_t errors;        /* Failed commits */
+	uint32_t reserved2;
+	uint64_t bytes;         /* Payload bytes */
+} FooterStatus_t;
+
+/* CMD_FLUSH_DEADLINE bounds the time stream data waits in a DMA buffer,
+ * wValue is the deadline in ms, 0 turns it off, wIndex the front-end data
+ * rate in kB/s (1000 bytes). The plain stream gets DMA buffers that fill
+ * within the deadline at that rate, each ending in a short packet, down
+ * to 16 bytes. No sample is lost: GPIF commits the smaller buffers itself.
+ * A running stream goes on after one gap as with CMD_PIB_CLOCK. Streams
+ * that fill a full buffer within the deadline keep full buffers. Stalls if
+ * the deadline is out of range or the rate is 0. */
+#define FLUSH_DEADLINE_MIN_MS ( 2 )
+#define FLUSH_DEADLINE_MAX_MS ( 1000 )
+
+/* Reply to CMD_READ_FLUSH */
+typedef struct FlushStatus_t {
+	uint8_t  supported;     /* Always 1, images before CMD_FLUSH_DEADLINE stall */
+	uint8_t  active;        /* Plain stream running under a deadline */
+	uint16_t deadline_ms;   /* 0 is off */
+	uint16_t rate_kbps;     /* Rate given with the deadline */
+	uint16_t reserved;
+	uint32_t buffer_bytes;  /* DMA buffer of the plain stream channel, 0 in other modes */
+	uint32_t reserved2;
+} FlushStatus_t;
+
+/* CMD_LATENCY_MARK (IN) drives the LATENCY_MARK output to wValue (0 or 1)
+ * and replies with the state right after. On the board the output is
+ * looped to GPIF data line `line` in place of a front-end line, so the
+ * edge enters the sample stream at the P-port pins and the host can time
+ * its way to the application. Stalls unless the image is built with
+ * ITS_FX3_LATENCY_MARK_LINE. */
+typedef struct LatencyMark_t {
+	uint8_t  line;          /* GPIF data line the output is looped to */
+	uint8_t  width;         /* GPIF bus width in bits */
+	uint8_t  level;         /* Output level now */
+	uint8_t  flags;         /* PPS_FLAG_STREAMING: offset and stream are valid */
+	uint32_t seq;           /* Marks since power up, starts from 1 */
+	uint32_t time_ms;       /* CyU3PGetTime() at the mark */
+	uint32_t stream;        /* StreamStatus_t.starts of the stream offset belongs to */
+	uint64_t offset;        /* Stream offset GPIF was writing at, exact to one DMA buffer */
+} LatencyMark_t;
+
+/* Code regions timed by the profiling hooks of images built with
+ * ITS_FX3_PROFILE. CMD_READ_PROFILE returns the ProfRegion_t of region
+ * wValue & 0xFF, PROF_READ_CLEAR in wValue clears it after the read. */
+#define PROF_REGION_SETUP_CB  ( 0 )   /* USB setup callback, vendor commands */
+#define PROF_REGION_SPI       ( 1 )   /* CMD_REG_READ SPI transfer */
+#define PROF_REGION_GPIF_CB   ( 2 )   /* GPIF event callback */
+#define PROF_REGION_GPIO_ISR  ( 3 )   /* PPS_IN and TRIGGER_IN interrupts */
+#define PROF_REGION_CIC       ( 4 )   /* CIC decimator, one DMA buffer */
+#define PROF_REGIONS          ( 5 )
+#define PROF_BUCKETS          ( 24 )
+#define PROF_READ_CLEAR       ( 0x100 )
+
+typedef struct ProfRegion_t {
+	uint8_t  supported;     /* Image built with ITS_FX3_PROFILE */
+	uint8_t  region;
+	uint8_t  regions;       /* PROF_REGIONS of the image */
+	uint8_t  reserved;
+	uint32_t tick_hz;       /* Timer ticks per second */
+	uint32_t overhead;      /* Ticks of an empty region, part of every duration */
+	uint32_t count;         /* Durations since the last clear */
+	uint32_t min;           /* Ticks */
+	uint32_t max;
+	uint64_t sum;
+	uint32_t hist[ PROF_BUCKETS ];  /* hist[ b ]: 2^b .. 2^(b+1)-1 ticks, 0 in hist[ 0 ], the last open ended */
+} ProfRegion_t;
+
+/* Statistical PC profiler of images built with ITS_FX3_PC_SAMPLE.
+ * CMD_PC_SAMPLE clears the histogram and samples the interrupted program
+ * counter every wValue us, 0 stops. Code addresses from PC_SAMPLE_BASE on
+ * are counted in buckets of 2^wIndex bytes. Stalls without the build
+ * flag, with a period or bucket size out of range, or when the IRQ stack
+ * is not found in the D-TCM.
+ *
+ * CMD_READ_PC_SAMPLE returns the counters and PC_SAMPLE_CHUNK buckets
+ * from bucket wValue * PC_SAMPLE_CHUNK on. Every sample lands in exactly
+ * one of the buckets, idle, nested, itcm, other or unknown. */
+#define PC_SAMPLE_BASE        ( 0x40000000 )  /* System RAM */
+#define PC_SAMPLE_BUCKETS     ( 4096 )
+#define PC_SAMPLE_CHUNK       ( 64 )
+#define PC_SAMPLE_MIN_US      ( 20 )
+#define PC_SAMPLE_SHIFT_MIN   ( 2 )
+#define PC_SAMPLE_SHIFT_MAX   ( 10 )
+
+typedef struct PcSampleChunk_t {
+	uint8_t  supported;     /* Image built with ITS_FX3_PC_SAMPLE */
+	uint8_t  running;
+	uint8_t  shift;         /* Bucket size is 1 << shift bytes */
+	uint8_t  reserved;
+	uint16_t period_us;
+	uint16_t buckets;       /* PC_SAMPLE_BUCKETS */
+	uint32_t base;          /* PC_SAMPLE_BASE */
+	uint32_t samples;       /* Since CMD_PC_SAMPLE */
+	uint32_t idle;          /* ThreadX scheduler idle, no thread running */
+	uint32_t nested;        /* In another interrupt handler */
+	uint32_t itcm;          /* Below PC_SAMPLE_BASE, instruction TCM */
+	uint32_t other;         /* Above the buckets */
+	uint32_t unknown;       /* Interrupt frame failed its checks */
+	uint32_t first;         /* Bucket of counts[ 0 ] */
+	uint32_t irq_top;       /* IRQ stack top the frames are read below */
+	uint32_t counts[ PC_SAMPLE_CHUNK ];
+} PcSampleChunk_t;
+
+/* CPU load accounting of images built with ITS_FX3_CPU_LOAD. CMD_CPU_LOAD
+ * clears the accounting and samples what the CPU is doing every wValue us,
+ * closing a window every wIndex ms, wValue 0 stops. Stalls without the
+ * build flag or with a period or window out of range.
+ *
+ * CMD_READ_CPU_LOAD returns the last CPU_LOAD_WINDOWS windows, newest
+ * first. Every sample of a window lands in exactly one of idle, nested,
+ * late, other or thread[]. Samples taken with a thread running go to the
+ * slot of that thread, the first CPU_LOAD_THREADS threads seen get one.
+ * A sample taken more than late_ticks after the timer expired waited for
+ * an interrupt handler or code with interrupts off and counts as late,
+ * whatever it found running. */
+#define CPU_LOAD_THREADS      ( 8 )
+#define CPU_LOAD_WINDOWS      ( 4 )
+#define CPU_LOAD_NAME_LEN     ( 16 )
+#define CPU_LOAD_MIN_US       ( 20 )
+#define CPU_LOAD_MIN_WINDOW   ( 10 )      /* ms */
+#define CPU_LOAD_MAX_WINDOW   ( 60000 )
+#define CPU_LOAD_LATE_US      ( 3 )       /* Slack over the fastest sample */
+
+typedef struct CpuLoadWindow_t {
+	uint32_t seq;           /* Windows closed since CMD_CPU_LOAD, from 1, 0 if empty */
+	uint32_t end_ms;        /* CyU3PGetTime() at the close */
+	uint32_t samples;
+	uint32_t idle;          /* ThreadX scheduler idle, no thread running */
+	uint32_t nested;        /* In another interrupt handler */
+	uint32_t late;          /* Held off by a handler or interrupts off */
+	uint32_t other;         /* Threads without a slot */
+	uint32_t self_ticks;    /* Time in the sampler itself, part of the busy time */
+	uint32_t thread[ CPU_LOAD_THREADS ];
+} CpuLoadWindow_t;
+
+typedef struct CpuLoadStatus_t {
+	uint8_t  supported;     /* Image built with ITS_FX3_CPU_LOAD */
+	uint8_t  running;
+	uint8_t  threads;       /* Slots in use */
+	uint8_t  reserved;
+	uint16_t period_us;
+	uint16_t window_ms;
+	uint32_t tick_hz;       /* Sampler timer ticks per second */
+	uint32_t min_ticks;     /* Fastest timer expiry to sample seen */
+	uint32_t late_ticks;    /* Threshold for late */
+	char     name[ CPU_LOAD_THREADS ][ CPU_LOAD_NAME_LEN ];  /* ThreadX names of the slots */
+	CpuLoadWindow_t window[ CPU_LOAD_WINDOWS ];
+} CpuLoadStatus_t;
 
 #endif /* HOST_COMMANDS_H_ */
@@ -10,5 +10,27 @@
 #define ITS_FX3_HAVE_SPI
 //#define ITS_FX3_DONT_HAVE_SPI
 
+/* Start streaming as soon as the host configures the device instead of
+ * waiting for CMD_STREAM_START. Only for host software that predates it. */
+//#define ITS_FX3_STREAM_AUTOSTART
+
+/* GPIF data line the LATENCY_MARK output (GPIO44) is looped to on the
+ * board, for CMD_LATENCY_MARK. That line no longer carries front-end
+ * data. Leave undefined if the loop is not fitted. */
+//#define ITS_FX3_LATENCY_MARK_LINE   7
+
+/* Time the code regions of host_commands.h with a GPIO timer for
+ * CMD_READ_PROFILE (cycle_prof.h). Off in production, the hooks are
+ * compiled out. */
+//#define ITS_FX3_PROFILE
+
+/* Statistical PC profiler for CMD_PC_SAMPLE (pc_sample.h), 16 KB of
+ * histogram. Off in production. */
+//#define ITS_FX3_PC_SAMPLE
+
+/* CPU load accounting for CMD_CPU_LOAD (cpu_load.h): idle, interrupt and
+ * per-thread shares by window. */
+//#define ITS_FX3_CPU_LOAD
+
 
 #endif /* ITS_FX3_PROJECT_CONFIG_H_ */
@@ -0,0 +1,20 @@
+#ifndef ITS_SAMPLE_FORMAT_H_
+#define ITS_SAMPLE_FORMAT_H_
+
+/*
+ * Raw sample format on the GPIF bus, shared by firmware and host tools.
+ *
+ * The GPIF bus of gpif2_config.h is 8 bit wide and latches one byte per
+ * sample clock. Every byte carries one sample of each of the four
+ * front-end channels.
+ * Channel c sits in bits [2c+1:2c]. Bit 0 of a code is the magnitude,
+ * bit 1 the sign: 0 -> +1, 1 -> +3, 2 -> -1, 3 -> -3.
+ */
+
+#define ITS_SAMPLE_CHANNELS     ( 4 )
+#define ITS_SAMPLE_BITS         ( 2 )
+
+#define ITS_SAMPLE_CODE( byte, ch )  ( ( (byte) >> ( ITS_SAMPLE_BITS * (ch) ) ) & 0x3 )
+#define ITS_SAMPLE_VALUE( code )     ( ( ( (code) & 0x1 ) ? 3 : 1 ) * ( ( (code) & 0x2 ) ? -1 : 1 ) )
+
+#endif /* ITS_SAMPLE_FORMAT_H_ */
@@ -0,0 +1,166 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+
+#include "its_sample_format.h"
+#include "cic_decim.h"
+#include "stream_tap.h"
+#include "jam_detect.h"
+
+/*
+ * Narrowband interference detector.
+ *
+ * For each new buffer waiting for USB (see stream_tap.c) the first
+ * (block + JAM_SETTLE) << log2r bytes are decimated by the CIC into a
+ * scratch buffer, the first JAM_SETTLE outputs are dropped while the
+ * filter settles. A Goertzel filter per configured bin and channel then
+ * runs over block samples.
+ *
+ * The level of a bin is its power relative to the mean power of all N
+ * bins of a block, |X[k]|^2 / sum(x^2), in Q8. White noise gives about
+ * 1.0 (256) in every bin, a tone of amplitude A in noise of power s^2
+ * about N A^2 / 4 s^2. Levels above the threshold latch an alarm bit.
+ */
+
+#define JAM_SETTLE     (2)    /* CIC outputs dropped at the start of a block */
+#define JAM_COEFF_FRAC (14)
+
+static CyU3PMutex glJamLock;
+static JamConfig_t glJamConfig;
+static JamStatus_t glJamStatus;
+static uint16_t glJamLastIndex = 0xFFFF;
+static CicDecim_t glJamCic;
+static int16_t glJamScratch[ ( JAM_MAX_BLOCK + JAM_SETTLE ) * ITS_SAMPLE_CHANNELS ];
+
+void CyFxJamInit( void )
+{
+	CyU3PMutexCreate( &glJamLock, CYU3P_INHERIT );
+	CyU3PMemSet( (uint8_t*)&glJamConfig, 0, sizeof( glJamConfig ) );
+	CyU3PMemSet( (uint8_t*)&glJamStatus, 0, sizeof( glJamStatus ) );
+}
+
+CyBool_t CyFxJamConfigure( const JamConfig_t* config )
+{
+	CyBool_t valid;
+
+	valid = ( config->bins <= JAM_MAX_BINS &&
+			config->log2r >= CIC_DECIM_LOG2_MIN && config->log2r <= CIC_DECIM_LOG2_MAX &&
+			config->block >= JAM_MIN_BLOCK && config->block <= JAM_MAX_BLOCK );
+
+	CyU3PMutexGet( &glJamLock, CYU3P_WAIT_FOREVER );
+	CyU3PMemSet( (uint8_t*)&glJamStatus, 0, sizeof( glJamStatus ) );
+	if ( valid ) {
+		glJamConfig = *config;
+	} else {
+		glJamConfig.bins = 0;
+	}
+	glJamStatus.bins = glJamConfig.bins;
+	glJamStatus.block = glJamConfig.block;
+	glJamStatus.log2r = glJamConfig.log2r;
+	glJamLastIndex = 0xFFFF;
+	CyU3PMutexPut( &glJamLock );
+
+	return valid;
+}
+
+CyBool_t CyFxJamActive( void )
+{
+	return ( glJamConfig.bins > 0 );
+}
+
+/* Goertzel filter over n samples of channel ch, returns |X[k]|^2. */
+static uint64_t CyFxJamGoertzel( const int16_t* x, uint32_t n, int32_t coeff )
+{
+	int32_t s0, s1 = 0, s2 = 0;
+	int64_t p;
+	uint32_t i;
+
+	for ( i = 0; i < n; i++ ) {
+		s0 = *x + (int32_t)( ( (int64_t)coeff * s1 ) >> JAM_COEFF_FRAC ) - s2;
+		s2 = s1;
+		s1 = s0;
+		x += ITS_SAMPLE_CHANNELS;
+	}
+
+	p = (int64_t)s1 * s1 + (int64_t)s2 * s2 - ( ( (int64_t)coeff * s1 >> JAM_COEFF_FRAC ) * s2 );
+	return ( p > 0 ) ? (uint64_t)p : 0;
+}
+
+static void CyFxJamAnalyse( uint32_t n )
+{
+	const int16_t* x = &glJamScratch[ JAM_SETTLE * ITS_SAMPLE_CHANNELS ];
+	uint64_t energy, power, level;
+	uint32_t ch, bin, i;
+	CyBool_t alarm = CyFalse;
+
+	for ( ch = 0; ch < ITS_SAMPLE_CHANNELS; ch++ ) {
+		energy = 0;
+		for ( i = 0; i < n; i++ )
+			energy += (int32_t)x[ i * ITS_SAMPLE_CHANNELS + ch ] * x[ i * ITS_SAMPLE_CHANNELS + ch ];
+		if ( energy == 0 )
+			energy = 1;
+
+		for ( bin = 0; bin < glJamConfig.bins; bin++ ) {
+			power = CyFxJamGoertzel( x + ch, n, glJamConfig.coeff_q14[ bin ] );
+			level = ( power << 8 ) / energy;
+			if ( level > 0xFFFFFFFF )
+				level = 0xFFFFFFFF;
+
+			glJamStatus.level_q8[ ch ][ bin ] = (uint32_t)level;
+			if ( level > glJamStatus.peak_q8[ ch ][ bin ] )
+				glJamStatus.peak_q8[ ch ][ bin ] = (uint32_t)level;
+			if ( level > glJamConfig.threshold_q8 ) {
+				glJamStatus.alarm_mask |= ( 1u << ( ch * JAM_MAX_BINS + bin ) );
+				alarm = CyTrue;
+			}
+		}
+	}
+
+	glJamStatus.blocks++;
+	if ( alarm ) {
+		glJamStatus.alarms++;
+		glJamStatus.last_alarm_ms = CyU3PGetTime();
+	}
+}
+
+void CyFxJamPoll( uint16_t sckId )
+{
+	StreamTap_t tap;
+	uint32_t n, len;
+
+	if ( !CyFxJamActive() )
+		return;
+	if ( !CyFxStreamTapPeek( sckId, glJamLastIndex, &tap ) )
+		return;
+
+	CyU3PMutexGet( &glJamLock, CYU3P_WAIT_FOREVER );
+	n = glJamConfig.block;
+	len = ( n + JAM_SETTLE ) << glJamConfig.log2r;
+	if ( glJamConfig.bins == 0 || len > tap.count ) {
+		glJamStatus.dropped++;
+		CyU3PMutexPut( &glJamLock );
+		return;
+	}
+
+	CyFxCicInit( &glJamCic, glJamConfig.log2r );
+	CyFxCicRun( &glJamCic, tap.buffer, len, (uint8_t*)glJamScratch );
+
+	if ( CyFxStreamTapValid( sckId, &tap ) ) {
+		glJamLastIndex = tap.index;
+		CyFxJamAnalyse( n );
+	} else {
+		glJamStatus.dropped++;
+	}
+	CyU3PMutexPut( &glJamLock );
+}
+
+void CyFxJamGetStatus( JamStatus_t* status, CyBool_t clear )
+{
+	CyU3PMutexGet( &glJamLock, CYU3P_WAIT_FOREVER );
+	*status = glJamStatus;
+	if ( clear ) {
+		glJamStatus.alarm_mask = 0;
+		CyU3PMemSet( (uint8_t*)glJamStatus.peak_q8, 0, sizeof( glJamStatus.peak_q8 ) );
+	}
+	CyU3PMutexPut( &glJamLock );
+}
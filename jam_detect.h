@@ -0,0 +1,24 @@
+#ifndef JAM_DETECT_H_
+#define JAM_DETECT_H_
+
+#include <cyu3types.h>
+#include "host_commands.h"
+
+#define CY_FX_JAM_PERIOD_MS  (10)     /* Application loop period while enabled */
+
+void CyFxJamInit( void );
+
+/* Apply a configuration, bins == 0 disables. Returns CyFalse and disables
+ * the detector if the configuration is invalid. */
+CyBool_t CyFxJamConfigure( const JamConfig_t* config );
+
+CyBool_t CyFxJamActive( void );
+
+/* Analyse the buffer waiting on consumer socket sckId, if there is a new
+ * one. The caller keeps the channel from being reset or destroyed. */
+void CyFxJamPoll( uint16_t sckId );
+
+/* Copy the status, clear the latched alarms if clear is set. */
+void CyFxJamGetStatus( JamStatus_t* status, CyBool_t clear );
+
+#endif /* JAM_DETECT_H_ */
@@ -0,0 +1,85 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include <cyu3gpio.h>
+
+#include "its_fx3_project_config.h"
+#include "cyfxslfifosync.h"
+#include "cyfxspi_bb.h"
+#include "cpsr_utils.h"
+#include "gpif_bus.h"
+#include "latency_mark.h"
+
+/*
+ * Sample latency marker.
+ *
+ * LATENCY_MARK is looped on the board to one GPIF data line, so its level
+ * shows in the sample stream like front-end data. The host toggles it with
+ * CMD_LATENCY_MARK, timing the command on its own clock, and looks for the
+ * edge in the stream it receives: the arrival less the command time is the
+ * latency from the P-port pins to the application, with no clock shared
+ * between the two sides.
+ *
+ * The reply carries the stream position at the edge, taken the same way
+ * as a 1PPS tag, so the host can check it matched the right edge: the edge
+ * is never before that offset and at most a few DMA buffers after it.
+ */
+
+static uint32_t glMarkSeq = 0;
+
+void CyFxLatencyMarkInit( void )
+{
+#ifdef ITS_FX3_LATENCY_MARK_LINE
+	CyU3PGpioSimpleConfig_t gpioConfig;
+	CyU3PReturnStatus_t apiRetStatus;
+
+	apiRetStatus = CyU3PDeviceGpioOverride( LATENCY_MARK, CyTrue );
+	if ( apiRetStatus != CY_U3P_SUCCESS ) {
+		CyU3PDebugPrint( 4, "LATENCY_MARK CyU3PDeviceGpioOverride failed, error code = %d\n", apiRetStatus );
+	}
+
+	gpioConfig.outValue = CyFalse;
+	gpioConfig.driveLowEn = CyTrue;
+	gpioConfig.driveHighEn = CyTrue;
+	gpioConfig.inputEn = CyFalse;
+	gpioConfig.intrMode = CY_U3P_GPIO_NO_INTR;
+	apiRetStatus = CyU3PGpioSetSimpleConfig( LATENCY_MARK, &gpioConfig );
+	if ( apiRetStatus != CY_U3P_SUCCESS ) {
+		CyU3PDebugPrint( 4, "LATENCY_MARK CyU3PGpioSetSimpleConfig failed, error code = %d\n", apiRetStatus );
+	}
+#endif
+}
+
+CyU3PReturnStatus_t CyFxLatencyMark( CyBool_t level, LatencyMark_t* mark )
+{
+#ifdef ITS_FX3_LATENCY_MARK_LINE
+	CyU3PReturnStatus_t status;
+	uint64_t offset;
+	uint32_t streamId;
+	uint32_t cpsr;
+	uint8_t flags;
+
+	/* Edge and position together, the P-port may commit in between */
+	cpsr = disable_interrupts();
+	status = CyU3PGpioSetValue( LATENCY_MARK, level );
+	flags = CyFxStreamPosition( &offset, &streamId ) ? PPS_FLAG_STREAMING : 0;
+	restore_interrupts( cpsr );
+	if ( status != CY_U3P_SUCCESS )
+		return status;
+
+	CyU3PMemSet( (uint8_t*)mark, 0, sizeof( *mark ) );
+	mark->line = ITS_FX3_LATENCY_MARK_LINE;
+	mark->width = CY_FX_GPIF_WIDTH;
+	mark->level = level ? 1 : 0;
+	mark->flags = flags;
+	mark->seq = ++glMarkSeq;
+	mark->time_ms = CyU3PGetTime();
+	mark->stream = streamId;
+	mark->offset = offset;
+	return CY_U3P_SUCCESS;
+#else
+	(void)level;
+	(void)mark;
+	return CY_U3P_ERROR_NOT_SUPPORTED;
+#endif
+}
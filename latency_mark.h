@@ -0,0 +1,15 @@
+#ifndef LATENCY_MARK_H_
+#define LATENCY_MARK_H_
+
+#include <cyu3types.h>
+#include "host_commands.h"
+
+/* Configure LATENCY_MARK as an output, low. Called from CyFxGpioInit. */
+void CyFxLatencyMarkInit( void );
+
+/* CMD_LATENCY_MARK: drive the output to level and fill mark with the
+ * state right after. CY_U3P_ERROR_NOT_SUPPORTED without
+ * ITS_FX3_LATENCY_MARK_LINE. */
+CyU3PReturnStatus_t CyFxLatencyMark( CyBool_t level, LatencyMark_t* mark );
+
+#endif /* LATENCY_MARK_H_ */
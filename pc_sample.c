@@ -0,0 +1,222 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include <cyu3gpio.h>
+
+#include "its_fx3_project_config.h"
+#include "cyfxspi_bb.h"
+#include "cpsr_utils.h"
+#include "pc_sample.h"
+
+/*
+ * Statistical PC profiler for images built with ITS_FX3_PC_SAMPLE.
+ *
+ * The complex GPIO of PC_SAMPLE_TIMER counts on the GPIO fast clock and
+ * interrupts at every wrap. The handler takes the program counter the
+ * interrupt came in at and counts it in a histogram over system RAM,
+ * which host/itspcs maps to the symbols of cyfxslfifosync.map. Code that
+ * runs with interrupts off is seen late, at its end.
+ *
+ * The GPIO callback runs well after the IRQ entry, so the point of
+ * interrupt is taken from the frame the ThreadX ARM9 port leaves on the
+ * IRQ stack. For the first interrupt, _tx_thread_context_save pushes
+ * r0-r3 and then SPSR, r10, r12 and the point of interrupt, from the top
+ * of the IRQ stack down. That holds while _tx_thread_system_state is 1. A
+ * higher count means the timer interrupted another handler, whose frame
+ * is deeper: counted as nested. With no thread running the interrupt hit
+ * the scheduler's idle loop, whose frame ThreadX drops: counted as idle.
+ *
+ * The top of the IRQ stack is not taken from the SDK memory map but read
+ * from the IRQ mode stack pointer when sampling starts. Between
+ * interrupts ThreadX leaves it at the top, and CMD_PC_SAMPLE runs in a
+ * thread. A top outside the D-TCM stalls the command. Each frame is then
+ * checked before its PC is used: the saved SPSR must be a thread mode
+ * with IRQs enabled, as it was when the interrupt was taken, and the PC
+ * aligned for its instruction set. Anything else is counted as unknown,
+ * so a different port or stack layout shows up in the counters rather
+ * than as a wrong histogram.
+ */
+
+#define CY_FX_PC_SAMPLE_CLK_DIV     (2)             /* gpioClock.fastClkDiv in CyFxGpioInit */
+#define CY_FX_PC_SAMPLE_FRAME_PC    (5)             /* Words below the top */
+#define CY_FX_PC_SAMPLE_FRAME_SPSR  (8)
+
+#define CY_FX_DTCM_BASE             (0x10000000)
+#define CY_FX_DTCM_SIZE             (0x2000)
+
+#define CY_FX_PSR_MODE_MASK         (0x1F)
+#define CY_FX_PSR_MODE_USR          (0x10)
+#define CY_FX_PSR_MODE_SVC          (0x13)
+#define CY_FX_PSR_MODE_SYS          (0x1F)
+#define CY_FX_PSR_THUMB             (0x20)
+#define CY_FX_PSR_IRQ_OFF           (0x80)
+
+#ifdef ITS_FX3_PC_SAMPLE
+/* ThreadX ARM9 port */
+extern volatile uint32_t _tx_thread_system_state;
+extern void* volatile _tx_thread_current_ptr;
+
+static uint32_t glPcCounts[ PC_SAMPLE_BUCKETS ];
+static uint32_t glPcSamples = 0;
+static uint32_t glPcIdle = 0;
+static uint32_t glPcNested = 0;
+static uint32_t glPcItcm = 0;
+static uint32_t glPcOther = 0;
+static uint32_t glPcUnknown = 0;
+static uint16_t glPcPeriodUs = 0;
+static uint8_t  glPcShift = 0;
+static uint32_t glPcIrqTop = 0;
+
+/* Stack pointer of IRQ mode, read in IRQ mode with IRQ and FIQ off. One
+ * asm block, so nothing is spilled to the other mode's stack. */
+static uint32_t CyFxPcSampleIrqSp( void )
+{
+	uint32_t sp, cpsr;
+
+	__asm__ volatile(
+		"MRS %1, CPSR\n\t"
+		"BIC %0, %1, #0x1F\n\t"
+		"ORR %0, %0, #0xD2\n\t"
+		"MSR CPSR_c, %0\n\t"
+		"MOV %0, SP\n\t"
+		"MSR CPSR_c, %1\n\t"
+		: "=&r"(sp), "=&r"(cpsr)
+	);
+	return sp;
+}
+#endif
+
+CyU3PReturnStatus_t CyFxPcSampleStart( uint16_t periodUs, uint8_t shift )
+{
+#ifdef ITS_FX3_PC_SAMPLE
+	CyU3PGpioComplexConfig_t gpioConfig;
+	CyU3PReturnStatus_t status;
+	uint32_t sysHz = 0;
+	uint32_t ticks;
+	uint32_t cpsr;
+	uint32_t irqTop;
+
+	if ( periodUs != 0 && ( periodUs < PC_SAMPLE_MIN_US ||
+			shift < PC_SAMPLE_SHIFT_MIN || shift > PC_SAMPLE_SHIFT_MAX ) )
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	status = CyU3PDeviceGetSysClkFreq( &sysHz );
+	if ( status != CY_U3P_SUCCESS )
+		return status;
+	ticks = ( sysHz / CY_FX_PC_SAMPLE_CLK_DIV / 1000000 ) * periodUs;
+
+	irqTop = CyFxPcSampleIrqSp();
+	if ( periodUs != 0 && ( ( irqTop & 3 ) != 0 ||
+			irqTop < CY_FX_DTCM_BASE + CY_FX_PC_SAMPLE_FRAME_SPSR * 4 ||
+			irqTop > CY_FX_DTCM_BASE + CY_FX_DTCM_SIZE ) )
+		return CY_U3P_ERROR_NOT_SUPPORTED;
+
+	status = CyU3PDeviceGpioOverride( PC_SAMPLE_TIMER, CyFalse );
+	if ( status != CY_U3P_SUCCESS )
+		return status;
+
+	CyU3PMemSet( (uint8_t*)&gpioConfig, 0, sizeof( gpioConfig ) );
+	gpioConfig.pinMode = CY_U3P_GPIO_MODE_STATIC;
+	gpioConfig.intrMode = CY_U3P_GPIO_NO_INTR;
+	gpioConfig.timerMode = CY_U3P_GPIO_TIMER_SHUTDOWN;
+	status = CyU3PGpioSetComplexConfig( PC_SAMPLE_TIMER, &gpioConfig );
+	if ( status != CY_U3P_SUCCESS )
+		return status;
+
+	cpsr = disable_interrupts();
+	CyU3PMemSet( (uint8_t*)glPcCounts, 0, sizeof( glPcCounts ) );
+	glPcSamples = glPcIdle = glPcNested = glPcItcm = glPcOther = glPcUnknown = 0;
+	glPcPeriodUs = periodUs;
+	if ( periodUs ) {
+		glPcShift = shift;
+		glPcIrqTop = irqTop;
+	}
+	restore_interrupts( cpsr );
+	if ( periodUs == 0 )
+		return CY_U3P_SUCCESS;
+
+	gpioConfig.intrMode = CY_U3P_GPIO_INTR_TIMER_ZERO;
+	gpioConfig.timerMode = CY_U3P_GPIO_TIMER_HIGH_FREQ;
+	gpioConfig.timer = 0;
+	gpioConfig.period = ticks;
+	gpioConfig.threshold = ticks;
+	return CyU3PGpioSetComplexConfig( PC_SAMPLE_TIMER, &gpioConfig );
+#else
+	(void)periodUs;
+	(void)shift;
+	return CY_U3P_ERROR_NOT_SUPPORTED;
+#endif
+}
+
+void CyFxPcSampleIsr( void )
+{
+#ifdef ITS_FX3_PC_SAMPLE
+	const volatile uint32_t* top = (const volatile uint32_t*)glPcIrqTop;
+	uint32_t spsr, pc, mode, bucket;
+
+	glPcSamples++;
+	if ( _tx_thread_system_state > 1 ) {
+		glPcNested++;
+		return;
+	}
+	if ( _tx_thread_current_ptr == 0 ) {
+		glPcIdle++;
+		return;
+	}
+
+	spsr = top[ -CY_FX_PC_SAMPLE_FRAME_SPSR ];
+	pc = top[ -CY_FX_PC_SAMPLE_FRAME_PC ];
+	mode = spsr & CY_FX_PSR_MODE_MASK;
+	if ( ( mode != CY_FX_PSR_MODE_USR && mode != CY_FX_PSR_MODE_SVC && mode != CY_FX_PSR_MODE_SYS ) ||
+			( spsr & CY_FX_PSR_IRQ_OFF ) != 0 ||
+			( pc & ( ( spsr & CY_FX_PSR_THUMB ) ? 1 : 3 ) ) != 0 ) {
+		glPcUnknown++;
+		return;
+	}
+
+	if ( pc < PC_SAMPLE_BASE ) {
+		glPcItcm++;
+		return;
+	}
+	bucket = ( pc - PC_SAMPLE_BASE ) >> glPcShift;
+	if ( bucket >= PC_SAMPLE_BUCKETS ) {
+		glPcOther++;
+		return;
+	}
+	glPcCounts[ bucket ]++;
+#endif
+}
+
+void CyFxPcSampleGetChunk( uint16_t chunk, PcSampleChunk_t* status )
+{
+#ifdef ITS_FX3_PC_SAMPLE
+	uint32_t first = (uint32_t)chunk * PC_SAMPLE_CHUNK;
+	uint32_t cpsr;
+	uint32_t i;
+#endif
+
+	CyU3PMemSet( (uint8_t*)status, 0, sizeof( *status ) );
+	status->buckets = PC_SAMPLE_BUCKETS;
+	status->base = PC_SAMPLE_BASE;
+#ifdef ITS_FX3_PC_SAMPLE
+	status->supported = 1;
+	status->first = first;
+
+	cpsr = disable_interrupts();
+	status->running = glPcPeriodUs ? 1 : 0;
+	status->shift = glPcShift;
+	status->period_us = glPcPeriodUs;
+	status->samples = glPcSamples;
+	status->idle = glPcIdle;
+	status->nested = glPcNested;
+	status->itcm = glPcItcm;
+	status->other = glPcOther;
+	status->unknown = glPcUnknown;
+	status->irq_top = glPcIrqTop;
+	for ( i = 0; i < PC_SAMPLE_CHUNK && first + i < PC_SAMPLE_BUCKETS; i++ ) {
+		status->counts[ i ] = glPcCounts[ first + i ];
+	}
+	restore_interrupts( cpsr );
+#else
+	(void)chunk;
+#endif
+}
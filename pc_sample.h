@@ -0,0 +1,17 @@
+#ifndef PC_SAMPLE_H_
+#define PC_SAMPLE_H_
+
+#include <cyu3types.h>
+#include "host_commands.h"
+
+/* CMD_PC_SAMPLE: clear and sample every periodUs, 0 stops. Buckets of
+ * 1 << shift bytes. CY_U3P_ERROR_NOT_SUPPORTED without ITS_FX3_PC_SAMPLE. */
+CyU3PReturnStatus_t CyFxPcSampleStart( uint16_t periodUs, uint8_t shift );
+
+/* GPIO interrupt handler for PC_SAMPLE_TIMER. Interrupt context. */
+void CyFxPcSampleIsr( void );
+
+/* CMD_READ_PC_SAMPLE: counters and the buckets of chunk. */
+void CyFxPcSampleGetChunk( uint16_t chunk, PcSampleChunk_t* status );
+
+#endif /* PC_SAMPLE_H_ */
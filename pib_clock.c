@@ -0,0 +1,148 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3pib.h"
+
+#include "pib_clock.h"
+
+/*
+ * P-port clock selection.
+ *
+ * The GPIF interface runs on the front-end clock, the PIB clock drives the
+ * P-port core and its DMA adapters behind it. It has to keep up with the
+ * interface clock but every MHz above that only costs power. The setting
+ * is kept here so the status can report it together with the resulting
+ * frequency, computed from the system clock the SDK reports.
+ */
+
+static PibClockConfig_t glPibConfig;
+static PibClockConfig_t glPibPrevConfig;    /* Before the last change, for CyFxPibClockRevert */
+static uint32_t glPibHz = 0;
+static uint32_t glPibPrevHz = 0;
+static uint32_t glPibChanges = 0;
+static uint32_t glPibResult = PIB_CLK_OK;
+static uint32_t glPibSwitchMs = 0;
+
+static void CyFxPibClockToSdk( const PibClockConfig_t* config, CyU3PPibClock_t* pibClock )
+{
+	pibClock->clkDiv = config->div;
+	pibClock->isHalfDiv = config->half_div ? CyTrue : CyFalse;
+	pibClock->isDllEnable = config->dll ? CyTrue : CyFalse;
+	switch ( config->source ) {
+	case PIB_CLK_SRC_SYS_BY_16: pibClock->clkSrc = CY_U3P_SYS_CLK_BY_16; break;
+	case PIB_CLK_SRC_SYS_BY_4:  pibClock->clkSrc = CY_U3P_SYS_CLK_BY_4;  break;
+	case PIB_CLK_SRC_SYS_BY_2:  pibClock->clkSrc = CY_U3P_SYS_CLK_BY_2;  break;
+	default:                    pibClock->clkSrc = CY_U3P_SYS_CLK;       break;
+	}
+}
+
+static uint32_t CyFxPibClockSysHz( void )
+{
+	uint32_t sysHz = 0;
+
+	if ( CyU3PDeviceGetSysClkFreq( &sysHz ) != CY_U3P_SUCCESS )
+		sysHz = 0;
+	return sysHz;
+}
+
+uint32_t CyFxPibClockCheck( const PibClockConfig_t* config, uint32_t* pibHz )
+{
+	static const uint8_t srcShift[] = { 4, 2, 1, 0 };
+	uint32_t srcHz;
+
+	*pibHz = 0;
+	if ( config->source > PIB_CLK_SRC_SYS || config->div < PIB_CLK_DIV_MIN ||
+			config->div > PIB_CLK_DIV_MAX || config->half_div > 1 || config->dll > 1 )
+		return PIB_CLK_BAD_ARGUMENT;
+
+	/* src / ( div + half / 2 ) */
+	srcHz = CyFxPibClockSysHz() >> srcShift[ config->source ];
+	*pibHz = (uint32_t)( ( (uint64_t)srcHz * 2 ) / ( config->div * 2 + config->half_div ) );
+
+	if ( config->sample_khz != 0 && *pibHz < config->sample_khz * 1000ull )
+		return PIB_CLK_TOO_SLOW;
+	return PIB_CLK_OK;
+}
+
+CyU3PReturnStatus_t CyFxPibClockInit( void )
+{
+	CyU3PPibClock_t pibClock;
+	CyU3PReturnStatus_t status;
+
+	CyU3PMemSet( (uint8_t*)&glPibConfig, 0, sizeof( glPibConfig ) );
+	glPibConfig.div = CY_FX_PIB_CLK_DEFAULT_DIV;
+	glPibConfig.source = PIB_CLK_SRC_SYS;
+	/* DLL disabled for sync GPIF */
+	glPibConfig.dll = 0;
+
+	CyFxPibClockToSdk( &glPibConfig, &pibClock );
+	status = CyU3PPibInit( CyTrue, &pibClock );
+	if ( status == CY_U3P_SUCCESS )
+		CyFxPibClockCheck( &glPibConfig, &glPibHz );
+	return status;
+}
+
+uint32_t CyFxPibClockApply( const PibClockConfig_t* config )
+{
+	CyU3PPibClock_t pibClock;
+	CyU3PReturnStatus_t status;
+	uint32_t result;
+	uint32_t pibHz;
+
+	result = CyFxPibClockCheck( config, &pibHz );
+	if ( result != PIB_CLK_OK )
+		return result;
+
+	CyU3PPibDeInit();
+	CyFxPibClockToSdk( config, &pibClock );
+	status = CyU3PPibInit( CyTrue, &pibClock );
+	if ( status == CY_U3P_SUCCESS ) {
+		glPibPrevConfig = glPibConfig;
+		glPibPrevHz = glPibHz;
+		glPibConfig = *config;
+		glPibHz = pibHz;
+		glPibChanges++;
+		return PIB_CLK_OK;
+	}
+
+	CyU3PDebugPrint( 4, "P-port re-init failed, Error Code = %d\n", status );
+	CyU3PPibDeInit();
+	CyFxPibClockToSdk( &glPibConfig, &pibClock );
+	CyU3PPibInit( CyTrue, &pibClock );
+	return PIB_CLK_INIT_FAILED;
+}
+
+CyU3PReturnStatus_t CyFxPibClockRevert( void )
+{
+	CyU3PPibClock_t pibClock;
+	CyU3PReturnStatus_t status;
+
+	CyU3PPibDeInit();
+	CyFxPibClockToSdk( &glPibPrevConfig, &pibClock );
+	status = CyU3PPibInit( CyTrue, &pibClock );
+	if ( status != CY_U3P_SUCCESS ) {
+		CyU3PDebugPrint( 4, "P-port restore failed, Error Code = %d\n", status );
+		return status;
+	}
+	glPibConfig = glPibPrevConfig;
+	glPibHz = glPibPrevHz;
+	glPibChanges--;
+	return CY_U3P_SUCCESS;
+}
+
+void CyFxPibClockResult( uint32_t result, uint32_t switchMs )
+{
+	glPibResult = result;
+	glPibSwitchMs = switchMs;
+}
+
+void CyFxPibClockGetStatus( PibClockStatus_t* status )
+{
+	CyU3PMemSet( (uint8_t*)status, 0, sizeof( *status ) );
+	status->config = glPibConfig;
+	status->pib_hz = glPibHz;
+	status->sys_hz = CyFxPibClockSysHz();
+	status->changes = glPibChanges;
+	status->result = glPibResult;
+	status->last_switch_ms = glPibSwitchMs;
+}
@@ -0,0 +1,32 @@
+#ifndef PIB_CLOCK_H_
+#define PIB_CLOCK_H_
+
+#include <cyu3types.h>
+#include "host_commands.h"
+
+/* Boot setting: system clock / 2, no DLL. */
+#define CY_FX_PIB_CLK_DEFAULT_DIV   (2)
+
+/* Initialize the P-port with the boot setting. */
+CyU3PReturnStatus_t CyFxPibClockInit( void );
+
+/* Check a setting, PIB_CLK_OK or the reason it is refused. pibHz gets the
+ * resulting clock. */
+uint32_t CyFxPibClockCheck( const PibClockConfig_t* config, uint32_t* pibHz );
+
+/* Re-initialize the P-port with a checked setting, GPIF stopped and no DMA
+ * channel on the P-port sockets. The GPIF configuration has to be loaded
+ * again afterwards. If the init fails the
+ * previous setting is restored and PIB_CLK_INIT_FAILED returned. */
+uint32_t CyFxPibClockApply( const PibClockConfig_t* config );
+
+/* Go back to the setting before the last successful CyFxPibClockApply,
+ * when the GPIF configuration does not load on the new one. */
+CyU3PReturnStatus_t CyFxPibClockRevert( void );
+
+/* Record the outcome of a CMD_PIB_CLOCK for the status. */
+void CyFxPibClockResult( uint32_t result, uint32_t switchMs );
+
+void CyFxPibClockGetStatus( PibClockStatus_t* status );
+
+#endif /* PIB_CLOCK_H_ */
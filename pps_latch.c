@@ -0,0 +1,81 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include <cyu3gpio.h>
+
+#include "cyfxslfifosync.h"
+#include "cyfxspi_bb.h"
+#include "cpsr_utils.h"
+#include "pps_latch.h"
+
+/*
+ * 1PPS time tags.
+ *
+ * Every rising edge on PPS_IN latches the stream byte offset GPIF is
+ * writing at into a small ring. The host reads the whole ring with
+ * CMD_READ_PPS and matches entries by sequence number, so nothing is added
+ * to the sample stream.
+ *
+ * The offset is the sum of the P-port socket byte counts, which move when
+ * GPIF commits a buffer. The edge is somewhere in the buffer being filled
+ * after offset, so the latch is exact to one DMA buffer: 16 KB with full
+ * buffers, less under a flush deadline (FlushStatus_t.buffer_bytes). GPIF
+ * does count the words of that buffer, its data counter ends each buffer
+ * (gpif_load.c), but the counter has no read back in the SDK register
+ * map, CyU3PGpifGetSMState gives only the state, so the position within
+ * the buffer is not latched.
+ */
+
+static PpsEvent_t glPpsRing[ PPS_LOG_LEN ];
+static volatile uint32_t glPpsTotal = 0;
+
+void CyFxPpsInit( void )
+{
+	CyU3PGpioSimpleConfig_t gpioConfig;
+	CyU3PReturnStatus_t apiRetStatus;
+
+	gpioConfig.outValue = CyFalse;
+	gpioConfig.driveLowEn = CyFalse;
+	gpioConfig.driveHighEn = CyFalse;
+	gpioConfig.inputEn = CyTrue;
+	gpioConfig.intrMode = CY_U3P_GPIO_INTR_POS_EDGE;
+	apiRetStatus = CyU3PGpioSetSimpleConfig( PPS_IN, &gpioConfig );
+	if ( apiRetStatus != CY_U3P_SUCCESS ) {
+		CyU3PDebugPrint( 4, "PPS_IN CyU3PGpioSetSimpleConfig failed, error code = %d\n", apiRetStatus );
+	}
+}
+
+void CyFxPpsIsr( void )
+{
+	PpsEvent_t* ev = &glPpsRing[ glPpsTotal % PPS_LOG_LEN ];
+	uint64_t offset;
+	uint32_t streamId;
+
+	ev->flags = CyFxStreamPosition( &offset, &streamId ) ? PPS_FLAG_STREAMING : 0;
+	ev->offset = offset;
+	ev->stream = streamId;
+	ev->time_ms = CyU3PGetTime();
+	ev->seq = ++glPpsTotal;
+}
+
+void CyFxPpsGetLog( PpsLog_t* log )
+{
+	uint32_t cpsr;
+	uint32_t total;
+	uint32_t count;
+	uint32_t i;
+
+	cpsr = disable_interrupts();
+	total = glPpsTotal;
+	count = ( total < PPS_LOG_LEN ) ? total : PPS_LOG_LEN;
+	for ( i = 0; i < count; i++ ) {
+		log->events[ i ] = glPpsRing[ ( total - count + i ) % PPS_LOG_LEN ];
+	}
+	restore_interrupts( cpsr );
+
+	log->total = total;
+	log->count = count;
+	for ( ; i < PPS_LOG_LEN; i++ ) {
+		CyU3PMemSet( (uint8_t*)&log->events[ i ], 0, sizeof( PpsEvent_t ) );
+	}
+}
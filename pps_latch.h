@@ -0,0 +1,16 @@
+#ifndef PPS_LATCH_H_
+#define PPS_LATCH_H_
+
+#include <cyu3types.h>
+#include "host_commands.h"
+
+/* Configure PPS_IN as a rising edge interrupt input. Called from CyFxGpioInit. */
+void CyFxPpsInit( void );
+
+/* GPIO interrupt handler for PPS_IN. Interrupt context. */
+void CyFxPpsIsr( void );
+
+/* Copy of the latched edges, oldest first. */
+void CyFxPpsGetLog( PpsLog_t* log );
+
+#endif /* PPS_LATCH_H_ */
@@ -0,0 +1,174 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+
+#include "cyfxslfifosync.h"
+#include "cpsr_utils.h"
+#include "pretrig_capture.h"
+
+/*
+ * Pre-trigger capture.
+ *
+ * The stream channel is switched to MANUAL_MANY_TO_ONE with every buffer
+ * the heap can give. GPIF fills the buffers, the CPU keeps them and drops
+ * the oldest one whenever fewer than tail + 1 buffers are left free, so the
+ * ring always holds the most recent samples and nothing goes to USB.
+ *
+ * The trigger (host command or TRIGGER_IN) records how many buffers lie
+ * before the one being filled, GPIF then fills the tail buffers. After that
+ * the application thread stops GPIF and commits window and tail, oldest
+ * first, to EP 0x81.
+ *
+ * Commit and discard always act on the oldest buffer the CPU holds.
+ */
+
+static CyU3PDmaMultiChannel* glPtChannel = NULL;
+static volatile uint8_t  glPtState = PRETRIG_IDLE;
+static volatile uint16_t glPtHeld = 0;       /* Produced buffers held by the CPU */
+static volatile uint16_t glPtPreBufs = 0;
+static volatile uint16_t glPtTailLeft = 0;
+static volatile uint16_t glPtCommitted = 0;
+static volatile uint16_t glPtSent = 0;
+static volatile uint32_t glPtDiscarded = 0;
+static volatile uint32_t glPtFireTime = 0;
+static uint16_t glPtTailBufs = 0;
+static uint16_t glPtPreMax = 0;
+static uint16_t glPtBufSize = 0;
+static uint16_t glPtBufCount = 0;
+
+void CyFxPretrigDmaCb( CyU3PDmaMultiChannel* chHandle, CyU3PDmaCbType_t type, CyU3PDmaCBInput_t* input )
+{
+	CyU3PDmaBuffer_t buf;
+
+	if ( type == CY_U3P_DMA_CB_PROD_EVENT ) {
+		glPtHeld++;
+		if ( glPtState == PRETRIG_FILLING ) {
+			if ( glPtHeld > glPtPreMax ) {
+				if ( CyU3PDmaMultiChannelGetBuffer( chHandle, &buf, CYU3P_NO_WAIT ) == CY_U3P_SUCCESS &&
+						CyU3PDmaMultiChannelDiscardBuffer( chHandle ) == CY_U3P_SUCCESS ) {
+					glPtHeld--;
+					glPtDiscarded++;
+				}
+			}
+		} else if ( glPtState == PRETRIG_TRIGGERED ) {
+			if ( --glPtTailLeft == 0 ) {
+				glPtState = PRETRIG_FROZEN;
+				CyU3PEventSet( &glAppEvent, CY_FX_APP_EVT_PRETRIG_FROZEN, CYU3P_EVENT_OR );
+			}
+		}
+	} else if ( type == CY_U3P_DMA_CB_CONS_EVENT ) {
+		if ( glPtState == PRETRIG_UPLOADING ) {
+			if ( ++glPtSent >= glPtCommitted ) {
+				glPtState = PRETRIG_DONE;
+			}
+		}
+	}
+}
+
+CyU3PReturnStatus_t CyFxPretrigPrepare( CyU3PDmaMultiChannel* chHandle, uint16_t tailBufs,
+		uint16_t bufSize, uint16_t bufCount )
+{
+	if ( tailBufs < 1 || tailBufs + 2 > bufCount ) {
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+
+	glPtChannel = chHandle;
+	glPtBufSize = bufSize;
+	glPtBufCount = bufCount;
+	glPtTailBufs = tailBufs;
+	glPtPreMax = bufCount - tailBufs - 1;
+	glPtHeld = 0;
+	glPtPreBufs = 0;
+	glPtCommitted = 0;
+	glPtSent = 0;
+	glPtDiscarded = 0;
+	glPtState = PRETRIG_FILLING;
+	return CY_U3P_SUCCESS;
+}
+
+uint32_t CyFxPretrigFire( void )
+{
+	uint32_t cpsr;
+	uint32_t offset;
+
+	cpsr = disable_interrupts();
+	if ( glPtState == PRETRIG_FILLING ) {
+		glPtPreBufs = glPtHeld;
+		glPtTailLeft = glPtTailBufs;
+		glPtFireTime = CyU3PGetTime();
+		glPtState = PRETRIG_TRIGGERED;
+	}
+	offset = (uint32_t)glPtPreBufs * glPtBufSize;
+	restore_interrupts( cpsr );
+	return offset;
+}
+
+CyBool_t CyFxPretrigOverflow( void )
+{
+	if ( glPtState == PRETRIG_FILLING ) {
+		/* The channel is re-armed before GPIF restarts, the window refills. */
+		glPtHeld = 0;
+		return CyTrue;
+	}
+	if ( glPtState == PRETRIG_TRIGGERED ) {
+		glPtState = PRETRIG_FAILED;
+	}
+	return CyFalse;
+}
+
+void CyFxPretrigUpload( void )
+{
+	CyU3PDmaBuffer_t buf;
+	uint16_t n = glPtPreBufs + glPtTailBufs;
+	uint16_t i;
+	uint32_t cpsr;
+
+	if ( glPtState != PRETRIG_FROZEN ) {
+		return;
+	}
+
+	glPtSent = 0;
+	glPtCommitted = n;
+	glPtState = PRETRIG_UPLOADING;
+
+	for ( i = 0; i < n; i++ ) {
+		if ( CyU3PDmaMultiChannelGetBuffer( glPtChannel, &buf, CYU3P_NO_WAIT ) != CY_U3P_SUCCESS ||
+				CyU3PDmaMultiChannelCommitBuffer( glPtChannel, buf.count, 0 ) != CY_U3P_SUCCESS ) {
+			CyU3PDebugPrint( 4, "Pre-trigger upload stopped at buffer %d of %d\n", i, n );
+			cpsr = disable_interrupts();
+			glPtCommitted = i;
+			if ( glPtSent >= i ) {
+				glPtState = ( i == 0 ) ? PRETRIG_FAILED : PRETRIG_DONE;
+			}
+			restore_interrupts( cpsr );
+			break;
+		}
+	}
+}
+
+void CyFxPretrigCancel( void )
+{
+	uint32_t cpsr;
+
+	cpsr = disable_interrupts();
+	if ( glPtState == PRETRIG_FILLING || glPtState == PRETRIG_TRIGGERED ||
+			glPtState == PRETRIG_FROZEN || glPtState == PRETRIG_UPLOADING ) {
+		glPtState = PRETRIG_ABORTED;
+	}
+	restore_interrupts( cpsr );
+}
+
+void CyFxPretrigGetStatus( PretrigStatus_t* status )
+{
+	CyU3PMemSet( (uint8_t*)status, 0, sizeof( PretrigStatus_t ) );
+	status->state        = glPtState;
+	status->buf_size     = glPtBufSize;
+	status->buf_count    = glPtBufCount;
+	status->pre_bufs     = glPtPreBufs;
+	status->tail_bufs    = glPtTailBufs;
+	status->discarded    = glPtDiscarded;
+	status->fire_time_ms = glPtFireTime;
+	status->sent_bufs    = glPtSent;
+	status->upload_bytes = (uint32_t)( glPtPreBufs + glPtTailBufs ) * glPtBufSize;
+}
@@ -0,0 +1,33 @@
+#ifndef PRETRIG_CAPTURE_H_
+#define PRETRIG_CAPTURE_H_
+
+#include <cyu3types.h>
+#include <cyu3dma.h>
+#include "host_commands.h"
+
+/* Callback of the MANUAL_MANY_TO_ONE stream channel in pre-trigger mode. */
+void CyFxPretrigDmaCb( CyU3PDmaMultiChannel* chHandle, CyU3PDmaCbType_t type, CyU3PDmaCBInput_t* input );
+
+/* Start filling the ring of a freshly armed channel of bufCount buffers
+ * over all producer sockets. tailBufs buffers are kept free for the
+ * post-trigger tail, 1 .. bufCount - 2. */
+CyU3PReturnStatus_t CyFxPretrigPrepare( CyU3PDmaMultiChannel* chHandle, uint16_t tailBufs,
+		uint16_t bufSize, uint16_t bufCount );
+
+/* Freeze the pre-trigger window and start collecting the tail. Any context.
+ * Returns the upload offset of the buffer being filled at the trigger, the
+ * first byte of the tail. */
+uint32_t CyFxPretrigFire( void );
+
+/* GPIF overflowed. Returns CyTrue when the capture is still filling its
+ * window and may be restarted on a re-armed channel. */
+CyBool_t CyFxPretrigOverflow( void );
+
+/* Hand the frozen window and tail to the USB consumer. GPIF must be stopped. */
+void CyFxPretrigUpload( void );
+
+void CyFxPretrigCancel( void );
+
+void CyFxPretrigGetStatus( PretrigStatus_t* status );
+
+#endif /* PRETRIG_CAPTURE_H_ */
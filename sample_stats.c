@@ -0,0 +1,132 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+
+#include "its_sample_format.h"
+#include "sample_stats.h"
+#include "stream_tap.h"
+
+/*
+ * Sample statistics of the running stream, read through the stream tap
+ * from the buffers waiting for USB. The stream channel stays AUTO.
+ *
+ * The inner loop only counts byte values and sign changes. Per channel
+ * histograms, sums and zero crossings are folded from those per buffer.
+ */
+
+/* Sign change mask (b ^ prev) & 0xAA, shifted right by one. */
+#define CY_FX_STATS_XING_BINS    (0x55 + 1)
+
+static CyU3PMutex glStatsLock;
+static SampleStats_t glStats;
+static uint16_t glStatsByteHist[ 256 ];
+static uint16_t glStatsXingHist[ CY_FX_STATS_XING_BINS ];
+static uint16_t glStatsLastIndex = 0xFFFF;  /* Descriptor sampled last */
+
+void CyFxStatsInit( void )
+{
+	CyU3PMutexCreate( &glStatsLock, CYU3P_INHERIT );
+	CyU3PMemSet( (uint8_t*)&glStats, 0, sizeof( glStats ) );
+}
+
+void CyFxStatsStart( uint16_t buffers )
+{
+	CyU3PMutexGet( &glStatsLock, CYU3P_WAIT_FOREVER );
+	CyU3PMemSet( (uint8_t*)&glStats, 0, sizeof( glStats ) );
+	glStats.requested = buffers;
+	glStats.state = ( buffers > 0 ) ? STATS_RUNNING : STATS_IDLE;
+	glStatsLastIndex = 0xFFFF;
+	CyU3PMutexPut( &glStatsLock );
+}
+
+CyBool_t CyFxStatsActive( void )
+{
+	return ( glStats.state == STATS_RUNNING );
+}
+
+static void CyFxStatsCount( const uint8_t* buf, uint32_t len )
+{
+	uint32_t i;
+	uint8_t prev = buf[ 0 ];
+	uint8_t b;
+
+	CyU3PMemSet( (uint8_t*)glStatsByteHist, 0, sizeof( glStatsByteHist ) );
+	CyU3PMemSet( (uint8_t*)glStatsXingHist, 0, sizeof( glStatsXingHist ) );
+
+	for ( i = 0; i < len; i++ ) {
+		b = buf[ i ];
+		glStatsByteHist[ b ]++;
+		glStatsXingHist[ ( ( b ^ prev ) & 0xAA ) >> 1 ]++;
+		prev = b;
+	}
+}
+
+static void CyFxStatsFold( uint32_t len )
+{
+	uint32_t i, ch, n, code;
+
+	for ( i = 0; i < 256; i++ ) {
+		n = glStatsByteHist[ i ];
+		if ( n == 0 )
+			continue;
+		for ( ch = 0; ch < ITS_SAMPLE_CHANNELS; ch++ ) {
+			code = ITS_SAMPLE_CODE( i, ch );
+			glStats.hist[ ch ][ code ] += n;
+			glStats.sum[ ch ] += ITS_SAMPLE_VALUE( code ) * (int32_t)n;
+		}
+	}
+
+	for ( i = 1; i < CY_FX_STATS_XING_BINS; i++ ) {
+		n = glStatsXingHist[ i ];
+		if ( n == 0 )
+			continue;
+		for ( ch = 0; ch < ITS_SAMPLE_CHANNELS; ch++ ) {
+			if ( i & ( 1 << ( ITS_SAMPLE_BITS * ch ) ) )
+				glStats.crossings[ ch ] += n;
+		}
+	}
+
+	glStats.samples += len;
+	glStats.buffers++;
+	if ( glStats.buffers >= glStats.requested )
+		glStats.state = STATS_DONE;
+}
+
+void CyFxStatsPoll( uint16_t sckId )
+{
+	StreamTap_t tap;
+	uint32_t len;
+
+	if ( glStats.state != STATS_RUNNING )
+		return;
+
+	/* Nothing waiting, or still the buffer sampled last time. */
+	if ( !CyFxStreamTapPeek( sckId, glStatsLastIndex, &tap ) ) {
+		glStats.idle++;
+		return;
+	}
+	len = tap.count;
+	if ( len > CY_FX_STATS_SAMPLE_BYTES )
+		len = CY_FX_STATS_SAMPLE_BYTES;
+
+	CyFxStatsCount( tap.buffer, len );
+
+	if ( !CyFxStreamTapValid( sckId, &tap ) ) {
+		glStats.dropped++;
+		return;
+	}
+	glStatsLastIndex = tap.index;
+
+	CyU3PMutexGet( &glStatsLock, CYU3P_WAIT_FOREVER );
+	if ( glStats.state == STATS_RUNNING )
+		CyFxStatsFold( len );
+	CyU3PMutexPut( &glStatsLock );
+}
+
+void CyFxStatsGetStatus( SampleStats_t* status )
+{
+	CyU3PMutexGet( &glStatsLock, CYU3P_WAIT_FOREVER );
+	*status = glStats;
+	CyU3PMutexPut( &glStatsLock );
+}
@@ -0,0 +1,23 @@
+#ifndef SAMPLE_STATS_H_
+#define SAMPLE_STATS_H_
+
+#include <cyu3types.h>
+#include "host_commands.h"
+
+#define CY_FX_STATS_SAMPLE_BYTES  (4096)   /* Bytes read from each sampled buffer */
+#define CY_FX_STATS_PERIOD_MS     (10)     /* Application loop period while sampling */
+
+void CyFxStatsInit( void );
+
+/* Clear the statistics and sample the next 'buffers' DMA buffers, 0 stops. */
+void CyFxStatsStart( uint16_t buffers );
+
+CyBool_t CyFxStatsActive( void );
+
+/* Sample the buffer waiting on consumer socket sckId, if there is one.
+ * The caller keeps the channel from being reset or destroyed meanwhile. */
+void CyFxStatsPoll( uint16_t sckId );
+
+void CyFxStatsGetStatus( SampleStats_t* status );
+
+#endif /* SAMPLE_STATS_H_ */
@@ -0,0 +1,86 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+
+#include "cyfxslfifosync.h"
+#include "stream_flush.h"
+
+/*
+ * Latency bound for slow streams.
+ *
+ * GPIF commits a DMA buffer when it is full, at a low sample rate that
+ * takes long and the first samples in it wait all that time. A buffer
+ * GPIF is writing cannot be committed without stopping GPIF, which loses
+ * the samples of the stop, so the buffers are made to fill in time
+ * instead: with a deadline the plain stream channel gets buffers of
+ * deadline x stream rate bytes. The data counter limit follows the buffer
+ * size (CyFxGpifBufferSize), GPIF switches threads at every
+ * buffer end as with full buffers and no sample is lost.
+ *
+ * The size is rounded down to 16 bytes and kept off the USB packet sizes,
+ * so every buffer ends in a short packet and completes the host transfer
+ * it lands in, whatever the transfer size. The firmware does not know the
+ * front-end clock, the rate comes from the host with the deadline.
+ * Streams fast enough to fill a full buffer within the deadline keep full
+ * buffers.
+ */
+
+#define CY_FX_FLUSH_ALIGN    (16)   /* DMA buffer size granularity */
+#define CY_FX_FLUSH_PACKET   (64)   /* Divides the bulk packet size at every speed */
+
+static uint16_t glFlushDeadline = 0;
+static uint16_t glFlushRate = 0;            /* kB/s */
+static uint32_t glFlushBufferSize = 0;      /* Of the plain stream channel, 0 none */
+
+CyU3PReturnStatus_t CyFxFlushDeadline( uint16_t ms, uint16_t rateKbps )
+{
+	if ( ms != 0 && ( ms < FLUSH_DEADLINE_MIN_MS || ms > FLUSH_DEADLINE_MAX_MS || rateKbps == 0 ) )
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+
+	glFlushDeadline = ms;
+	glFlushRate = ms ? rateKbps : 0;
+	return CY_U3P_SUCCESS;
+}
+
+uint32_t CyFxFlushBufferSize( uint32_t size )
+{
+	uint32_t bytes;
+
+	if ( glFlushDeadline == 0 )
+		return size;
+	/* kB/s x ms */
+	bytes = (uint32_t)glFlushRate * glFlushDeadline;
+	if ( bytes >= size )
+		return size;
+
+	bytes -= bytes % CY_FX_FLUSH_ALIGN;
+	if ( bytes % CY_FX_FLUSH_PACKET == 0 )
+		bytes -= CY_FX_FLUSH_ALIGN;
+	if ( bytes < CY_FX_FLUSH_ALIGN )
+		bytes = CY_FX_FLUSH_ALIGN;
+	return bytes;
+}
+
+void CyFxFlushSetChannel( uint32_t size )
+{
+	glFlushBufferSize = size;
+}
+
+uint32_t CyFxFlushGetChannel( void )
+{
+	return glFlushBufferSize;
+}
+
+void CyFxFlushGetStatus( FlushStatus_t* status )
+{
+	uint64_t offset;
+	uint32_t streamId;
+
+	CyU3PMemSet( (uint8_t*)status, 0, sizeof( FlushStatus_t ) );
+	status->supported = 1;
+	status->deadline_ms = glFlushDeadline;
+	status->rate_kbps = glFlushRate;
+	status->buffer_bytes = glFlushBufferSize;
+	status->active = ( glFlushDeadline != 0 && glFlushBufferSize != 0 &&
+			CyFxStreamPosition( &offset, &streamId ) );
+}
@@ -0,0 +1,23 @@
+#ifndef STREAM_FLUSH_H_
+#define STREAM_FLUSH_H_
+
+#include <cyu3types.h>
+#include "host_commands.h"
+
+/* CMD_FLUSH_DEADLINE: deadline in ms, 0 is off, and the stream rate in
+ * kB/s. Only checks and keeps them, the channel follows with
+ * CyFxFlushBufferSize. */
+CyU3PReturnStatus_t CyFxFlushDeadline( uint16_t ms, uint16_t rateKbps );
+
+/* Buffer size of the plain stream channel for buffers of size bytes
+ * without a deadline. */
+uint32_t CyFxFlushBufferSize( uint32_t size );
+
+/* Buffer size of the plain stream channel in use, 0 while the channel is
+ * in another mode or gone. Set with every channel switch. */
+void CyFxFlushSetChannel( uint32_t size );
+uint32_t CyFxFlushGetChannel( void );
+
+void CyFxFlushGetStatus( FlushStatus_t* status );
+
+#endif /* STREAM_FLUSH_H_ */
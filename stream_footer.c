@@ -0,0 +1,126 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+
+#include "stream_footer.h"
+#include "footer_sum.h"
+
+/*
+ * Check sum footers on the stream.
+ *
+ * In footer mode the stream channel is MANUAL_MANY_TO_ONE with a producer
+ * footer reserved in every buffer, and the GPIF data counter is set for
+ * the payload in front of it. This thread takes every buffer GPIF fills,
+ * sums the payload in place, writes the footer behind it and commits
+ * payload and footer to EP 0x81. A buffer keeps its full size, so the
+ * USB bursts stay full.
+ *
+ * This is a RAM-to-host check. The sums are Fletcher sums the CPU takes
+ * after GPIF wrote the buffer, not the CRC of the GPIF block, so they
+ * cover what the host gets from FX3 RAM on. A host mismatch is corruption
+ * between FX3 RAM and the application, while bus errors between the
+ * front end and GPIF show up in the samples under a good footer.
+ *
+ * The CPU reads every payload byte once. The rate the ARM926 sustains
+ * that way has not been measured on a device; when it falls behind the
+ * front end, GPIF runs out of buffers and the stream overflows as in the
+ * decimator mode. Read it with itsverify -u, the loopback rate is only
+ * its link model.
+ *
+ * glFooterLock is held while a buffer is in the hands of the thread, so
+ * CyFxFooterStop returns only after the current buffer is done.
+ */
+
+#define CY_FX_FOOTER_EVT_RUN   (1 << 0)
+#define CY_FX_FOOTER_WAIT_MS   (10)
+
+static CyU3PThread glFooterThread;
+static CyU3PMutex  glFooterLock;
+static CyU3PEvent  glFooterEvent;
+static CyU3PDmaMultiChannel* glFooterChannel = NULL;
+
+static uint32_t glFooterSequence = 0;
+static uint32_t glFooterBuffers = 0;
+static uint32_t glFooterErrors = 0;
+static uint64_t glFooterBytes = 0;
+
+static void CyFxFooterThreadEntry( uint32_t input )
+{
+	CyU3PDmaBuffer_t buf;
+	StreamFooter_t* footer;
+	FooterSum_t sum;
+	uint32_t flags;
+
+	for ( ;; ) {
+		CyU3PMutexGet( &glFooterLock, CYU3P_WAIT_FOREVER );
+		if ( glFooterChannel == NULL ) {
+			CyU3PMutexPut( &glFooterLock );
+			CyU3PEventGet( &glFooterEvent, CY_FX_FOOTER_EVT_RUN, CYU3P_EVENT_OR_CLEAR, &flags, CYU3P_WAIT_FOREVER );
+			continue;
+		}
+
+		if ( CyU3PDmaMultiChannelGetBuffer( glFooterChannel, &buf, CY_FX_FOOTER_WAIT_MS ) == CY_U3P_SUCCESS ) {
+			/* The footer lies in the reserved area behind the payload. */
+			sum.a = 0;
+			sum.b = 0;
+			CyFxFooterSum( &sum, buf.buffer, buf.count & ~3u );
+			footer = (StreamFooter_t*)( buf.buffer + buf.count );
+			footer->sequence = glFooterSequence++;
+			footer->bytes = buf.count;
+			footer->magic = STREAM_FOOTER_MAGIC;
+			footer->sum_a = sum.a;
+			footer->sum_b = sum.b;
+			if ( CyU3PDmaMultiChannelCommitBuffer( glFooterChannel, buf.count + STREAM_FOOTER_SIZE, 0 ) != CY_U3P_SUCCESS ) {
+				glFooterErrors++;
+			}
+			glFooterBuffers++;
+			glFooterBytes += buf.count;
+		}
+		CyU3PMutexPut( &glFooterLock );
+	}
+}
+
+void CyFxFooterInit( void )
+{
+	void* ptr;
+
+	CyU3PMutexCreate( &glFooterLock, CYU3P_INHERIT );
+	CyU3PEventCreate( &glFooterEvent );
+
+	ptr = CyU3PMemAlloc( CY_FX_FOOTER_THREAD_STACK );
+	if ( CyU3PThreadCreate( &glFooterThread, "23:Footer", CyFxFooterThreadEntry, 0, ptr,
+			CY_FX_FOOTER_THREAD_STACK, CY_FX_FOOTER_THREAD_PRIORITY, CY_FX_FOOTER_THREAD_PRIORITY,
+			CYU3P_NO_TIME_SLICE, CYU3P_AUTO_START ) != 0 ) {
+		/* Application cannot continue */
+		while ( 1 );
+	}
+}
+
+CyU3PReturnStatus_t CyFxFooterStart( CyU3PDmaMultiChannel* chHandle, CyBool_t restart )
+{
+	CyU3PMutexGet( &glFooterLock, CYU3P_WAIT_FOREVER );
+	if ( restart )
+		glFooterSequence = 0;
+	glFooterChannel = chHandle;
+	CyU3PMutexPut( &glFooterLock );
+
+	CyU3PEventSet( &glFooterEvent, CY_FX_FOOTER_EVT_RUN, CYU3P_EVENT_OR );
+	return CY_U3P_SUCCESS;
+}
+
+void CyFxFooterStop( void )
+{
+	CyU3PMutexGet( &glFooterLock, CYU3P_WAIT_FOREVER );
+	glFooterChannel = NULL;
+	CyU3PMutexPut( &glFooterLock );
+}
+
+void CyFxFooterGetStatus( FooterStatus_t* status )
+{
+	CyU3PMemSet( (uint8_t*)status, 0, sizeof( FooterStatus_t ) );
+	status->active  = ( glFooterChannel != NULL );
+	status->buffers = glFooterBuffers;
+	status->errors  = glFooterErrors;
+	status->bytes   = glFooterBytes;
+}
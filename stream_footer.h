@@ -0,0 +1,24 @@
+#ifndef STREAM_FOOTER_H_
+#define STREAM_FOOTER_H_
+
+#include <cyu3types.h>
+#include <cyu3dma.h>
+#include "host_commands.h"
+
+#define CY_FX_FOOTER_THREAD_STACK     (0x400)   /* Footer thread stack size */
+#define CY_FX_FOOTER_THREAD_PRIORITY  (7)       /* Above the application thread */
+
+/* Create the footer thread. Call once from CyFxApplicationDefine. */
+void CyFxFooterInit( void );
+
+/* Footer the buffers of a MANUAL_MANY_TO_ONE channel with a producer
+ * footer of STREAM_FOOTER_SIZE, armed and idle. The sequence restarts
+ * at 0 when restart is set. */
+CyU3PReturnStatus_t CyFxFooterStart( CyU3PDmaMultiChannel* chHandle, CyBool_t restart );
+
+/* Returns when the footer thread no longer touches the channel. */
+void CyFxFooterStop( void );
+
+void CyFxFooterGetStatus( FooterStatus_t* status );
+
+#endif /* STREAM_FOOTER_H_ */
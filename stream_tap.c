@@ -0,0 +1,51 @@
+#include "cyu3system.h"
+#include "cyu3dma.h"
+#include "cyu3error.h"
+
+#include "stream_tap.h"
+
+/*
+ * A buffer marked occupied on the descriptor the USB consumer socket is
+ * on is complete, and GPIF cannot write it before USB has sent it. It is
+ * read in place. If the socket has moved on by the end of the read, the
+ * buffer may have been refilled and the caller drops what it read. The
+ * data cache is off, so no cache maintenance is needed.
+ */
+
+/* DMA descriptor and socket register fields, see the FX3 TRM. */
+#define CY_FX_DSCR_OCCUPIED      (0x00000001)
+#define CY_FX_DSCR_COUNT_POS     (16)
+#define CY_FX_SCK_DSCR_MASK      (0x0000FFFF)
+
+static CyBool_t CyFxStreamTapIndex( uint16_t sckId, uint16_t* index )
+{
+	CyU3PDmaSocketConfig_t sck;
+
+	if ( CyU3PDmaSocketGetConfig( sckId, &sck ) != CY_U3P_SUCCESS )
+		return CyFalse;
+	*index = (uint16_t)( sck.dscrChain & CY_FX_SCK_DSCR_MASK );
+	return CyTrue;
+}
+
+CyBool_t CyFxStreamTapPeek( uint16_t sckId, uint16_t skipIndex, StreamTap_t* tap )
+{
+	CyU3PDmaDescriptor_t dscr;
+
+	if ( !CyFxStreamTapIndex( sckId, &tap->index ) || tap->index == skipIndex )
+		return CyFalse;
+	if ( CyU3PDmaDscrGetConfig( tap->index, &dscr ) != CY_U3P_SUCCESS )
+		return CyFalse;
+	if ( ( dscr.size & CY_FX_DSCR_OCCUPIED ) == 0 )
+		return CyFalse;
+
+	tap->buffer = dscr.buffer;
+	tap->count = dscr.size >> CY_FX_DSCR_COUNT_POS;
+	return ( tap->count > 0 );
+}
+
+CyBool_t CyFxStreamTapValid( uint16_t sckId, const StreamTap_t* tap )
+{
+	uint16_t index;
+
+	return ( CyFxStreamTapIndex( sckId, &index ) && index == tap->index );
+}
@@ -0,0 +1,24 @@
+#ifndef STREAM_TAP_H_
+#define STREAM_TAP_H_
+
+#include <cyu3types.h>
+
+/*
+ * Read-only access to the stream buffers of an AUTO channel. The caller
+ * keeps the channel from being reset or destroyed meanwhile.
+ */
+
+typedef struct StreamTap_t {
+	uint8_t* buffer;
+	uint32_t count;    /* Valid bytes in buffer */
+	uint16_t index;    /* Descriptor of the buffer */
+} StreamTap_t;
+
+/* Find the complete buffer waiting on consumer socket sckId. Returns
+ * CyFalse if the socket has no buffer or is still on skipIndex. */
+CyBool_t CyFxStreamTapPeek( uint16_t sckId, uint16_t skipIndex, StreamTap_t* tap );
+
+/* CyTrue if the buffer was not released while it was read. */
+CyBool_t CyFxStreamTapValid( uint16_t sckId, const StreamTap_t* tap );
+
+#endif /* STREAM_TAP_H_ */
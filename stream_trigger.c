@@ -0,0 +1,196 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include <cyu3gpio.h>
+
+#include "cyfxslfifosync.h"
+#include "cyfxspi_bb.h"
+#include "cpsr_utils.h"
+#include "stream_trigger.h"
+#include "pretrig_capture.h"
+
+/*
+ * Armed start on an external trigger.
+ *
+ * Boards of an antenna array share one trigger line. The host arms every
+ * board with CMD_STREAM_ARM, which leaves the DMA channel ready and GPIF
+ * stopped, then fires the trigger. The GPIO interrupt starts the GPIF state
+ * machine directly, the rest of the bookkeeping is done later by the
+ * application thread.
+ *
+ * GPIF starts after the GPIO interrupt latency, which differs from board
+ * to board and from edge to edge: a few microseconds when the CPU is free,
+ * as long as the longest interrupt handler or interrupts-off section when
+ * it is not. So the latency is measured rather than relied on. TRIGGER_IN
+ * is a complex GPIO whose timer runs on the GPIO fast clock, system clock
+ * / 2 as CyFxGpioInit sets it. The armed pin latches the timer at the
+ * edge, the interrupt samples it again just before it starts GPIF, and
+ * delay_ticks is the difference. The first sample of the stream, at
+ * sample_index 0, was taken delay_ticks after the edge plus the time
+ * CyU3PGpifSMStart takes to reach the hardware, which is the same on
+ * every board running this image. Boards sharing the trigger line align their streams to
+ * one tick, about 5 ns, by their delays and the sample rate.
+ *
+ * With TRIGGER_ACTION_FIRE the same edge fires a running pre-trigger
+ * capture instead, see pretrig_capture.c. sample_index is then the upload
+ * offset of the buffer GPIF was filling, exact to one DMA buffer, and
+ * delay_ticks how long before the fire the edge came.
+ */
+
+#define CY_FX_TRIGGER_CLK_DIV  (2)     /* gpioClock.fastClkDiv in CyFxGpioInit */
+
+static volatile CyBool_t glTrigArmed = CyFalse;
+static volatile CyBool_t glTrigPending = CyFalse;   /* Fired, not yet completed */
+static volatile CyU3PReturnStatus_t glTrigStartStatus = CY_U3P_SUCCESS;
+static volatile uint32_t glTrigTime = 0;
+static volatile uint32_t glTrigDelay = TRIGGER_DELAY_UNKNOWN;
+static uint8_t  glTrigEdge = TRIGGER_EDGE_NONE;
+static uint8_t  glTrigAction = TRIGGER_ACTION_START;
+static CyBool_t glTrigFired = CyFalse;
+static uint32_t glTrigCount = 0;
+static uint32_t glTrigStartErrors = 0;
+static uint64_t glTrigSampleIndex = 0;
+
+/* TRIGGER_IN is a complex GPIO, its timer always runs so that a measuring
+ * pin mode can latch it at the edge. */
+static CyU3PReturnStatus_t CyFxTriggerPinConfig( CyU3PGpioComplexMode_t pinMode, CyU3PGpioIntrMode_t intrMode )
+{
+	CyU3PGpioComplexConfig_t gpioConfig;
+
+	CyU3PMemSet( (uint8_t*)&gpioConfig, 0, sizeof( gpioConfig ) );
+	gpioConfig.outValue = CyFalse;
+	gpioConfig.driveLowEn = CyFalse;
+	gpioConfig.driveHighEn = CyFalse;
+	gpioConfig.inputEn = CyTrue;
+	gpioConfig.pinMode = pinMode;
+	gpioConfig.intrMode = intrMode;
+	gpioConfig.timerMode = CY_U3P_GPIO_TIMER_HIGH_FREQ;
+	gpioConfig.timer = 0;
+	gpioConfig.period = 0xFFFFFFFF;
+	gpioConfig.threshold = 0xFFFFFFFF;
+	return CyU3PGpioSetComplexConfig( TRIGGER_IN, &gpioConfig );
+}
+
+void CyFxTriggerInit( void )
+{
+	CyU3PReturnStatus_t apiRetStatus;
+
+	apiRetStatus = CyFxTriggerPinConfig( CY_U3P_GPIO_MODE_STATIC, CY_U3P_GPIO_NO_INTR );
+	if ( apiRetStatus != CY_U3P_SUCCESS ) {
+		CyU3PDebugPrint( 4, "TRIGGER_IN CyU3PGpioSetComplexConfig failed, error code = %d\n", apiRetStatus );
+	}
+}
+
+CyU3PReturnStatus_t CyFxTriggerArm( uint8_t edge, uint8_t action )
+{
+	CyU3PGpioComplexMode_t pinMode;
+	CyU3PGpioIntrMode_t intrMode;
+
+	if ( edge == TRIGGER_EDGE_RISING ) {
+		pinMode = CY_U3P_GPIO_MODE_MEASURE_POS_ONCE;
+		intrMode = CY_U3P_GPIO_INTR_POS_EDGE;
+	} else if ( edge == TRIGGER_EDGE_FALLING ) {
+		pinMode = CY_U3P_GPIO_MODE_MEASURE_NEG_ONCE;
+		intrMode = CY_U3P_GPIO_INTR_NEG_EDGE;
+	} else {
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+
+	glTrigEdge = edge;
+	glTrigAction = action;
+	glTrigFired = CyFalse;
+	glTrigSampleIndex = 0;
+	glTrigDelay = TRIGGER_DELAY_UNKNOWN;
+	glTrigArmed = CyTrue;
+
+	return CyFxTriggerPinConfig( pinMode, intrMode );
+}
+
+void CyFxTriggerDisarm( void )
+{
+	uint32_t cpsr;
+
+	if ( glTrigEdge == TRIGGER_EDGE_NONE ) {
+		return;
+	}
+
+	cpsr = disable_interrupts();
+	glTrigArmed = CyFalse;
+	glTrigPending = CyFalse;
+	restore_interrupts( cpsr );
+
+	CyFxTriggerPinConfig( CY_U3P_GPIO_MODE_STATIC, CY_U3P_GPIO_NO_INTR );
+	glTrigEdge = TRIGGER_EDGE_NONE;
+}
+
+void CyFxTriggerIsr( void )
+{
+	uint32_t streamId;
+	uint32_t edge, now;
+
+	if ( !glTrigArmed ) {
+		return;
+	}
+	glTrigArmed = CyFalse;
+
+	/* Timer at the edge, then now, right before acting on it */
+	if ( CyU3PGpioComplexWaitForCompletion( TRIGGER_IN, &edge, CyFalse ) == CY_U3P_SUCCESS &&
+			CyU3PGpioComplexSampleNow( TRIGGER_IN, &now ) == CY_U3P_SUCCESS ) {
+		glTrigDelay = now - edge;
+	}
+
+	if ( glTrigAction == TRIGGER_ACTION_FIRE ) {
+		glTrigSampleIndex = CyFxPretrigFire();
+		glTrigStartStatus = CY_U3P_SUCCESS;
+	} else {
+		CyFxStreamPosition( (uint64_t*)&glTrigSampleIndex, &streamId );
+		glTrigStartStatus = CyFxGpifSMStartFromIsr();
+	}
+	glTrigTime = CyU3PGetTime();
+	glTrigPending = CyTrue;
+	CyU3PEventSet( &glAppEvent, CY_FX_APP_EVT_TRIGGER, CYU3P_EVENT_OR );
+}
+
+CyBool_t CyFxTriggerComplete( void )
+{
+	uint32_t cpsr;
+	CyBool_t pending;
+
+	cpsr = disable_interrupts();
+	pending = glTrigPending;
+	glTrigPending = CyFalse;
+	restore_interrupts( cpsr );
+
+	if ( !pending ) {
+		return CyFalse;
+	}
+
+	CyFxTriggerPinConfig( CY_U3P_GPIO_MODE_STATIC, CY_U3P_GPIO_NO_INTR );
+	glTrigEdge = TRIGGER_EDGE_NONE;
+
+	if ( glTrigStartStatus != CY_U3P_SUCCESS ) {
+		CyU3PDebugPrint( 4, "Triggered CyU3PGpifSMStart failed, Error Code = %d\n", glTrigStartStatus );
+		glTrigStartErrors++;
+		return CyFalse;
+	}
+	glTrigFired = CyTrue;
+	glTrigCount++;
+	return ( glTrigAction == TRIGGER_ACTION_START );
+}
+
+void CyFxTriggerGetStatus( TriggerStatus_t* status )
+{
+	uint32_t sysHz;
+
+	CyU3PMemSet( (uint8_t*)status, 0, sizeof( TriggerStatus_t ) );
+	status->armed        = (uint8_t)glTrigArmed;
+	status->edge         = glTrigEdge;
+	status->fired        = (uint8_t)glTrigFired;
+	status->fire_time_ms = glTrigTime;
+	status->fired_count  = glTrigCount;
+	status->start_errors = glTrigStartErrors;
+	status->sample_index = glTrigSampleIndex;
+	status->delay_ticks  = glTrigDelay;
+	if ( CyU3PDeviceGetSysClkFreq( &sysHz ) == CY_U3P_SUCCESS )
+		status->tick_hz = sysHz / CY_FX_TRIGGER_CLK_DIV;
+}
@@ -0,0 +1,29 @@
+#ifndef STREAM_TRIGGER_H_
+#define STREAM_TRIGGER_H_
+
+#include <cyu3types.h>
+#include "host_commands.h"
+
+/* Configure the trigger pin as a plain input. Called from CyFxGpioInit. */
+void CyFxTriggerInit( void );
+
+/* What the edge does */
+#define TRIGGER_ACTION_START ( 0 )  /* Start GPIF, stream stopped and DMA channel armed */
+#define TRIGGER_ACTION_FIRE  ( 1 )  /* Fire the running pre-trigger capture */
+
+/* Enable the edge interrupt, one of TRIGGER_EDGE_RISING/FALLING. */
+CyU3PReturnStatus_t CyFxTriggerArm( uint8_t edge, uint8_t action );
+
+/* Mask the trigger and drop a trigger not yet taken by CyFxTriggerComplete. */
+void CyFxTriggerDisarm( void );
+
+/* GPIO interrupt handler for TRIGGER_IN. Interrupt context. */
+void CyFxTriggerIsr( void );
+
+/* Finish a fired trigger in thread context. Returns CyTrue when the ISR
+ * started the GPIF state machine with TRIGGER_ACTION_START. */
+CyBool_t CyFxTriggerComplete( void );
+
+void CyFxTriggerGetStatus( TriggerStatus_t* status );
+
+#endif /* STREAM_TRIGGER_H_ */
@@ -0,0 +1,215 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+
+#include "cpsr_utils.h"
+#include "usb_err_stats.h"
+
+/*
+ * Background sampler of USB 3.0 PHY/LINK error counters.
+ *
+ * The hardware counters are 16 bit, saturate and are cleared by the SDK
+ * timer, so they have to be read often. A ThreadX timer reads them every
+ * USB_ERR_SAMPLE_PERIOD_MS, accumulates the deltas into 64 bit totals and
+ * once per second pushes the per-second deltas into a small history ring.
+ * The host reads a snapshot with CMD_READ_USB_ERRORS at its own pace.
+ */
+
+static CyU3PTimer glUsbErrTimer;
+
+static uint64_t glPhyTotal = 0;
+static uint64_t glLnkTotal = 0;
+static uint32_t glSeconds  = 0;
+
+static uint32_t glPhyThisSec = 0;
+static uint32_t glLnkThisSec = 0;
+static uint32_t glSamplesThisSec = 0;
+
+static uint32_t glPhyHistory[ USB_ERR_HISTORY_LEN ];
+static uint32_t glLnkHistory[ USB_ERR_HISTORY_LEN ];
+static uint32_t glHistoryHead = 0;   /* Next slot to write */
+static uint32_t glHistoryLen  = 0;
+
+/*
+ * NB! FX3 firmware (at least versions 1.2.2 and 1.2.3 and 1.3.1) clears hardware
+ * Error Counter Register periodically in timer interrupt, specifically in
+ * CyU3PUibLnkErrClrTimerCb function.
+ * Also CyU3PUsbGetErrorCounts implementation itself clears the same hardware
+ * register, causing this way concurrency between hardware and software updating
+ * the same register. As a result, if both HW and SW update the register
+ * concurrently, one of the operations has no effect on content of register.
+ *
+ * Function below is free of CyU3PUsbGetErrorCounts flaw. Unfortunately its
+ * not possible to avoid hardware register clearing in timer interrupt, but
+ * assuming that MyU3PUsbGetErrorCounts function is called frequently enough,
+ * hopefully still a better accuracy can be achieved.
+ *
+ * Note 1. MyU3PUsbGetErrorCounts function is not multi-thread safe (as also
+ *       CyU3PUsbGetErrorCounts is not). It must only be called from
+ *       CyFxUsbErrTimerCb below.
+ */
+static CyU3PReturnStatus_t MyU3PUsbGetErrorCounts(uint16_t *phy_err_cnt, uint16_t *lnk_err_cnt)
+{
+	// This function does not update PHY/LINK errors register.
+	// Instead, it preserves the previous register value and
+	// calculates the changes based on previous and current counter
+	// values.
+	static uint32_t current_value=0; //NB! static variable preserves its value between function calls
+	register uint32_t previous_value;
+	register uint16_t delta;
+
+	if (!phy_err_cnt || !lnk_err_cnt)
+	{
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+
+	// Take the previous register value
+	previous_value=current_value;
+	// Read current PHY/LINK errors register value (address 0xe0033000+20)
+    // bits 16...31 - PHY  errors
+    // bits  0...15 - LINK errors
+	{
+		// CPU and USB state machine are in separate clock domains
+		// and therefore CPU can see any arbitrary value when
+		// USB state machine updates the register at the same moment.
+		// Let's assume that if three read operations return
+        // equal values then it must be correct value - it's
+        // very very unlikely that it's not.
+		register uint32_t r[3];
+		r[0]=*(volatile uint32_t *)(0xe0033000+20);
+		r[1]=*(volatile uint32_t *)(0xe0033000+20);
+		r[2]=*(volatile uint32_t *)(0xe0033000+20);
+		if (r[0]==r[1] && r[0]==r[2])
+		{
+			current_value=r[0];
+		}
+		else
+		{
+			// Three values were not equal.
+			// Let's try to read again but at maximal speed without any possible pauses
+			// between read operations. The assumption is that USB automata does not
+			// increment error counters very frequently and therefore we should see at
+			// least two identical values.
+			register uint32_t m=disable_interrupts();
+			r[0]=*(volatile uint32_t *)(0xe0033000+20);
+			r[1]=*(volatile uint32_t *)(0xe0033000+20);
+			r[2]=*(volatile uint32_t *)(0xe0033000+20);
+			restore_interrupts(m);
+			// Update current value depending on what the two values were identical.
+			// If there are no identical values then let's assume that
+			// "current value" is equal to "previous value" this time - hopefully next
+			// time we will have better luck.
+			if (r[0]==r[1]) current_value=r[0];
+			else if (r[1]==r[2]) current_value=r[1];
+		}
+	}
+	if (CY_U3P_SUPER_SPEED!=CyU3PUsbGetSpeed())
+	{
+		return CY_U3P_ERROR_INVALID_SEQUENCE;
+	}
+
+	// NB! According Cypress technical support information, hardware error counters saturate
+    // at value 0xFFFF (they never turn around to 0). Therefore, FX3 API needs to clear
+	// counters itself periodically (it does this typically in timer interrupt).
+
+	// NB! FX3 API version 1.3.1 clears LNK error counter but does not clear
+	//     PHY error counter in timer interrupt. Therefore we need to clear counters
+	//     ourselves if they have saturated. But as this is dangerous operation (USB
+	//     state machine may also read any arbitrary value while CPU updates register,
+	//     plus, we will lose errors that have appeared between our read and this write)
+	//     then do this only when this is needed indeed.
+	if (((current_value & 0xFFFF0000) == 0xFFFF0000) || ((current_value & 0x0000FFFF) == 0x0000FFFF))
+	{
+		*(volatile uint32_t *)(0xe0033000+20)=0;
+	}
+
+	// Calculate PHY errors increment
+	delta=(uint16_t)(current_value>>16);
+	if ((uint16_t)(previous_value>>16) <= delta)
+	{
+		delta -= (uint16_t)(previous_value>>16);
+	}
+	*phy_err_cnt=delta;
+
+	// Calculate LINK errors increment
+	delta=(uint16_t)(current_value);
+	if ((uint16_t)previous_value <= delta)
+	{
+		delta -= (uint16_t)previous_value;
+	}
+	*lnk_err_cnt=delta;
+
+	return CY_U3P_SUCCESS;
+}
+
+/* Timer callback, runs in the ThreadX timer thread every USB_ERR_SAMPLE_PERIOD_MS */
+static void CyFxUsbErrTimerCb( uint32_t arg )
+{
+	uint16_t phyerrs;
+	uint16_t lnkerrs;
+	uint32_t m;
+
+	if ( MyU3PUsbGetErrorCounts( &phyerrs, &lnkerrs ) != CY_U3P_SUCCESS ) {
+		// Not on a SuperSpeed link: nothing to count, and the partial second is dropped.
+		glSamplesThisSec = 0;
+		glPhyThisSec = 0;
+		glLnkThisSec = 0;
+		return;
+	}
+
+	m = disable_interrupts();
+	glPhyTotal += phyerrs;
+	glLnkTotal += lnkerrs;
+	glPhyThisSec += phyerrs;
+	glLnkThisSec += lnkerrs;
+	glSamplesThisSec++;
+	if ( glSamplesThisSec >= USB_ERR_SAMPLES_PER_SEC ) {
+		glPhyHistory[ glHistoryHead ] = glPhyThisSec;
+		glLnkHistory[ glHistoryHead ] = glLnkThisSec;
+		glHistoryHead = ( glHistoryHead + 1 ) % USB_ERR_HISTORY_LEN;
+		if ( glHistoryLen < USB_ERR_HISTORY_LEN ) {
+			glHistoryLen++;
+		}
+		glSeconds++;
+		glPhyThisSec = 0;
+		glLnkThisSec = 0;
+		glSamplesThisSec = 0;
+	}
+	restore_interrupts( m );
+}
+
+void CyFxUsbErrStatsInit( void )
+{
+	uint32_t status;
+
+	status = CyU3PTimerCreate( &glUsbErrTimer, CyFxUsbErrTimerCb, 0,
+			USB_ERR_SAMPLE_PERIOD_MS, USB_ERR_SAMPLE_PERIOD_MS, CYU3P_AUTO_ACTIVATE );
+	if ( status != CY_U3P_SUCCESS ) {
+		CyU3PDebugPrint( 4, "USB error sampler timer create failed, Error code = %d\n", status );
+	}
+}
+
+void CyFxUsbErrStatsGet( UsbErrorStats_t* stats )
+{
+	uint32_t m;
+	uint32_t i;
+	uint32_t first;
+
+	m = disable_interrupts();
+	stats->phy_total   = glPhyTotal;
+	stats->lnk_total   = glLnkTotal;
+	stats->seconds     = glSeconds;
+	stats->history_len = glHistoryLen;
+	first = ( glHistoryHead + USB_ERR_HISTORY_LEN - glHistoryLen ) % USB_ERR_HISTORY_LEN;
+	for ( i = 0; i < USB_ERR_HISTORY_LEN; i++ ) {
+		if ( i < glHistoryLen ) {
+			stats->phy_per_sec[ i ] = glPhyHistory[ ( first + i ) % USB_ERR_HISTORY_LEN ];
+			stats->lnk_per_sec[ i ] = glLnkHistory[ ( first + i ) % USB_ERR_HISTORY_LEN ];
+		} else {
+			stats->phy_per_sec[ i ] = 0;
+			stats->lnk_per_sec[ i ] = 0;
+		}
+	}
+	restore_interrupts( m );
+}
@@ -0,0 +1,18 @@
+#ifndef USB_ERR_STATS_H_
+#define USB_ERR_STATS_H_
+
+#include <cyu3types.h>
+#include "host_commands.h"
+
+/* Sampling period of the PHY/LINK error counter register, ms. It must stay
+ * well below the period of the SDK timer that clears the counters. */
+#define USB_ERR_SAMPLE_PERIOD_MS ( 100 )
+#define USB_ERR_SAMPLES_PER_SEC  ( 1000 / USB_ERR_SAMPLE_PERIOD_MS )
+
+/* Create and start the periodic sampler. Call once after CyU3PUsbStart. */
+void CyFxUsbErrStatsInit( void );
+
+/* Take a consistent copy of the accumulated statistics. */
+void CyFxUsbErrStatsGet( UsbErrorStats_t* stats );
+
+#endif /* USB_ERR_STATS_H_ */
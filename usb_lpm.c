@@ -0,0 +1,146 @@
+#include "cyu3system.h"
+#include "cyu3os.h"
+#include "cyu3error.h"
+#include "cyu3usb.h"
+
+#include "cyfxslfifosync.h"
+#include "usb_lpm.h"
+
+/*
+ * U1/U2 link power management control.
+ *
+ * The host may put the SuperSpeed link into U1/U2 whenever the bulk pipe is
+ * idle for a moment. Exit from these states costs microseconds and while
+ * GPIF is streaming that is enough to overflow the P-port buffers. With
+ * LPM_POLICY_STREAMING (default) the device rejects U1/U2 entry while the
+ * GPIF is running and accepts it again once streaming is stopped.
+ *
+ * Policy and streaming changes come from the EP0 setup callback and the
+ * stream start/stop paths, some of them in callback context. They only
+ * update the state the request callback decides on and leave the SDK
+ * LPM enable to the application thread, through CY_FX_APP_EVT_LPM.
+ */
+
+static uint8_t  glLpmPolicy = LPM_POLICY_STREAMING;
+static CyBool_t glLpmStreaming = CyFalse;
+static CyBool_t glLpmDisabled = CyFalse;
+
+static volatile uint32_t glU1Requests = 0;
+static volatile uint32_t glU2Requests = 0;
+static volatile uint32_t glLpmAccepted = 0;
+static volatile uint32_t glLpmRejected = 0;
+static volatile uint32_t glSuspendCount = 0;
+static volatile uint32_t glResumeCount = 0;
+static volatile uint32_t glRecoveryCount = 0;
+static uint32_t glLpmDisableCount = 0;
+
+static CyBool_t CyFxLpmShouldReject( void )
+{
+	switch ( glLpmPolicy ) {
+	case LPM_POLICY_REJECT:
+		return CyTrue;
+	case LPM_POLICY_STREAMING:
+		return glLpmStreaming;
+	default:
+		return CyFalse;
+	}
+}
+
+/* Called by the USB driver when the host asks for U1 or U2. Must be short. */
+static CyBool_t CyFxLpmRequestCb( CyU3PUsbLinkPowerMode link_mode )
+{
+	if ( link_mode == CyU3PUsbLPM_U1 ) {
+		glU1Requests++;
+	} else if ( link_mode == CyU3PUsbLPM_U2 ) {
+		glU2Requests++;
+	}
+
+	if ( CyFxLpmShouldReject() ) {
+		glLpmRejected++;
+		return CyFalse;
+	}
+	glLpmAccepted++;
+	return CyTrue;
+}
+
+void CyFxLpmApply( void )
+{
+	CyU3PReturnStatus_t status;
+	CyBool_t reject = CyFxLpmShouldReject();
+
+	if ( reject == glLpmDisabled ) {
+		return;
+	}
+
+	if ( reject ) {
+		status = CyU3PUsbLPMDisable();
+		glLpmDisableCount++;
+	} else {
+		status = CyU3PUsbLPMEnable();
+	}
+	if ( status != CY_U3P_SUCCESS ) {
+		CyU3PDebugPrint( 4, "LPM %s failed, Error code = %d\n", reject ? "disable" : "enable", status );
+		return;
+	}
+	glLpmDisabled = reject;
+}
+
+void CyFxLpmInit( void )
+{
+	CyU3PUsbRegisterLPMRequestCallback( CyFxLpmRequestCb );
+	CyFxLpmApply();
+}
+
+CyU3PReturnStatus_t CyFxLpmSetPolicy( uint8_t policy )
+{
+	if ( policy > LPM_POLICY_REJECT ) {
+		return CY_U3P_ERROR_BAD_ARGUMENT;
+	}
+	glLpmPolicy = policy;
+	CyU3PEventSet( &glAppEvent, CY_FX_APP_EVT_LPM, CYU3P_EVENT_OR );
+	return CY_U3P_SUCCESS;
+}
+
+void CyFxLpmSetStreaming( CyBool_t streaming )
+{
+	glLpmStreaming = streaming;
+	CyU3PEventSet( &glAppEvent, CY_FX_APP_EVT_LPM, CYU3P_EVENT_OR );
+}
+
+void CyFxLpmUsbEvent( CyU3PUsbEventType_t evtype )
+{
+	switch ( evtype ) {
+	case CY_U3P_USB_EVENT_SUSPEND:
+		glSuspendCount++;
+		break;
+	case CY_U3P_USB_EVENT_RESUME:
+		glResumeCount++;
+		break;
+	case CY_U3P_USB_EVENT_LNK_RECOVERY:
+		glRecoveryCount++;
+		break;
+	default:
+		break;
+	}
+}
+
+void CyFxLpmGetStats( LpmStats_t* stats )
+{
+	CyU3PUsbLinkPowerMode mode = CyU3PUsbLPM_Unknown;
+
+	CyU3PUsbGetLinkPowerState( &mode );
+
+	CyU3PMemSet( (uint8_t*)stats, 0, sizeof( LpmStats_t ) );
+	stats->policy        = glLpmPolicy;
+	stats->streaming     = (uint8_t)glLpmStreaming;
+	stats->lpm_disabled  = (uint8_t)glLpmDisabled;
+	stats->link_state    = (uint8_t)mode;
+	stats->u1_requests   = glU1Requests;
+	stats->u2_requests   = glU2Requests;
+	stats->accepted      = glLpmAccepted;
+	stats->rejected      = glLpmRejected;
+	stats->suspends      = glSuspendCount;
+	stats->resumes       = glResumeCount;
+	stats->recoveries    = glRecoveryCount;
+	stats->disable_count = glLpmDisableCount;
+}
@@ -0,0 +1,27 @@
+#ifndef USB_LPM_H_
+#define USB_LPM_H_
+
+#include <cyu3types.h>
+#include <cyu3usb.h>
+#include "host_commands.h"
+
+/* Register the LPM request callback and apply the default policy. */
+void CyFxLpmInit( void );
+
+/* Select one of LPM_POLICY_* from host_commands.h. Any context, the
+ * SDK state follows with CyFxLpmApply. */
+CyU3PReturnStatus_t CyFxLpmSetPolicy( uint8_t policy );
+
+/* Notify the LPM control of GPIF streaming start/stop. Any context. */
+void CyFxLpmSetStreaming( CyBool_t streaming );
+
+/* Bring the SDK LPM state in line with the policy, on CY_FX_APP_EVT_LPM.
+ * Application thread only. */
+void CyFxLpmApply( void );
+
+/* Count link power related USB events. */
+void CyFxLpmUsbEvent( CyU3PUsbEventType_t evtype );
+
+void CyFxLpmGetStats( LpmStats_t* stats );
+
+#endif /* USB_LPM_H_ */